@@ -0,0 +1,54 @@
+# Link-time and profile-guided optimization for the allocator and everything
+# built with it (demo, tests, benchmarks).
+#
+#   ALLOCATOR_ENABLE_LTO  Link-time optimization, so allocator calls can be
+#                         inlined into callers across translation units.
+#   ALLOCATOR_PGO         OFF | GENERATE | USE. GENERATE instruments the build;
+#                         running the benchmarks writes profiles to
+#                         ALLOCATOR_PGO_DIR. USE rebuilds with those profiles.
+#
+# The profiles are keyed by object file path, so GENERATE and USE must be run
+# in the same build directory. cmake/AllocatorPGO.cmake automates the cycle.
+
+option(ALLOCATOR_ENABLE_LTO "Build with link-time optimization" OFF)
+
+set(ALLOCATOR_PGO "OFF" CACHE STRING "Profile-guided optimization phase")
+set_property(CACHE ALLOCATOR_PGO PROPERTY STRINGS OFF GENERATE USE)
+set(ALLOCATOR_PGO_DIR "${CMAKE_BINARY_DIR}/pgo-profile" CACHE PATH
+    "Directory holding PGO profile data")
+
+if(ALLOCATOR_ENABLE_LTO)
+    include(CheckIPOSupported)
+    check_ipo_supported(RESULT _lto_supported OUTPUT _lto_output LANGUAGES C)
+    if(NOT _lto_supported)
+        message(FATAL_ERROR "ALLOCATOR_ENABLE_LTO: LTO is not supported: ${_lto_output}")
+    endif()
+    set(CMAKE_INTERPROCEDURAL_OPTIMIZATION ON)
+endif()
+
+if(ALLOCATOR_PGO STREQUAL "GENERATE")
+    file(MAKE_DIRECTORY ${ALLOCATOR_PGO_DIR})
+    if(CMAKE_C_COMPILER_ID STREQUAL "GNU")
+        add_compile_options(-fprofile-generate=${ALLOCATOR_PGO_DIR} -fprofile-update=atomic)
+        add_link_options(-fprofile-generate=${ALLOCATOR_PGO_DIR})
+    elseif(CMAKE_C_COMPILER_ID MATCHES "Clang")
+        add_compile_options(-fprofile-instr-generate=${ALLOCATOR_PGO_DIR}/%p.profraw)
+        add_link_options(-fprofile-instr-generate=${ALLOCATOR_PGO_DIR}/%p.profraw)
+    else()
+        message(FATAL_ERROR "ALLOCATOR_PGO is only supported with GCC and Clang")
+    endif()
+elseif(ALLOCATOR_PGO STREQUAL "USE")
+    if(CMAKE_C_COMPILER_ID STREQUAL "GNU")
+        add_compile_options(-fprofile-use=${ALLOCATOR_PGO_DIR} -fprofile-correction -Wno-missing-profile)
+        add_link_options(-fprofile-use=${ALLOCATOR_PGO_DIR})
+    elseif(CMAKE_C_COMPILER_ID MATCHES "Clang")
+        # Raw profiles must be merged first:
+        #   llvm-profdata merge -o <dir>/allocator.profdata <dir>/*.profraw
+        add_compile_options(-fprofile-instr-use=${ALLOCATOR_PGO_DIR}/allocator.profdata)
+        add_link_options(-fprofile-instr-use=${ALLOCATOR_PGO_DIR}/allocator.profdata)
+    else()
+        message(FATAL_ERROR "ALLOCATOR_PGO is only supported with GCC and Clang")
+    endif()
+elseif(NOT ALLOCATOR_PGO STREQUAL "OFF")
+    message(FATAL_ERROR "Unknown ALLOCATOR_PGO '${ALLOCATOR_PGO}' (expected OFF, GENERATE or USE)")
+endif()
@@ -0,0 +1,148 @@
+# Builds the benchmark with LTO, then again with LTO + PGO trained on the
+# benchmark itself, and reports the per-workload speedup.
+#
+# Usage (from the source tree):
+#   cmake -P cmake/AllocatorPGO.cmake
+#   cmake -DBINARY_DIR=/tmp/pgo -DSCALE=10 -DREPEAT=5 -P cmake/AllocatorPGO.cmake
+#
+#   BINARY_DIR   Work directory (default: build/pgo)
+#   TRAIN_SCALE  Benchmark scale factor for the training run (default: 2)
+#   SCALE        Benchmark scale factor for the measured runs (default: 5)
+#   REPEAT       Measured runs per build; the best result is kept (default: 3)
+#   GENERATOR    CMake generator passed through to the inner builds
+#
+# Hosted builds only: the measured runs execute the benchmark directly.
+
+cmake_minimum_required(VERSION 3.16)
+
+get_filename_component(SOURCE_DIR "${CMAKE_CURRENT_LIST_DIR}/.." ABSOLUTE)
+if(NOT BINARY_DIR)
+    set(BINARY_DIR "${SOURCE_DIR}/build/pgo")
+endif()
+if(NOT TRAIN_SCALE)
+    set(TRAIN_SCALE 2)
+endif()
+if(NOT SCALE)
+    set(SCALE 5)
+endif()
+if(NOT REPEAT)
+    set(REPEAT 3)
+endif()
+
+set(BENCH bench_allocator_O3)
+set(BASE_DIR "${BINARY_DIR}/lto")
+set(PGO_DIR  "${BINARY_DIR}/lto-pgo")
+set(PROFILE_DIR "${PGO_DIR}/pgo-profile")
+
+set(GENERATOR_ARGS)
+if(GENERATOR)
+    set(GENERATOR_ARGS -G "${GENERATOR}")
+endif()
+
+function(run_step)
+    execute_process(COMMAND ${ARGN} RESULT_VARIABLE rc)
+    if(NOT rc EQUAL 0)
+        string(REPLACE ";" " " cmd "${ARGN}")
+        message(FATAL_ERROR "Command failed (${rc}): ${cmd}")
+    endif()
+endfunction()
+
+# Configures (or reconfigures) <dir> for the given PGO phase and builds BENCH.
+function(build_bench dir pgo)
+    run_step(${CMAKE_COMMAND} -S ${SOURCE_DIR} -B ${dir} ${GENERATOR_ARGS}
+        -DCMAKE_BUILD_TYPE=Release
+        -DALLOCATOR_ENABLE_LTO=ON
+        -DALLOCATOR_PGO=${pgo}
+        -DALLOCATOR_PGO_DIR=${PROFILE_DIR}
+        -DALLOCATOR_BUILD_TESTS=OFF
+        -DALLOCATOR_BUILD_DEMO=OFF)
+    run_step(${CMAKE_COMMAND} --build ${dir} --target ${BENCH})
+endfunction()
+
+# Runs the benchmark REPEAT times and sets <prefix>_<workload> in the caller
+# to the best ticks/op, in tenths (the benchmark prints one decimal).
+function(measure dir prefix)
+    set(names)
+    foreach(i RANGE 1 ${REPEAT})
+        execute_process(COMMAND ${dir}/source/bench/${BENCH} ${SCALE}
+            OUTPUT_VARIABLE out RESULT_VARIABLE rc)
+        if(NOT rc EQUAL 0)
+            message(FATAL_ERROR "${BENCH} failed in ${dir}")
+        endif()
+        string(REGEX MATCHALL "[a-z0-9_]+ +[0-9]+ ops +[0-9]+\\.[0-9]" lines "${out}")
+        foreach(line IN LISTS lines)
+            string(REGEX REPLACE "^([a-z0-9_]+) .*$" "\\1" name "${line}")
+            string(REGEX REPLACE "^.* ([0-9]+)\\.([0-9])$" "\\1\\2" tenths "${line}")
+            list(APPEND names ${name})
+            if(NOT DEFINED best_${name} OR tenths LESS best_${name})
+                set(best_${name} ${tenths})
+            endif()
+        endforeach()
+    endforeach()
+    list(REMOVE_DUPLICATES names)
+    foreach(name IN LISTS names)
+        set(${prefix}_${name} ${best_${name}} PARENT_SCOPE)
+    endforeach()
+    set(${prefix}_names ${names} PARENT_SCOPE)
+endfunction()
+
+function(format_tenths value out)
+    math(EXPR whole "${value} / 10")
+    math(EXPR frac "${value} % 10")
+    if(frac LESS 0)
+        math(EXPR frac "-${frac}")
+        if(whole EQUAL 0)
+            set(whole "-0")
+        endif()
+    endif()
+    set(${out} "${whole}.${frac}" PARENT_SCOPE)
+endfunction()
+
+# 1. Baseline: LTO only.
+message(STATUS "PGO: building LTO baseline in ${BASE_DIR}")
+build_bench(${BASE_DIR} OFF)
+
+# 2. Instrumented build, trained on the benchmark workloads.
+message(STATUS "PGO: building instrumented benchmark in ${PGO_DIR}")
+file(REMOVE_RECURSE ${PROFILE_DIR})
+build_bench(${PGO_DIR} GENERATE)
+message(STATUS "PGO: training run (scale ${TRAIN_SCALE})")
+run_step(${PGO_DIR}/source/bench/${BENCH} ${TRAIN_SCALE})
+
+file(GLOB _profraw "${PROFILE_DIR}/*.profraw")
+if(_profraw)
+    find_program(LLVM_PROFDATA NAMES llvm-profdata REQUIRED)
+    run_step(${LLVM_PROFDATA} merge -o ${PROFILE_DIR}/allocator.profdata ${_profraw})
+endif()
+
+# 3. Optimized build using the profile (same directory, so paths match).
+message(STATUS "PGO: rebuilding with profile data")
+build_bench(${PGO_DIR} USE)
+
+# 4. Compare.
+message(STATUS "PGO: measuring (scale ${SCALE}, best of ${REPEAT})")
+measure(${BASE_DIR} base)
+measure(${PGO_DIR} pgo)
+
+message("")
+message("workload          LTO         LTO+PGO     speedup")
+foreach(name IN LISTS base_names)
+    if(NOT DEFINED pgo_${name})
+        continue()
+    endif()
+    format_tenths(${base_${name}} b)
+    format_tenths(${pgo_${name}} p)
+    # Reduction in time per operation, in tenths of a percent.
+    math(EXPR gain "(${base_${name}} - ${pgo_${name}}) * 1000 / ${base_${name}}")
+    format_tenths(${gain} g)
+    string(LENGTH "${name}" n)
+    math(EXPR pad "18 - ${n}")
+    string(REPEAT " " ${pad} spaces)
+    string(LENGTH "${b}" n)
+    math(EXPR pad2 "12 - ${n}")
+    string(REPEAT " " ${pad2} spaces2)
+    string(LENGTH "${p}" n)
+    math(EXPR pad3 "12 - ${n}")
+    string(REPEAT " " ${pad3} spaces3)
+    message("${name}${spaces}${b}${spaces2}${p}${spaces3}${g}%")
+endforeach()
@@ -0,0 +1,4 @@
+# Cortex-M4F, run under QEMU as the MPS2 AN386 board.
+set(ALLOCATOR_ARM_CPU_FLAGS "-mcpu=cortex-m4 -mfloat-abi=hard -mfpu=fpv4-sp-d16")
+set(ALLOCATOR_QEMU_MACHINE  "mps2-an386")
+include(${CMAKE_CURRENT_LIST_DIR}/arm-none-eabi.cmake)
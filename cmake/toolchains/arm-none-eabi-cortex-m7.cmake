@@ -0,0 +1,4 @@
+# Cortex-M7 (double-precision FPU), run under QEMU as the MPS2 AN500 board.
+set(ALLOCATOR_ARM_CPU_FLAGS "-mcpu=cortex-m7 -mfloat-abi=hard -mfpu=fpv5-d16")
+set(ALLOCATOR_QEMU_MACHINE  "mps2-an500")
+include(${CMAKE_CURRENT_LIST_DIR}/arm-none-eabi.cmake)
@@ -0,0 +1,36 @@
+# Common settings for bare-metal Arm Cortex-M targets built with the GNU Arm
+# Embedded toolchain. Not used directly: include it from a CPU-specific file
+# after setting ALLOCATOR_ARM_CPU_FLAGS and ALLOCATOR_QEMU_MACHINE.
+
+set(CMAKE_SYSTEM_NAME Generic)
+set(CMAKE_SYSTEM_PROCESSOR arm)
+
+set(ALLOCATOR_CROSS_PREFIX "arm-none-eabi-" CACHE STRING "Cross toolchain prefix")
+set(CMAKE_C_COMPILER   ${ALLOCATOR_CROSS_PREFIX}gcc)
+set(CMAKE_ASM_COMPILER ${ALLOCATOR_CROSS_PREFIX}gcc)
+set(CMAKE_OBJCOPY      ${ALLOCATOR_CROSS_PREFIX}objcopy CACHE FILEPATH "")
+set(CMAKE_SIZE         ${ALLOCATOR_CROSS_PREFIX}size    CACHE FILEPATH "")
+
+# There is no OS to run test programs during configuration.
+set(CMAKE_TRY_COMPILE_TARGET_TYPE STATIC_LIBRARY)
+
+set(CMAKE_C_FLAGS_INIT "${ALLOCATOR_ARM_CPU_FLAGS} -mthumb -ffunction-sections -fdata-sections")
+set(CMAKE_ASM_FLAGS_INIT "${ALLOCATOR_ARM_CPU_FLAGS} -mthumb")
+set(CMAKE_EXE_LINKER_FLAGS_INIT
+    "-nostartfiles --specs=nano.specs --specs=nosys.specs -u _printf_float -Wl,--gc-sections")
+
+set(ALLOCATOR_PORT "cortex_m" CACHE STRING "Bare-metal port providing startup code")
+
+# Run test and benchmark executables on the QEMU MPS2 board model. Output and
+# exit status go through semihosting; -icount makes SysTick count retired
+# instructions so that repeated runs give identical tick counts.
+find_program(ALLOCATOR_QEMU_ARM qemu-system-arm)
+if(ALLOCATOR_QEMU_ARM)
+    set(CMAKE_CROSSCOMPILING_EMULATOR
+        ${ALLOCATOR_QEMU_ARM} -M ${ALLOCATOR_QEMU_MACHINE} -nographic
+        -semihosting-config enable=on,target=native -icount shift=0 -kernel)
+endif()
+
+set(CMAKE_FIND_ROOT_PATH_MODE_PROGRAM NEVER)
+set(CMAKE_FIND_ROOT_PATH_MODE_LIBRARY ONLY)
+set(CMAKE_FIND_ROOT_PATH_MODE_INCLUDE ONLY)
@@ -0,0 +1,39 @@
+# Bare-metal RV32 target, run under QEMU as the "virt" machine.
+#
+# Multilib riscv64-unknown-elf toolchains work as well:
+#   -DALLOCATOR_CROSS_PREFIX=riscv64-unknown-elf-
+
+set(CMAKE_SYSTEM_NAME Generic)
+set(CMAKE_SYSTEM_PROCESSOR riscv32)
+
+set(ALLOCATOR_CROSS_PREFIX "riscv32-unknown-elf-" CACHE STRING "Cross toolchain prefix")
+set(ALLOCATOR_RISCV_ARCH   "rv32imac_zicsr"       CACHE STRING "Value passed to -march")
+set(ALLOCATOR_RISCV_ABI    "ilp32"                CACHE STRING "Value passed to -mabi")
+
+set(CMAKE_C_COMPILER   ${ALLOCATOR_CROSS_PREFIX}gcc)
+set(CMAKE_ASM_COMPILER ${ALLOCATOR_CROSS_PREFIX}gcc)
+set(CMAKE_OBJCOPY      ${ALLOCATOR_CROSS_PREFIX}objcopy CACHE FILEPATH "")
+set(CMAKE_SIZE         ${ALLOCATOR_CROSS_PREFIX}size    CACHE FILEPATH "")
+
+set(CMAKE_TRY_COMPILE_TARGET_TYPE STATIC_LIBRARY)
+
+set(CMAKE_C_FLAGS_INIT
+    "-march=${ALLOCATOR_RISCV_ARCH} -mabi=${ALLOCATOR_RISCV_ABI} -mcmodel=medany -ffunction-sections -fdata-sections")
+set(CMAKE_ASM_FLAGS_INIT "-march=${ALLOCATOR_RISCV_ARCH} -mabi=${ALLOCATOR_RISCV_ABI}")
+set(CMAKE_EXE_LINKER_FLAGS_INIT
+    "-nostartfiles --specs=nano.specs --specs=nosys.specs -u _printf_float -Wl,--gc-sections")
+
+set(ALLOCATOR_PORT "riscv32" CACHE STRING "Bare-metal port providing startup code")
+
+# Output goes to the 16550 UART, which -nographic connects to stdio; the exit
+# status is reported through the SiFive test device. -icount makes mcycle
+# count retired instructions.
+find_program(ALLOCATOR_QEMU_RISCV32 qemu-system-riscv32)
+if(ALLOCATOR_QEMU_RISCV32)
+    set(CMAKE_CROSSCOMPILING_EMULATOR
+        ${ALLOCATOR_QEMU_RISCV32} -M virt -bios none -nographic -icount shift=0 -kernel)
+endif()
+
+set(CMAKE_FIND_ROOT_PATH_MODE_PROGRAM NEVER)
+set(CMAKE_FIND_ROOT_PATH_MODE_LIBRARY ONLY)
+set(CMAKE_FIND_ROOT_PATH_MODE_INCLUDE ONLY)
@@ -9,24 +9,539 @@
  * It provides a minimal public API for allocating and freeing memory without
  * relying on the C standard library (`malloc`/`free`).
  *
+ * Small requests can also go through allocate_fast()/deallocate_fast(), which
+ * are inlined into the caller: a hit is a pop from (or push to) a per-size-class
+ * free list, and only an empty list calls into the allocator to carve a new
+ * slab.
+ *
  */
 
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "allocator_config.h"
+#include "allocator_lock.h"
+
 /**
  * @brief Allocates a block of memory from the static memory pool.
  *
  * @param size  Number of bytes to allocate (must be > 0)
- * @return Pointer to allocated memory (aligned to sizeof(int)), or NULL if
- *         allocation fails (insufficient space or invalid request).
+ * @return Pointer to allocated memory (aligned to ALLOCATOR_ALIGNMENT), or
+ *         NULL if allocation fails (insufficient space or invalid request).
  *
  */
 int *allocate(int size);
 
+/**
+ * @def ALLOCATOR_F_CACHELINE
+ * @brief allocate_flags(): start the block on a cache line and pad it to a
+ *        whole number of lines, so it shares no line with another block.
+ *
+ * Use for objects written by different threads (counters, queue heads,
+ * per-thread state) to avoid false sharing.
+ */
+#define ALLOCATOR_F_CACHELINE  0x1u
+
+/**
+ * @def ALLOCATOR_F_FAST
+ * @brief allocate_flags(): take the block from the fast tier
+ *        (ALLOCATOR_FAST_MEMORY) or fail; unlike allocate_tier() it never
+ *        spills to the main pool.
+ */
+#define ALLOCATOR_F_FAST       0x2u
+
+/**
+ * @brief Allocates a block with placement options.
+ *
+ * @param size  Number of bytes to allocate (must be > 0).
+ * @param flags Bitwise OR of ALLOCATOR_F_* flags (0 behaves like allocate()).
+ * @return Pointer to allocated memory, or NULL if allocation fails.
+ */
+int *allocate_flags(int size, uint32_t flags);
+
+/**
+ * @struct allocator_iovec_t
+ * @brief One segment of a scatter-gather allocation.
+ *
+ * Same members, in the same order, as POSIX struct iovec, so an array can be
+ * passed to readv()/writev() or turned into a DMA descriptor list.
+ */
+typedef struct {
+    void  *iov_base;
+    size_t iov_len;
+} allocator_iovec_t;
+
+/**
+ * @brief Allocates @p total bytes as up to @p max_segments discontiguous
+ *        blocks, taken from the lowest gaps in one pass over the block list.
+ *
+ * Succeeds where allocate() fails because no single gap is large enough. The
+ * segments are in address order and their lengths add up to @p total.
+ *
+ * @param total        Number of bytes to allocate (must be > 0).
+ * @param max_segments Capacity of @p iov_out.
+ * @param iov_out      Receives the segments.
+ * @return Number of segments used, or 0 if the free space within
+ *         @p max_segments gaps is insufficient (nothing is allocated).
+ */
+uint32_t allocate_sg(int total, uint32_t max_segments, allocator_iovec_t *iov_out);
+
+/**
+ * @brief Frees the segments of an allocate_sg() allocation.
+ */
+void deallocate_sg(const allocator_iovec_t *iov, uint32_t count);
+
+/**
+ * @brief Allocates a buffer for a DMA engine.
+ *
+ * The buffer is cache-line aligned (or aligned to @p align if larger), padded
+ * to whole cache lines and does not cross a multiple of @p boundary. It comes
+ * from the DMA pool if one is configured (ALLOCATOR_DMA_MEMORY), and from the
+ * main pool if that pool has the ALLOCATOR_REGION_DMA attribute. Free it with
+ * deallocate().
+ *
+ * @param size     Number of bytes (must be > 0).
+ * @param align    Alignment of the start (power of two, or 0).
+ * @param boundary Power of two the buffer must not cross, or 0 for none.
+ * @return Pointer to the buffer, or NULL if the request is invalid or does
+ *         not fit.
+ */
+int *allocate_dma(int size, uint32_t align, uint32_t boundary);
+
+/**
+ * @brief Attributes (ALLOCATOR_REGION_*) of the memory holding @p ptr, e.g.
+ *        to skip cache maintenance for non-cacheable buffers.
+ *
+ * @return Attributes of the main or DMA pool, or 0 for other memory.
+ */
+uint32_t allocator_region_attrs(const void *ptr);
+
+/** allocate_tier(): object accessed often; place it in the fast tier. */
+#define ALLOCATOR_TIER_HOT   1u
+
+/** allocate_tier(): object accessed rarely; place it in the main pool. */
+#define ALLOCATOR_TIER_COLD  0u
+
+/**
+ * @struct allocator_tier_stats_t
+ * @brief Placement counters of allocate_tier().
+ *
+ * The spill rate is hot_spilled / hot_requests.
+ */
+typedef struct {
+    uint32_t hot_requests;   /**< Calls with ALLOCATOR_TIER_HOT. */
+    uint32_t hot_fast;       /**< Hot blocks placed in the fast tier. */
+    uint32_t hot_spilled;    /**< Hot blocks placed in the main pool. */
+    uint32_t cold_requests;  /**< Calls with ALLOCATOR_TIER_COLD. */
+    uint32_t cold_fast;      /**< Cold blocks placed in the fast tier (pool full). */
+    uint32_t fast_used;      /**< Bytes currently allocated in the fast tier. */
+} allocator_tier_stats_t;
+
+/**
+ * @brief Allocates a block in the memory tier matching a hotness hint.
+ *
+ * With a fast tier configured (ALLOCATOR_FAST_MEMORY), hot blocks are placed
+ * there and spill to the main pool when it is full; cold blocks use the main
+ * pool and fall back to the fast tier only if the pool is full. Without one,
+ * every block comes from the main pool. Free with deallocate().
+ *
+ * @param size Number of bytes to allocate (must be > 0).
+ * @param hint ALLOCATOR_TIER_HOT or ALLOCATOR_TIER_COLD.
+ * @return Pointer to allocated memory, or NULL if allocation fails.
+ */
+int *allocate_tier(int size, uint32_t hint);
+
+/**
+ * @brief Copies the placement counters of allocate_tier().
+ */
+void allocator_get_tier_stats(allocator_tier_stats_t *stats);
+
+/**
+ * @brief Resets the placement counters of allocate_tier().
+ */
+void allocator_reset_tier_stats(void);
+
+/** allocate_hint(): freed soon, e.g. a packet buffer. */
+#define ALLOCATOR_LIFE_SHORT   0u
+
+/** allocate_hint(): lives for a while, e.g. a connection or a session. */
+#define ALLOCATOR_LIFE_MEDIUM  1u
+
+/** allocate_hint(): kept for good, e.g. configuration loaded at start-up. */
+#define ALLOCATOR_LIFE_LONG    2u
+
+/** Number of lifetime hints. */
+#define ALLOCATOR_LIFE_CLASSES 3u
+
+/**
+ * @struct allocator_life_stats_t
+ * @brief Counters of allocate_hint(), indexed by lifetime hint.
+ *
+ * The failure rate of a hint is failed / requests.
+ */
+typedef struct {
+    uint32_t requests[ALLOCATOR_LIFE_CLASSES];  /**< Calls with each hint. */
+    uint32_t failed[ALLOCATOR_LIFE_CLASSES];    /**< Calls that returned NULL. */
+} allocator_life_stats_t;
+
+/**
+ * @brief Allocates a block at the end of the pool matching its expected
+ *        lifetime.
+ *
+ * Blocks that die together are kept together, so that freeing short-lived
+ * blocks leaves free space in one piece instead of gaps between long-lived
+ * ones. Long-lived blocks are placed first fit from the low end of the block
+ * list and pack there; short- and medium-lived blocks take the highest gap
+ * that fits. The boundary between the two areas is not fixed: either side may
+ * take all the free space. Blocks of ALLOCATOR_LARGE_MIN or more are page
+ * runs as with allocate(). Free with deallocate().
+ *
+ * @param size     Number of bytes to allocate (must be > 0).
+ * @param lifetime ALLOCATOR_LIFE_SHORT, ALLOCATOR_LIFE_MEDIUM or
+ *                 ALLOCATOR_LIFE_LONG.
+ * @return Pointer to allocated memory, or NULL if allocation fails or the
+ *         hint is invalid.
+ */
+int *allocate_hint(int size, uint32_t lifetime);
+
+/**
+ * @brief Copies the counters of allocate_hint().
+ */
+void allocator_get_life_stats(allocator_life_stats_t *stats);
+
+/**
+ * @brief Resets the counters of allocate_hint().
+ */
+void allocator_reset_life_stats(void);
+
+#if ALLOCATOR_SITE_LIFETIMES
+/**
+ * @struct allocator_site_stats_t
+ * @brief State of call-site lifetime learning (ALLOCATOR_SITE_LIFETIMES).
+ */
+typedef struct {
+    uint32_t sites;        /**< Call sites of allocate() tracked. */
+    uint32_t short_sites;  /**< Sites whose blocks are placed as short-lived. */
+    uint32_t measured;     /**< Lifetimes measured on sampled blocks. */
+    uint32_t routed;       /**< Blocks placed as short-lived. */
+} allocator_site_stats_t;
+
+/**
+ * @brief Copies the state of call-site lifetime learning.
+ *
+ * With ALLOCATOR_SITE_LIFETIMES=1, allocate() keys every request on its
+ * return address and measures, in allocate() calls, how long one block in
+ * ALLOCATOR_SITE_SAMPLE_PERIOD lives. Once a site has
+ * ALLOCATOR_SITE_MIN_SAMPLES measurements with a mean below
+ * ALLOCATOR_SITE_LONG_LIFE, its blocks are placed like
+ * allocate_hint(..., ALLOCATOR_LIFE_SHORT), at the high end of the block
+ * list, away from the long-lived blocks at the low end. Code that cannot be
+ * annotated with hints gets the same segregation. A wrapper that ends in a
+ * tail call to allocate() counts as part of each of its callers.
+ */
+void allocator_get_site_stats(allocator_site_stats_t *stats);
+
+/**
+ * @brief Mean lifetime learned for a call site of allocate(), in allocate()
+ *        calls.
+ *
+ * @param site Return address of the call.
+ * @return Mean lifetime, or UINT32_MAX if none was measured yet.
+ */
+uint32_t allocator_site_lifetime(const void *site);
+
+/**
+ * @brief Forgets every call site, e.g. when the application changes phase.
+ */
+void allocator_reset_sites(void);
+#endif
+
+/**
+ * @def ALLOCATOR_HEAP_POOL
+ * @brief Heap identifier of the main pool.
+ *
+ * @def ALLOCATOR_HEAP_DMA
+ * @brief Heap identifier of the DMA pool (ALLOCATOR_DMA_MEMORY).
+ *
+ * @def ALLOCATOR_HEAP_FAST
+ * @brief Heap identifier of the fast tier (ALLOCATOR_FAST_MEMORY).
+ */
+#define ALLOCATOR_HEAP_POOL  0u
+#define ALLOCATOR_HEAP_DMA   1u
+#define ALLOCATOR_HEAP_FAST  2u
+
+/**
+ * @brief Selects the placement strategy of a heap.
+ *
+ * With a non-zero @p split, blocks of at least @p split bytes are placed at
+ * the high end of the highest gap that fits, and smaller ones first-fit from
+ * the low end. Short-lived small blocks and long-lived large ones then stay
+ * apart, and the holes left by small blocks do not split the room that large
+ * blocks need. Blocks with a DMA boundary are placed the same way. In the
+ * main pool this applies to the block list; blocks of ALLOCATOR_LARGE_MIN or
+ * more come from the top of the pool in any case.
+ *
+ * @param heap  ALLOCATOR_HEAP_POOL, ALLOCATOR_HEAP_DMA or ALLOCATOR_HEAP_FAST.
+ * @param split Smallest size placed from the high end, or 0 for first fit
+ *              from the low end for every block (the default).
+ * @return 0 on success, -1 if the heap is not configured.
+ */
+int allocator_set_placement(uint32_t heap, uint32_t split);
+
+/**
+ * @brief Size of the largest free extent of a heap, in bytes: the largest
+ *        block that could still be placed, before alignment.
+ *
+ * @param heap See allocator_set_placement().
+ * @return Largest free extent, or 0 if the heap is full or not configured.
+ */
+uint32_t allocator_largest_free(uint32_t heap);
+
+/**
+ * @brief Total free bytes of a heap, in all its free extents. Together with
+ *        allocator_largest_free() this gives the external fragmentation,
+ *        1 - largest / total.
+ *
+ * @param heap See allocator_set_placement().
+ * @return Free bytes, or 0 if the heap is full or not configured.
+ */
+uint32_t allocator_free_bytes(uint32_t heap);
+
 /**
  * @brief Frees a previously allocated memory block.
  *
- * @param ptr  Pointer returned by allocate().
+ * @param ptr  Pointer returned by allocate(), allocate_flags(),
+ *             allocate_dma(), allocate_tier(), allocate_hint() or
+ *             allocate_fast().
  *
  */
 void deallocate(int *ptr);
 
-#endif /* ALLOCATOR_H */
\ No newline at end of file
+/**
+ * @brief Returns slabs whose blocks are all free back to the pool.
+ *
+ * Called automatically when allocate() runs out of space; may also be called
+ * by the application, e.g. before requesting the entire pool.
+ */
+void allocator_trim(void);
+
+/* ---------------------------------------------------------------------------- */
+/*                              Size-Class Fast Path                            */
+/* ---------------------------------------------------------------------------- */
+
+/**
+ * @struct allocator_free_block_t
+ * @brief Free small block; the link is stored in the block itself.
+ */
+typedef struct allocator_free_block {
+    struct allocator_free_block *next;
+} allocator_free_block_t;
+
+/** Free-list heads, one per size class. Internal — use the functions below. */
+extern allocator_free_block_t *allocator_class_free[ALLOCATOR_NUM_CLASSES];
+
+/** Per slab frame: 0 if not a slab, otherwise size class + 1. Internal. */
+extern uint8_t allocator_slab_class[ALLOCATOR_SLAB_COUNT];
+
+/**
+ * Per slab frame: thread cache that owns the slab (see allocator_tcache.h), or
+ * 0 for slabs shared through allocator_class_free[]. Internal.
+ */
+extern _Atomic uint8_t allocator_slab_owner[ALLOCATOR_SLAB_COUNT];
+
+/**
+ * Per slab frame, one bit per granule: set where a block starts that is not on
+ * its class free list (in use, or held by a thread cache). A free of a block
+ * whose bit is clear is ignored. Internal; changed under the class lock, or
+ * under the core lock before a new slab gets its class tag.
+ */
+extern uint32_t allocator_slab_busy[ALLOCATOR_SLAB_COUNT][ALLOCATOR_SLAB_MAP_WORDS];
+
+/** Start of the managed pool. Internal. */
+extern uint8_t *const allocator_pool_base;
+
+/** Nonzero while the record of allocator_retain() matches the heap. Internal. */
+extern _Atomic uint8_t allocator_retained;
+
+/** Discards the record of allocator_retain(). Internal. */
+void allocator_retain_drop(void);
+
+/**
+ * @brief Called under an allocator lock before every change to the heap
+ *        metadata; the first change after allocator_retain() discards its
+ *        record. Internal.
+ */
+ALLOCATOR_INLINE void allocator_heap_changed(void) {
+    if (ALLOCATOR_UNLIKELY(atomic_load_explicit(&allocator_retained, memory_order_relaxed) != 0)) {
+        allocator_retain_drop();
+    }
+}
+
+#if ALLOCATOR_ADAPTIVE_CLASSES
+/**
+ * Size class + 1 of each request-size granule, 0 for the default layout
+ * (one class per granule, the last class taking the rest). Internal.
+ */
+extern uint8_t allocator_class_index[ALLOCATOR_CLASS_BUCKETS];
+
+/** Block size of each class, 0 for the default layout. Internal. */
+extern uint16_t allocator_class_bytes[ALLOCATOR_NUM_CLASSES];
+
+/**
+ * Requests per size granule; the last entry counts requests larger than
+ * ALLOCATOR_SMALL_MAX. Updated with relaxed atomic adds, outside any lock.
+ * Internal — see allocator_classes.h.
+ */
+extern _Atomic uint32_t allocator_size_hist[ALLOCATOR_CLASS_BUCKETS + 1u];
+#elif ALLOCATOR_CLASS_TABLES
+/** Size class of each request-size granule. Internal. */
+extern const uint8_t allocator_class_index[ALLOCATOR_CLASS_BUCKETS];
+
+/** Block size of each class. Internal. */
+extern const uint16_t allocator_class_bytes[ALLOCATOR_NUM_CLASSES];
+#endif
+
+/**
+ * @brief Word of allocator_slab_busy[] for the block at pool offset @p off.
+ *
+ * @param bit Receives the mask of the block within the word.
+ */
+ALLOCATOR_INLINE uint32_t *allocator_busy_word(uintptr_t off, uint32_t *bit) {
+    uint32_t g = (uint32_t)(off & (ALLOCATOR_SLAB_BYTES - 1u)) / ALLOCATOR_CLASS_GRANULE;
+    *bit = 1u << (g % 32u);
+    return &allocator_slab_busy[off >> ALLOCATOR_SLAB_SHIFT][g / 32u];
+}
+
+/**
+ * @brief Size class of a request of 1 .. ALLOCATOR_SMALL_MAX bytes.
+ */
+ALLOCATOR_INLINE uint32_t allocator_size_class(uint32_t req) {
+    uint32_t bucket = (req - 1u) / ALLOCATOR_CLASS_GRANULE;
+#if ALLOCATOR_ADAPTIVE_CLASSES
+    uint32_t cls = allocator_class_index[bucket];
+    if (cls != 0) return cls - 1u;
+    return bucket < ALLOCATOR_NUM_CLASSES - 1u ? bucket : ALLOCATOR_NUM_CLASSES - 1u;
+#elif ALLOCATOR_CLASS_TABLES
+    return allocator_class_index[bucket];
+#else
+    return bucket;
+#endif
+}
+
+/**
+ * @brief Block size of a size class.
+ */
+ALLOCATOR_INLINE uint32_t allocator_class_size(uint32_t cls) {
+#if ALLOCATOR_ADAPTIVE_CLASSES
+    uint32_t bytes = allocator_class_bytes[cls];
+    if (bytes != 0) return bytes;
+    return cls < ALLOCATOR_NUM_CLASSES - 1u ? (cls + 1u) * ALLOCATOR_CLASS_GRANULE
+                                            : ALLOCATOR_SMALL_MAX;
+#elif ALLOCATOR_CLASS_TABLES
+    return allocator_class_bytes[cls];
+#else
+    return (cls + 1u) * ALLOCATOR_CLASS_GRANULE;
+#endif
+}
+
+/**
+ * @brief Slow path of allocate_fast(): carves a new slab for a size class.
+ *
+ * @param cls Size class whose free list is empty.
+ * @return Pointer to a block of the class, or NULL if the pool is exhausted.
+ */
+int *allocator_class_refill(uint32_t cls);
+
+/**
+ * @brief Carves a new slab for a size class and chains all of its blocks.
+ *
+ * Used by allocator_class_refill() and by the per-thread caches, which keep
+ * the chain to themselves.
+ *
+ * @param cls   Size class of the slab.
+ * @param owner Value stored in allocator_slab_owner[] for the slab.
+ * @param last  Receives the last block of the chain.
+ * @return First block of the NULL-terminated chain, or NULL if the pool is
+ *         exhausted.
+ */
+allocator_free_block_t *allocator_slab_carve(uint32_t cls, uint32_t owner,
+                                             allocator_free_block_t **last);
+
+/**
+ * @brief Pushes a chain from allocator_slab_carve() onto the shared free list
+ *        of its size class.
+ *
+ * @param cls   Size class of the chain.
+ * @param first First block of the chain.
+ * @param last  Last block of the chain.
+ */
+void allocator_slab_share(uint32_t cls, allocator_free_block_t *first,
+                          allocator_free_block_t *last);
+
+/**
+ * @brief Allocates a small block from its size-class free list.
+ *
+ * Requests larger than ALLOCATOR_SMALL_MAX fall back to allocate(). The block
+ * is aligned to ALLOCATOR_CLASS_GRANULE and may be released with either
+ * deallocate_fast() or deallocate().
+ *
+ * @param size Number of bytes to allocate (must be > 0).
+ * @return Pointer to allocated memory, or NULL if allocation fails.
+ */
+ALLOCATOR_INLINE int *allocate_fast(int size) {
+    uint32_t req = (uint32_t)size;
+    if (ALLOCATOR_LIKELY(req - 1u < ALLOCATOR_SMALL_MAX)) { /* rejects size <= 0 too */
+        uint32_t cls = allocator_size_class(req);
+#if ALLOCATOR_ADAPTIVE_CLASSES
+        atomic_fetch_add_explicit(&allocator_size_hist[(req - 1u) / ALLOCATOR_CLASS_GRANULE], 1u,
+                                  memory_order_relaxed);
+#endif
+        allocator_lock(ALLOCATOR_LOCK_CLASS(cls));
+        allocator_free_block_t *b = allocator_class_free[cls];
+        if (ALLOCATOR_LIKELY(b != NULL)) {
+            uint32_t bit;
+            allocator_heap_changed();
+            allocator_class_free[cls] = b->next;
+            *allocator_busy_word((uintptr_t)((uint8_t*)b - allocator_pool_base), &bit) |= bit;
+        }
+        allocator_unlock(ALLOCATOR_LOCK_CLASS(cls));
+        if (ALLOCATOR_LIKELY(b != NULL)) return (int*)(void*)b;
+        return allocator_class_refill(cls);
+    }
+    return allocate(size);
+}
+
+/**
+ * @brief Frees a block, pushing small blocks back onto their class free list.
+ *
+ * Blocks that do not belong to a slab are passed on to deallocate(). Pointers
+ * into a slab that are not a block in use (interior pointers, the slack after
+ * the last block, a second free of the same block) are ignored, as by
+ * deallocate().
+ *
+ * @param ptr Pointer returned by allocate_fast() or allocate().
+ */
+ALLOCATOR_INLINE void deallocate_fast(int *ptr) {
+    uintptr_t off = (uintptr_t)ptr - (uintptr_t)allocator_pool_base;
+    if (ALLOCATOR_LIKELY(off < ALLOCATOR_TOTAL_MEMORY)) {
+        uint8_t tag = allocator_slab_class[off >> ALLOCATOR_SLAB_SHIFT];
+        if (ALLOCATOR_LIKELY(tag != 0)) {
+            if (ALLOCATOR_UNLIKELY((off & (ALLOCATOR_CLASS_GRANULE - 1u)) != 0)) return;
+            allocator_free_block_t *b = (allocator_free_block_t*)(void*)ptr;
+            uint32_t bit;
+            uint32_t *word = allocator_busy_word(off, &bit);
+            allocator_lock(ALLOCATOR_LOCK_CLASS(tag - 1u));
+            if (ALLOCATOR_LIKELY((*word & bit) != 0)) {
+                allocator_heap_changed();
+                *word &= ~bit;
+                b->next = allocator_class_free[tag - 1u];
+                allocator_class_free[tag - 1u] = b;
+            }
+            allocator_unlock(ALLOCATOR_LOCK_CLASS(tag - 1u));
+            return;
+        }
+    }
+    deallocate(ptr);
+}
+
+#endif /* ALLOCATOR_H */
@@ -0,0 +1,95 @@
+#ifndef ALLOCATOR_CACHE_H
+#define ALLOCATOR_CACHE_H
+
+/**
+ * @file allocator_cache.h
+ * @brief Object caches that keep freed objects in their constructed state.
+ *
+ * A cache serves objects of one type. Its memory comes from the pool in
+ * slabs of several objects, and the constructor runs once per object, when
+ * the slab is created, not on every cache_alloc(). cache_free() returns the
+ * object to its slab as it is, so the application must leave it in its
+ * constructed state (e.g. lists empty, locks released): the next
+ * cache_alloc() hands it out without re-initialization. The destructor runs
+ * only when cache_reap() or cache_destroy() gives an empty slab back to the
+ * pool.
+ *
+ * Objects carry no header: each slab keeps a stack of the indices of its
+ * free objects. cache_free() finds the slab by address among the slabs of
+ * the cache.
+ *
+ * A cache is not locked: use it from one thread, or serialize the calls.
+ */
+
+#include <stdint.h>
+#include "allocator.h"
+
+/** Constructor or destructor of the objects of a cache. */
+typedef void (*cache_fn)(void *obj);
+
+/** Object cache, created by cache_create(). */
+typedef struct cache cache_t;
+
+/**
+ * @struct cache_stats_t
+ * @brief Counters of one cache.
+ */
+typedef struct {
+    uint32_t slabs;        /**< Slabs held by the cache. */
+    uint32_t objects;      /**< Objects in those slabs, all constructed. */
+    uint32_t in_use;       /**< Objects handed out and not freed. */
+    uint32_t constructed;  /**< Constructor calls since the cache was created. */
+    uint32_t allocs;       /**< cache_alloc() calls that returned an object. */
+} cache_stats_t;
+
+/**
+ * @brief Creates a cache of objects of @p size bytes.
+ *
+ * @param size  Object size in bytes (must be > 0).
+ * @param align Alignment of every object (power of two), or 0 for
+ *              ALLOCATOR_ALIGNMENT.
+ * @param ctor  Called on each object when its slab is created, or NULL.
+ * @param dtor  Called on each object when its slab is released, or NULL.
+ * @return The cache, or NULL on invalid arguments or if the pool is
+ *         exhausted.
+ */
+cache_t *cache_create(uint32_t size, uint32_t align, cache_fn ctor, cache_fn dtor);
+
+/**
+ * @brief Takes a constructed object from the cache, adding a slab if every
+ *        object is in use.
+ *
+ * @return The object, or NULL if the pool is exhausted.
+ */
+void *cache_alloc(cache_t *cache);
+
+/**
+ * @brief Returns an object to its cache, still constructed.
+ *
+ * @param cache Cache the object came from.
+ * @param obj   Object returned by cache_alloc() (NULL and foreign pointers
+ *              are ignored).
+ */
+void cache_free(cache_t *cache, void *obj);
+
+/**
+ * @brief Gives the slabs with no object in use back to the pool, running the
+ *        destructor on their objects.
+ *
+ * @return Number of slabs released.
+ */
+uint32_t cache_reap(cache_t *cache);
+
+/**
+ * @brief Releases every slab and the cache itself.
+ *
+ * @return 0 on success, -1 if objects are still in use (nothing is released).
+ */
+int cache_destroy(cache_t *cache);
+
+/**
+ * @brief Copies the counters of a cache.
+ */
+void cache_get_stats(const cache_t *cache, cache_stats_t *stats);
+
+#endif /* ALLOCATOR_CACHE_H */
@@ -0,0 +1,132 @@
+#ifndef ALLOCATOR_CLASSES_H
+#define ALLOCATOR_CLASSES_H
+
+/**
+ * @file allocator_classes.h
+ * @brief Size-class layouts tuned to the requested sizes of a workload.
+ *
+ * By default the ALLOCATOR_NUM_CLASSES size classes are one granule apart,
+ * which wastes nothing for requests up to ALLOCATOR_SMALL_MAX but serves
+ * nothing larger. With ALLOCATOR_ADAPTIVE_CLASSES=1, allocate() and
+ * allocate_fast() count requests per granule of size, and the classes can be
+ * spread over a larger range (ALLOCATOR_SMALL_MAX, half a slab by default)
+ * where the workload needs them:
+ *
+ * - allocator_classes_tune() chooses class sizes that minimize internal
+ *   fragmentation for a histogram (dynamic programming over the granules) and
+ *   splits a budget of slabs between the classes by demand.
+ * - allocator_classes_retune() applies the result at run time.
+ * - allocator_classes_export() prints the layout as ALLOCATOR_CLASS_TABLE and
+ *   related macros, so production builds use it as a compile-time table
+ *   without the histogram.
+ * - allocator_classes_prefill() carves the slabs of the layout up front.
+ *
+ * Fragmentation is measured at granule resolution: a request is counted as
+ * the whole granule it falls in.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include "allocator.h"
+
+/**
+ * @struct allocator_class_layout_t
+ * @brief A size-class layout and its cost for a histogram.
+ *
+ * @var allocator_class_layout_t::size
+ *      Block size of each class, ascending; the last is ALLOCATOR_SMALL_MAX.
+ * @var allocator_class_layout_t::index
+ *      Class of each request-size granule.
+ * @var allocator_class_layout_t::slabs
+ *      Slabs per class to prefill.
+ * @var allocator_class_layout_t::waste
+ *      Bytes lost to rounding up to the class size, over the histogram.
+ */
+typedef struct {
+    uint16_t size[ALLOCATOR_NUM_CLASSES];
+    uint8_t  index[ALLOCATOR_CLASS_BUCKETS];
+    uint16_t slabs[ALLOCATOR_NUM_CLASSES];
+    uint64_t waste;
+} allocator_class_layout_t;
+
+/**
+ * @brief Describes the layout in use, with its waste for @p hist.
+ *
+ * @param hist   Requests per granule (ALLOCATOR_CLASS_BUCKETS entries), or
+ *               NULL for a waste of 0.
+ * @param layout Receives the layout (slabs are left at 0).
+ */
+void allocator_classes_current(const uint32_t *hist, allocator_class_layout_t *layout);
+
+/**
+ * @brief Computes the layout with the least internal fragmentation for a
+ *        histogram of request sizes.
+ *
+ * @param hist        Requests per granule (ALLOCATOR_CLASS_BUCKETS entries).
+ * @param slab_budget Slabs to divide between the classes, in proportion to
+ *                    the bytes each class serves.
+ * @param layout      Receives the layout.
+ *
+ * Runs in O(classes * buckets^2) on static scratch tables, so it is not
+ * reentrant.
+ */
+void allocator_classes_tune(const uint32_t *hist, uint32_t slab_budget,
+                            allocator_class_layout_t *layout);
+
+/**
+ * @brief Writes a layout as C preprocessor definitions for a production
+ *        build (NUL-terminated).
+ *
+ * @return Length of the full text; it was truncated if this is >= @p len.
+ */
+size_t allocator_classes_export(const allocator_class_layout_t *layout, char *buf, size_t len);
+
+/**
+ * @brief Carves @p slabs[c] slabs for every class c and puts their blocks on
+ *        the class free lists, so steady-state allocation never carves.
+ *
+ * @return 0 on success, -1 if the pool ran out (the slabs carved so far stay).
+ */
+int allocator_classes_prefill(const uint16_t *slabs);
+
+#if ALLOCATOR_ADAPTIVE_CLASSES
+/**
+ * @brief Requests per granule recorded since the last reset
+ *        (ALLOCATOR_CLASS_BUCKETS entries, then the count of larger ones).
+ *
+ * The counters are atomic; the result is a copy taken at the call, valid
+ * until the next call.
+ */
+const uint32_t *allocator_size_histogram(void);
+
+/**
+ * @brief Clears the size histogram.
+ */
+void allocator_size_histogram_reset(void);
+
+/**
+ * @brief Installs the class sizes of a layout.
+ *
+ * Size classes cannot change under live blocks: empty slabs are trimmed
+ * first, and the call fails if any slab is still in use (including blocks
+ * held by thread caches or magazines). No other thread may allocate
+ * meanwhile.
+ *
+ * @return 0 on success, -1 if slabs are in use or the layout is invalid.
+ */
+int allocator_classes_apply(const allocator_class_layout_t *layout);
+
+/**
+ * @brief Tunes the layout to the recorded histogram and applies it.
+ *
+ * Call periodically at a quiescent point (e.g. between phases of the
+ * application); the histogram keeps accumulating.
+ *
+ * @param slab_budget See allocator_classes_tune().
+ * @param layout      If not NULL, receives the tuned layout.
+ * @return 0 if the tuned layout is in use, -1 if it could not be applied.
+ */
+int allocator_classes_retune(uint32_t slab_budget, allocator_class_layout_t *layout);
+#endif
+
+#endif /* ALLOCATOR_CLASSES_H */
@@ -0,0 +1,538 @@
+#ifndef ALLOCATOR_CONFIG_H
+#define ALLOCATOR_CONFIG_H
+
+/**
+ * @file allocator_config.h
+ * @brief Compile-time configuration of the memory pool allocator.
+ *
+ * Every setting can be overridden from the build system (for example
+ * `-DALLOCATOR_TOTAL_MEMORY=65536u`); the values below are the defaults.
+ */
+
+/**
+ * @def ALLOCATOR_CLASS_CONFIG
+ * @brief Optional header (e.g. `-DALLOCATOR_CLASS_CONFIG="classes.h"`) holding
+ *        size-class settings exported by allocator_classes_export().
+ */
+#ifdef ALLOCATOR_CLASS_CONFIG
+#include ALLOCATOR_CLASS_CONFIG
+#endif
+
+/**
+ * @def ALLOCATOR_TOTAL_MEMORY
+ * @brief Total managed memory in bytes (pool + optional metadata).
+ */
+#ifndef ALLOCATOR_TOTAL_MEMORY
+#define ALLOCATOR_TOTAL_MEMORY   (100u * 1024u)  /**< 100 KB */
+#endif
+
+/**
+ * @def ALLOCATOR_MAX_NODES
+ * @brief Maximum number of allocation metadata entries.
+ */
+#ifndef ALLOCATOR_MAX_NODES
+#define ALLOCATOR_MAX_NODES      96
+#endif
+
+/**
+ * @def ALLOCATOR_ALIGNMENT
+ * @brief Alignment of blocks returned by allocate() (power of two).
+ *
+ * Request sizes are rounded up to a multiple of this value so that every
+ * block, and therefore every gap between blocks, starts aligned.
+ */
+#ifndef ALLOCATOR_ALIGNMENT
+#define ALLOCATOR_ALIGNMENT      (sizeof(void*) > sizeof(int) ? sizeof(void*) : sizeof(int))
+#endif
+
+/**
+ * @def ALLOCATOR_CACHE_LINE
+ * @brief Cache line size in bytes (power of two), used by
+ *        ALLOCATOR_F_CACHELINE.
+ */
+#ifndef ALLOCATOR_CACHE_LINE
+#define ALLOCATOR_CACHE_LINE     64u
+#endif
+
+/**
+ * @def ALLOCATOR_CLASS_GRANULE
+ * @brief Spacing of the small-object size classes in bytes (power of two).
+ *
+ * Size class @c c serves requests of up to (c + 1) * ALLOCATOR_CLASS_GRANULE
+ * bytes unless ALLOCATOR_CLASS_TABLE or ALLOCATOR_ADAPTIVE_CLASSES says
+ * otherwise; blocks handed out by the fast path are aligned to the granule.
+ */
+#ifndef ALLOCATOR_CLASS_GRANULE
+#define ALLOCATOR_CLASS_GRANULE  16u
+#endif
+
+/**
+ * @def ALLOCATOR_NUM_CLASSES
+ * @brief Number of small-object size classes served by allocate_fast().
+ */
+#ifndef ALLOCATOR_NUM_CLASSES
+#define ALLOCATOR_NUM_CLASSES    16u
+#endif
+
+/**
+ * @def ALLOCATOR_SLAB_SHIFT
+ * @brief log2 of the slab size used to refill the size-class free lists.
+ */
+#ifndef ALLOCATOR_SLAB_SHIFT
+#define ALLOCATOR_SLAB_SHIFT     10u
+#endif
+
+/**
+ * @def ALLOCATOR_SLAB_COLOR_STEP
+ * @brief Step between the starting offsets ("colors") of successive slabs of
+ *        a size class, in bytes (multiple of ALLOCATOR_CLASS_GRANULE; 0
+ *        disables coloring).
+ *
+ * Without coloring, the n-th block of every slab sits at the same offset
+ * modulo the slab size, so hot blocks of many slabs compete for the same
+ * cache sets.
+ */
+#ifndef ALLOCATOR_SLAB_COLOR_STEP
+#define ALLOCATOR_SLAB_COLOR_STEP     ALLOCATOR_CACHE_LINE
+#endif
+
+/**
+ * @def ALLOCATOR_SLAB_COLOR_RESERVE
+ * @brief Bytes per slab set aside for coloring.
+ *
+ * Colors normally use only the space a slab cannot fill with whole blocks,
+ * which is none for power-of-two classes; reserving room costs blocks per
+ * slab but gives every class at least RESERVE / STEP + 1 colors.
+ */
+#ifndef ALLOCATOR_SLAB_COLOR_RESERVE
+#define ALLOCATOR_SLAB_COLOR_RESERVE  0u
+#endif
+
+/**
+ * @def ALLOCATOR_RETAINED_SECTION
+ * @brief Linker section (string) holding the pool and its retained metadata,
+ *        e.g. ".noinit", for warm restart (see allocator_snapshot.h).
+ *
+ * Not defined by default: the pool is ordinary zero-initialized storage.
+ */
+
+/**
+ * @def ALLOCATOR_REGION_DMA
+ * @brief Region attribute: memory reachable by the DMA engines.
+ */
+#define ALLOCATOR_REGION_DMA      0x1u
+
+/**
+ * @def ALLOCATOR_REGION_NOCACHE
+ * @brief Region attribute: memory mapped non-cacheable (no cache maintenance
+ *        needed around DMA transfers).
+ */
+#define ALLOCATOR_REGION_NOCACHE  0x2u
+
+/**
+ * @def ALLOCATOR_REGION_FAST
+ * @brief Region attribute: fast memory (TCM, on-chip SRAM).
+ */
+#define ALLOCATOR_REGION_FAST     0x4u
+
+/**
+ * @def ALLOCATOR_DMA_MEMORY
+ * @brief Size in bytes of a separate pool reserved for allocate_dma()
+ *        (0 = DMA buffers come from the main pool).
+ */
+#ifndef ALLOCATOR_DMA_MEMORY
+#define ALLOCATOR_DMA_MEMORY     0u
+#endif
+
+/**
+ * @def ALLOCATOR_DMA_MAX_NODES
+ * @brief Maximum number of live blocks in the DMA pool.
+ */
+#ifndef ALLOCATOR_DMA_MAX_NODES
+#define ALLOCATOR_DMA_MAX_NODES  16u
+#endif
+
+/**
+ * @def ALLOCATOR_DMA_SECTION
+ * @brief Linker section (string) holding the DMA pool, e.g. ".dma" in the
+ *        port linker scripts, which the application may map non-cacheable.
+ *
+ * Not defined by default: the DMA pool is ordinary storage.
+ */
+
+/**
+ * @def ALLOCATOR_DMA_ATTRS
+ * @brief Attributes (ALLOCATOR_REGION_*) of the DMA pool.
+ */
+#ifndef ALLOCATOR_DMA_ATTRS
+#define ALLOCATOR_DMA_ATTRS      ALLOCATOR_REGION_DMA
+#endif
+
+/**
+ * @def ALLOCATOR_FAST_MEMORY
+ * @brief Size in bytes of the fast tier used by allocate_tier() for hot
+ *        objects (0 = no fast tier). The main pool is the slow tier.
+ */
+#ifndef ALLOCATOR_FAST_MEMORY
+#define ALLOCATOR_FAST_MEMORY    0u
+#endif
+
+/**
+ * @def ALLOCATOR_FAST_MAX_NODES
+ * @brief Maximum number of live blocks in the fast tier.
+ */
+#ifndef ALLOCATOR_FAST_MAX_NODES
+#define ALLOCATOR_FAST_MAX_NODES 32u
+#endif
+
+/**
+ * @def ALLOCATOR_FAST_SECTION
+ * @brief Linker section (string) holding the fast tier, e.g. ".fast" in the
+ *        port linker scripts, to be mapped to TCM or on-chip SRAM.
+ *
+ * Not defined by default: the fast tier is ordinary storage.
+ */
+
+/**
+ * @def ALLOCATOR_FAST_ATTRS
+ * @brief Attributes (ALLOCATOR_REGION_*) of the fast tier.
+ */
+#ifndef ALLOCATOR_FAST_ATTRS
+#define ALLOCATOR_FAST_ATTRS     ALLOCATOR_REGION_FAST
+#endif
+
+/**
+ * @def ALLOCATOR_POOL_ATTRS
+ * @brief Attributes (ALLOCATOR_REGION_*) of the main pool. By default the
+ *        main pool serves DMA only when there is no DMA pool.
+ */
+#ifndef ALLOCATOR_POOL_ATTRS
+#if ALLOCATOR_DMA_MEMORY == 0u
+#define ALLOCATOR_POOL_ATTRS     ALLOCATOR_REGION_DMA
+#else
+#define ALLOCATOR_POOL_ATTRS     0u
+#endif
+#endif
+
+/**
+ * @def ALLOCATOR_ENABLE_LOCKS
+ * @brief Set to 1 to protect allocator state with the lock hooks of
+ *        allocator_lock.h (multi-threaded or RTOS builds).
+ *
+ * With the default of 0 all lock calls compile to nothing.
+ */
+#ifndef ALLOCATOR_ENABLE_LOCKS
+#define ALLOCATOR_ENABLE_LOCKS   0
+#endif
+
+/**
+ * @def ALLOCATOR_TCACHE_MAX
+ * @brief Maximum number of per-thread caches alive at the same time
+ *        (see allocator_tcache.h).
+ */
+#ifndef ALLOCATOR_TCACHE_MAX
+#define ALLOCATOR_TCACHE_MAX     8u
+#endif
+
+/**
+ * @def ALLOCATOR_MAGAZINE_SIZE
+ * @brief Initial number of blocks per magazine (see allocator_magazine.h).
+ */
+#ifndef ALLOCATOR_MAGAZINE_SIZE
+#define ALLOCATOR_MAGAZINE_SIZE  8u
+#endif
+
+/**
+ * @def ALLOCATOR_MAGAZINE_MAX
+ * @brief Largest magazine size; sets the storage reserved per magazine.
+ */
+#ifndef ALLOCATOR_MAGAZINE_MAX
+#define ALLOCATOR_MAGAZINE_MAX   32u
+#endif
+
+/**
+ * @def ALLOCATOR_MAGAZINE_GROW_AFTER
+ * @brief Contended depot accesses after which a size class doubles its
+ *        magazine size (0 = never grow automatically).
+ */
+#ifndef ALLOCATOR_MAGAZINE_GROW_AFTER
+#define ALLOCATOR_MAGAZINE_GROW_AFTER 16u
+#endif
+
+/**
+ * @def ALLOCATOR_MIGRATE_MAX_HANDLES
+ * @brief Number of relocatable blocks tracked by allocator_migrate.h.
+ */
+#ifndef ALLOCATOR_MIGRATE_MAX_HANDLES
+#define ALLOCATOR_MIGRATE_MAX_HANDLES 64u
+#endif
+
+/**
+ * @def ALLOCATOR_CACHE_SLAB_BYTES
+ * @brief Target size of a slab of an object cache (allocator_cache.h); a
+ *        slab holds at least 4 objects whatever their size.
+ */
+#ifndef ALLOCATOR_CACHE_SLAB_BYTES
+#define ALLOCATOR_CACHE_SLAB_BYTES ALLOCATOR_SLAB_BYTES
+#endif
+
+/**
+ * @def ALLOCATOR_ADAPTIVE_CLASSES
+ * @brief Set to 1 to record a histogram of requested sizes and allow the
+ *        size classes to be re-tuned at run time (see allocator_classes.h).
+ */
+#ifndef ALLOCATOR_ADAPTIVE_CLASSES
+#define ALLOCATOR_ADAPTIVE_CLASSES 0
+#endif
+
+/**
+ * @def ALLOCATOR_CLASS_TABLE
+ * @brief Optional brace-enclosed list of the ALLOCATOR_NUM_CLASSES class sizes
+ *        (ascending multiples of ALLOCATOR_CLASS_GRANULE), as exported by
+ *        allocator_classes_export(). Must come with ALLOCATOR_CLASS_INDEX and
+ *        ALLOCATOR_SMALL_MAX (the largest class size).
+ *
+ * Not defined by default: class @c c has size (c + 1) * granule.
+ *
+ * @def ALLOCATOR_CLASS_INDEX
+ * @brief Brace-enclosed list mapping each granule of request size to its
+ *        class (ALLOCATOR_SMALL_MAX / ALLOCATOR_CLASS_GRANULE entries).
+ */
+
+/**
+ * @def ALLOCATOR_CLASS_TABLES
+ * @brief 1 if size classes are looked up in tables (a compile-time
+ *        ALLOCATOR_CLASS_TABLE or adaptive classes), 0 if computed.
+ */
+#if defined(ALLOCATOR_CLASS_TABLE) || ALLOCATOR_ADAPTIVE_CLASSES
+#define ALLOCATOR_CLASS_TABLES 1
+#else
+#define ALLOCATOR_CLASS_TABLES 0
+#endif
+
+/**
+ * @def ALLOCATOR_SMALL_MAX
+ * @brief Largest request served from a size class. With adaptive classes the
+ *        default leaves room to spread the classes over half a slab.
+ */
+#ifndef ALLOCATOR_SMALL_MAX
+#if ALLOCATOR_ADAPTIVE_CLASSES
+#define ALLOCATOR_SMALL_MAX  ((1u << ALLOCATOR_SLAB_SHIFT) / 2u)
+#else
+#define ALLOCATOR_SMALL_MAX  (ALLOCATOR_NUM_CLASSES * ALLOCATOR_CLASS_GRANULE)
+#endif
+#endif
+
+/** Number of request-size granules covered by the size classes. */
+#define ALLOCATOR_CLASS_BUCKETS (ALLOCATOR_SMALL_MAX / ALLOCATOR_CLASS_GRANULE)
+
+/** Slab size in bytes; slabs are aligned to their size within the pool. */
+#define ALLOCATOR_SLAB_BYTES (1u << ALLOCATOR_SLAB_SHIFT)
+
+/** Number of slab-sized frames covering the pool. */
+#define ALLOCATOR_SLAB_COUNT \
+    ((ALLOCATOR_TOTAL_MEMORY + ALLOCATOR_SLAB_BYTES - 1u) / ALLOCATOR_SLAB_BYTES)
+
+/** 32-bit words of a per-slab bitmap with one bit per granule. */
+#define ALLOCATOR_SLAB_MAP_WORDS \
+    ((ALLOCATOR_SLAB_BYTES / ALLOCATOR_CLASS_GRANULE + 31u) / 32u)
+
+/**
+ * @def ALLOCATOR_PLACEMENT_SPLIT
+ * @brief Initial placement of the main pool: blocks of at least this many
+ *        bytes are placed from the high end of the block list, smaller ones
+ *        from the low end. 0 (the default) places every block first-fit from
+ *        the low end. See allocator_set_placement().
+ */
+#ifndef ALLOCATOR_PLACEMENT_SPLIT
+#define ALLOCATOR_PLACEMENT_SPLIT  0u
+#endif
+
+/**
+ * @def ALLOCATOR_SITE_LIFETIMES
+ * @brief Set to 1 to have allocate() learn the typical lifetime of the blocks
+ *        of each call site and place those of sites that are not long-lived
+ *        as allocate_hint() does with ALLOCATOR_LIFE_SHORT.
+ */
+#ifndef ALLOCATOR_SITE_LIFETIMES
+#define ALLOCATOR_SITE_LIFETIMES 0
+#endif
+
+/**
+ * @def ALLOCATOR_SITE_SLOTS
+ * @brief Number of call sites tracked (power of two); allocations from sites
+ *        beyond it are placed as usual.
+ */
+#ifndef ALLOCATOR_SITE_SLOTS
+#define ALLOCATOR_SITE_SLOTS  64u
+#endif
+
+/**
+ * @def ALLOCATOR_SITE_SAMPLE_PERIOD
+ * @brief One allocate() call in this many (power of two) has its lifetime
+ *        measured.
+ */
+#ifndef ALLOCATOR_SITE_SAMPLE_PERIOD
+#define ALLOCATOR_SITE_SAMPLE_PERIOD  8u
+#endif
+
+/**
+ * @def ALLOCATOR_SITE_SAMPLES
+ * @brief Number of sampled blocks whose lifetimes are measured at once.
+ */
+#ifndef ALLOCATOR_SITE_SAMPLES
+#define ALLOCATOR_SITE_SAMPLES  16u
+#endif
+
+/**
+ * @def ALLOCATOR_SITE_LONG_LIFE
+ * @brief Mean lifetime, in allocate() calls, from which a site counts as
+ *        long-lived. Blocks of sites below it, once measured
+ *        ALLOCATOR_SITE_MIN_SAMPLES times, are placed as short-lived.
+ */
+#ifndef ALLOCATOR_SITE_LONG_LIFE
+#define ALLOCATOR_SITE_LONG_LIFE  4096u
+#endif
+
+/**
+ * @def ALLOCATOR_SITE_MIN_SAMPLES
+ * @brief Lifetimes measured before a site's placement follows its mean.
+ */
+#ifndef ALLOCATOR_SITE_MIN_SAMPLES
+#define ALLOCATOR_SITE_MIN_SAMPLES  4u
+#endif
+
+/**
+ * @def ALLOCATOR_LARGE_MIN
+ * @brief Smallest request allocate() serves as a run of whole slab frames
+ *        (pages) taken from the top of the pool, instead of from the block
+ *        list that grows from the bottom.
+ */
+#ifndef ALLOCATOR_LARGE_MIN
+#define ALLOCATOR_LARGE_MIN  (4u * ALLOCATOR_SLAB_BYTES)
+#endif
+
+/**
+ * @def ALLOCATOR_BACKEND_SEGTREE
+ * @brief Set to 1 (ALLOCATOR_BACKEND=segtree in CMake) to find the lowest
+ *        gap of the block list with a segment tree over the pool instead of
+ *        walking the list: O(log n) first fit, and O(1) failure when no gap
+ *        is large enough. Costs a bit per ALLOCATOR_ALIGNMENT bytes of pool
+ *        plus 12 bytes per 64 of those bits.
+ */
+#ifndef ALLOCATOR_BACKEND_SEGTREE
+#define ALLOCATOR_BACKEND_SEGTREE 0
+#endif
+
+/* ---------------------------------------------------------------------------- */
+/*                                Compiler Helpers                              */
+/* ---------------------------------------------------------------------------- */
+
+/**
+ * @def ALLOCATOR_LIKELY
+ * @brief Branch hint for conditions that hold on the fast path.
+ *
+ * @def ALLOCATOR_UNLIKELY
+ * @brief Branch hint for conditions that lead to a slow path.
+ *
+ * @def ALLOCATOR_INLINE
+ * @brief Forces inlining of fast-path helpers, including those defined in
+ *        headers and called from application code.
+ *
+ * @def ALLOCATOR_SLOW_PATH
+ * @brief Keeps rarely executed code out of line and out of the hot text so
+ *        that its callers stay small enough to inline.
+ *
+ * @def ALLOCATOR_NOINLINE
+ * @brief Keeps a function out of line even under link-time optimization, so
+ *        that ALLOCATOR_CALLER() inside it sees its real caller.
+ *
+ * @def ALLOCATOR_CALLER
+ * @brief Return address of the current function, or NULL where the compiler
+ *        cannot tell.
+ */
+#if defined(__GNUC__) || defined(__clang__)
+#define ALLOCATOR_LIKELY(x)    __builtin_expect(!!(x), 1)
+#define ALLOCATOR_UNLIKELY(x)  __builtin_expect(!!(x), 0)
+#define ALLOCATOR_INLINE       static inline __attribute__((always_inline))
+#define ALLOCATOR_SLOW_PATH    __attribute__((noinline, cold))
+#define ALLOCATOR_NOINLINE     __attribute__((noinline))
+#define ALLOCATOR_CALLER()     __builtin_return_address(0)
+#else
+#define ALLOCATOR_LIKELY(x)    (x)
+#define ALLOCATOR_UNLIKELY(x)  (x)
+#define ALLOCATOR_INLINE       static inline
+#define ALLOCATOR_SLOW_PATH
+#define ALLOCATOR_NOINLINE
+#define ALLOCATOR_CALLER()     ((void*)0)
+#endif
+
+#if (ALLOCATOR_CLASS_GRANULE & (ALLOCATOR_CLASS_GRANULE - 1u)) != 0
+#error "ALLOCATOR_CLASS_GRANULE must be a power of two"
+#endif
+#if (ALLOCATOR_CACHE_LINE & (ALLOCATOR_CACHE_LINE - 1u)) != 0 || \
+    ALLOCATOR_CACHE_LINE > ALLOCATOR_SLAB_BYTES
+#error "ALLOCATOR_CACHE_LINE must be a power of two no larger than a slab"
+#endif
+#if ALLOCATOR_SMALL_MAX > ALLOCATOR_SLAB_BYTES
+#error "The largest size class must fit in one slab"
+#endif
+#if (ALLOCATOR_SLAB_COLOR_STEP % ALLOCATOR_CLASS_GRANULE) != 0
+#error "ALLOCATOR_SLAB_COLOR_STEP must be a multiple of ALLOCATOR_CLASS_GRANULE"
+#endif
+#if ALLOCATOR_SLAB_COLOR_RESERVE + ALLOCATOR_SMALL_MAX > ALLOCATOR_SLAB_BYTES
+#error "ALLOCATOR_SLAB_COLOR_RESERVE leaves no room for the largest size class"
+#endif
+#if ALLOCATOR_NUM_CLASSES > 255u
+#error "ALLOCATOR_NUM_CLASSES must fit the 8-bit slab map"
+#endif
+#if ALLOCATOR_SLAB_COUNT > 65535u
+#error "ALLOCATOR_SLAB_COUNT must fit the 16-bit large-object runs"
+#endif
+#if ALLOCATOR_LARGE_MIN == 0
+#error "ALLOCATOR_LARGE_MIN must be positive"
+#endif
+#if (ALLOCATOR_SITE_SLOTS & (ALLOCATOR_SITE_SLOTS - 1u)) != 0 || \
+    (ALLOCATOR_SITE_SAMPLE_PERIOD & (ALLOCATOR_SITE_SAMPLE_PERIOD - 1u)) != 0
+#error "ALLOCATOR_SITE_SLOTS and ALLOCATOR_SITE_SAMPLE_PERIOD must be powers of two"
+#endif
+#if (ALLOCATOR_SMALL_MAX % ALLOCATOR_CLASS_GRANULE) != 0 || \
+    ALLOCATOR_CLASS_BUCKETS < ALLOCATOR_NUM_CLASSES
+#error "ALLOCATOR_SMALL_MAX must be a multiple of the granule with a bucket per class"
+#endif
+#if !ALLOCATOR_CLASS_TABLES && ALLOCATOR_SMALL_MAX != ALLOCATOR_NUM_CLASSES * ALLOCATOR_CLASS_GRANULE
+#error "ALLOCATOR_SMALL_MAX differs from the computed classes; give ALLOCATOR_CLASS_TABLE"
+#endif
+#if defined(ALLOCATOR_CLASS_TABLE) && ALLOCATOR_ADAPTIVE_CLASSES
+#error "ALLOCATOR_CLASS_TABLE is for production builds; drop it with ALLOCATOR_ADAPTIVE_CLASSES"
+#endif
+#if defined(ALLOCATOR_CLASS_TABLE) && !defined(ALLOCATOR_CLASS_INDEX)
+#error "ALLOCATOR_CLASS_TABLE requires ALLOCATOR_CLASS_INDEX"
+#endif
+
+#if (ALLOCATOR_DMA_MEMORY % ALLOCATOR_CACHE_LINE) != 0
+#error "ALLOCATOR_DMA_MEMORY must be a multiple of ALLOCATOR_CACHE_LINE"
+#endif
+#if ALLOCATOR_DMA_MEMORY != 0u && ALLOCATOR_DMA_MAX_NODES < 1u
+#error "ALLOCATOR_DMA_MAX_NODES must be at least 1"
+#endif
+#if (ALLOCATOR_FAST_MEMORY % ALLOCATOR_CACHE_LINE) != 0
+#error "ALLOCATOR_FAST_MEMORY must be a multiple of ALLOCATOR_CACHE_LINE"
+#endif
+#if ALLOCATOR_FAST_MEMORY != 0u && ALLOCATOR_FAST_MAX_NODES < 1u
+#error "ALLOCATOR_FAST_MAX_NODES must be at least 1"
+#endif
+
+#if ALLOCATOR_MIGRATE_MAX_HANDLES < 1u || ALLOCATOR_MIGRATE_MAX_HANDLES > 65535u
+#error "ALLOCATOR_MIGRATE_MAX_HANDLES must be between 1 and 65535 (16-bit handles)"
+#endif
+
+#if ALLOCATOR_TCACHE_MAX < 1u || ALLOCATOR_TCACHE_MAX > 255u
+#error "ALLOCATOR_TCACHE_MAX must be between 1 and 255 (8-bit owner tags)"
+#endif
+
+#if ALLOCATOR_MAGAZINE_SIZE < 1u || ALLOCATOR_MAGAZINE_SIZE > ALLOCATOR_MAGAZINE_MAX
+#error "ALLOCATOR_MAGAZINE_SIZE must be between 1 and ALLOCATOR_MAGAZINE_MAX"
+#endif
+
+#endif /* ALLOCATOR_CONFIG_H */
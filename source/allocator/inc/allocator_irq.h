@@ -0,0 +1,75 @@
+#ifndef ALLOCATOR_IRQ_H
+#define ALLOCATOR_IRQ_H
+
+/**
+ * @file allocator_irq.h
+ * @brief Interrupt masking used to guard the few instructions that touch
+ *        state shared with interrupt handlers.
+ *
+ * allocator_irq_save() disables interrupts on the current core and returns the
+ * previous state; allocator_irq_restore() puts it back, so sections nest.
+ * Cortex-M (PRIMASK) and RISC-V machine mode (mstatus.MIE) are supported
+ * directly. Other targets can define ALLOCATOR_IRQ_CUSTOM and provide
+ * allocator_port_irq_save()/allocator_port_irq_restore(); hosted builds
+ * without it have no interrupts and compile to nothing.
+ */
+
+#include <stdatomic.h>
+#include <stdint.h>
+#include "allocator_config.h"
+
+/** Saved interrupt state. */
+typedef uint32_t allocator_irq_state_t;
+
+#if defined(ALLOCATOR_IRQ_CUSTOM)
+
+allocator_irq_state_t allocator_port_irq_save(void);
+void allocator_port_irq_restore(allocator_irq_state_t state);
+
+ALLOCATOR_INLINE allocator_irq_state_t allocator_irq_save(void) {
+    return allocator_port_irq_save();
+}
+
+ALLOCATOR_INLINE void allocator_irq_restore(allocator_irq_state_t state) {
+    allocator_port_irq_restore(state);
+}
+
+#elif defined(__ARM_ARCH_PROFILE) && (__ARM_ARCH_PROFILE == 'M')
+
+ALLOCATOR_INLINE allocator_irq_state_t allocator_irq_save(void) {
+    allocator_irq_state_t primask;
+    __asm__ volatile ("mrs %0, primask\n\tcpsid i" : "=r"(primask) :: "memory");
+    return primask;
+}
+
+ALLOCATOR_INLINE void allocator_irq_restore(allocator_irq_state_t state) {
+    __asm__ volatile ("msr primask, %0" :: "r"(state) : "memory");
+}
+
+#elif defined(__riscv) && !defined(__linux__)
+
+ALLOCATOR_INLINE allocator_irq_state_t allocator_irq_save(void) {
+    allocator_irq_state_t mstatus;
+    __asm__ volatile ("csrrci %0, mstatus, 8" : "=r"(mstatus) :: "memory");
+    return mstatus & 8u;
+}
+
+ALLOCATOR_INLINE void allocator_irq_restore(allocator_irq_state_t state) {
+    if (state) __asm__ volatile ("csrsi mstatus, 8" ::: "memory");
+}
+
+#else /* hosted: no interrupts */
+
+ALLOCATOR_INLINE allocator_irq_state_t allocator_irq_save(void) {
+    atomic_signal_fence(memory_order_seq_cst);
+    return 0;
+}
+
+ALLOCATOR_INLINE void allocator_irq_restore(allocator_irq_state_t state) {
+    (void)state;
+    atomic_signal_fence(memory_order_seq_cst);
+}
+
+#endif
+
+#endif /* ALLOCATOR_IRQ_H */
@@ -0,0 +1,110 @@
+#ifndef ALLOCATOR_ISR_H
+#define ALLOCATOR_ISR_H
+
+/**
+ * @file allocator_isr.h
+ * @brief Interrupt-safe allocation of fixed-size buffers.
+ *
+ * allocate() walks the block list and is not reentrant, so it must not be
+ * called from an interrupt handler. Instead, each interrupt source owns an
+ * isr_pool_t: a free list of preallocated buffers that isr_alloc() pops in a
+ * constant number of cycles. Thread context keeps the pool stocked with
+ * isr_pool_refill(), typically when isr_pool_needs_refill() reports that the
+ * handler dipped below the low-water mark.
+ *
+ * Interrupts are masked only around the pointer swap of a push or pop (see
+ * allocator_irq.h); blocks are taken from and returned to the allocator with
+ * interrupts enabled.
+ */
+
+#include <stdint.h>
+#include "allocator.h"
+
+/**
+ * @struct isr_pool_t
+ * @brief Free list of equally sized buffers shared with one interrupt handler.
+ *
+ * @var isr_pool_t::free
+ *      Head of the free list; links are stored in the free buffers.
+ * @var isr_pool_t::count
+ *      Number of buffers currently on the free list.
+ * @var isr_pool_t::target
+ *      Number of buffers isr_pool_refill() stocks the list up to.
+ * @var isr_pool_t::low_water
+ *      isr_alloc() requests a refill when the count drops below this.
+ * @var isr_pool_t::block_size
+ *      Size of each buffer in bytes.
+ * @var isr_pool_t::refill_pending
+ *      Set by isr_alloc() when a refill is due; cleared by isr_pool_refill().
+ * @var isr_pool_t::misses
+ *      Number of isr_alloc() calls that found the list empty.
+ */
+typedef struct {
+    allocator_free_block_t *volatile free;
+    volatile uint16_t count;
+    uint16_t target;
+    uint16_t low_water;
+    uint16_t block_size;
+    volatile uint8_t refill_pending;
+    volatile uint32_t misses;
+} isr_pool_t;
+
+/**
+ * @brief Initializes a pool and stocks it with @p target buffers.
+ *
+ * Thread context only.
+ *
+ * @param pool       Pool to initialize.
+ * @param block_size Size of each buffer in bytes (must be > 0).
+ * @param target     Number of buffers to keep on the free list.
+ * @param low_water  Free count below which a refill is requested.
+ * @return 0 on success, -1 on invalid arguments or if the pool could not be
+ *         fully stocked (the buffers that could be allocated are kept).
+ */
+int isr_pool_init(isr_pool_t *pool, uint32_t block_size, uint16_t target,
+                  uint16_t low_water);
+
+/**
+ * @brief Takes a buffer from the pool. Safe to call from interrupt handlers.
+ *
+ * @param pool Pool to allocate from.
+ * @return Pointer to a buffer of pool->block_size bytes, or NULL if the pool
+ *         is empty.
+ */
+int *isr_alloc(isr_pool_t *pool);
+
+/**
+ * @brief Returns a buffer to the pool. Safe to call from any context.
+ *
+ * @param pool Pool the buffer was taken from.
+ * @param ptr  Buffer returned by isr_alloc() (NULL is ignored).
+ */
+void isr_free(isr_pool_t *pool, int *ptr);
+
+/**
+ * @brief Checks whether the interrupt handler has requested a refill.
+ */
+static inline int isr_pool_needs_refill(const isr_pool_t *pool) {
+    return pool->refill_pending != 0;
+}
+
+/**
+ * @brief Tops the pool up to its target and returns any surplus to the
+ *        allocator. Thread context only.
+ *
+ * @param pool Pool to refill.
+ * @return Number of buffers added to the pool.
+ */
+uint32_t isr_pool_refill(isr_pool_t *pool);
+
+/**
+ * @brief Returns every free buffer to the allocator. Thread context only.
+ *
+ * Buffers still held by the application are not affected and may be given
+ * back with isr_free() or deallocate().
+ *
+ * @param pool Pool to drain.
+ */
+void isr_pool_drain(isr_pool_t *pool);
+
+#endif /* ALLOCATOR_ISR_H */
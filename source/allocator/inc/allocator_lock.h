@@ -0,0 +1,165 @@
+#ifndef ALLOCATOR_LOCK_H
+#define ALLOCATOR_LOCK_H
+
+/**
+ * @file allocator_lock.h
+ * @brief Pluggable locking for multi-threaded and RTOS deployments.
+ *
+ * With ALLOCATOR_ENABLE_LOCKS set to 1, the allocator brackets every access to
+ * shared state with allocator_lock()/allocator_unlock() on one of several
+ * independent locks:
+ *
+ * - ALLOCATOR_LOCK_CORE guards the block list (head_index, node_pool), the
+ *   large runs, slab carving and the snapshot root.
+ * - ALLOCATOR_LOCK_CLASS(c) guards the free list of size class c, so the
+ *   fast path of different size classes never contends.
+ * - ALLOCATOR_LOCK_DEPOT(c) guards the magazine depot of size class c (see
+ *   allocator_magazine.h); it is never held together with another lock.
+ *
+ * Lock order is not id order: when several locks are held (allocator_trim(),
+ * snapshots), class locks are taken in ascending order and the core lock,
+ * id 0, last. No path takes a class lock while holding the core lock, so an
+ * implementation only needs plain, non-recursive mutual exclusion per id.
+ * Until allocator_set_lock_ops() installs an implementation, the calls are
+ * no-ops.
+ *
+ * Ready-made implementations: interrupt masking (single core), C11
+ * spinlocks, POSIX threads, FreeRTOS and Zephyr mutexes.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include "allocator_config.h"
+
+/** Lock guarding the block list and slab carving. */
+#define ALLOCATOR_LOCK_CORE       0u
+
+/** Lock guarding the free list of size class @p c. */
+#define ALLOCATOR_LOCK_CLASS(c)   (1u + (uint32_t)(c))
+
+/** Lock guarding the magazine depot of size class @p c. */
+#define ALLOCATOR_LOCK_DEPOT(c)   (1u + ALLOCATOR_NUM_CLASSES + (uint32_t)(c))
+
+/** Number of distinct lock ids. */
+#define ALLOCATOR_LOCK_COUNT      (1u + 2u * ALLOCATOR_NUM_CLASSES)
+
+/**
+ * @struct allocator_lock_ops_t
+ * @brief Lock implementation installed with allocator_set_lock_ops().
+ *
+ * @var allocator_lock_ops_t::lock
+ *      Acquires lock @c id (0 .. ALLOCATOR_LOCK_COUNT-1).
+ * @var allocator_lock_ops_t::unlock
+ *      Releases lock @c id.
+ * @var allocator_lock_ops_t::ctx
+ *      Opaque pointer passed to the callbacks.
+ * @var allocator_lock_ops_t::trylock
+ *      Acquires lock @c id only if it is free; returns nonzero on success.
+ *      Optional (NULL): used to count contention, never required.
+ */
+typedef struct {
+    void (*lock)(void *ctx, uint32_t id);
+    void (*unlock)(void *ctx, uint32_t id);
+    void *ctx;
+    int  (*trylock)(void *ctx, uint32_t id);
+} allocator_lock_ops_t;
+
+/**
+ * @brief Installs the lock implementation used by the allocator.
+ *
+ * Must be called before the allocator is used concurrently.
+ *
+ * @param ops Lock implementation, or NULL to disable locking.
+ */
+void allocator_set_lock_ops(const allocator_lock_ops_t *ops);
+
+/** Active lock implementation (NULL = none). Internal. */
+extern const allocator_lock_ops_t *allocator_lock_impl;
+
+/**
+ * @brief Acquires one of the allocator's locks.
+ */
+ALLOCATOR_INLINE void allocator_lock(uint32_t id) {
+#if ALLOCATOR_ENABLE_LOCKS
+    const allocator_lock_ops_t *ops = allocator_lock_impl;
+    if (ops != NULL) ops->lock(ops->ctx, id);
+#else
+    (void)id;
+#endif
+}
+
+/**
+ * @brief Releases one of the allocator's locks.
+ */
+ALLOCATOR_INLINE void allocator_unlock(uint32_t id) {
+#if ALLOCATOR_ENABLE_LOCKS
+    const allocator_lock_ops_t *ops = allocator_lock_impl;
+    if (ops != NULL) ops->unlock(ops->ctx, id);
+#else
+    (void)id;
+#endif
+}
+
+/**
+ * @brief Acquires one of the allocator's locks and reports whether it had to
+ *        wait for it.
+ *
+ * @return 1 if the lock was held by someone else, 0 if it was free (or if the
+ *         implementation has no trylock callback).
+ */
+ALLOCATOR_INLINE int allocator_lock_contended(uint32_t id) {
+#if ALLOCATOR_ENABLE_LOCKS
+    const allocator_lock_ops_t *ops = allocator_lock_impl;
+    if (ops == NULL) return 0;
+    if (ops->trylock != NULL) {
+        if (ops->trylock(ops->ctx, id)) return 0;
+        ops->lock(ops->ctx, id);
+        return 1;
+    }
+    ops->lock(ops->ctx, id);
+    return 0;
+#else
+    (void)id;
+    return 0;
+#endif
+}
+
+/* ---------------------------------------------------------------------------- */
+/*                                 Lock Implementations                         */
+/* ---------------------------------------------------------------------------- */
+
+/**
+ * @brief Interrupt masking (allocator_irq.h). Single-core systems only;
+ *        cheapest option when critical sections are short.
+ */
+const allocator_lock_ops_t *allocator_lock_ops_irq(void);
+
+/**
+ * @brief One C11 atomic spinlock per lock id. Requires lock-free
+ *        atomics (not available on ARMv6-M).
+ */
+const allocator_lock_ops_t *allocator_lock_ops_spin(void);
+
+/**
+ * @brief One POSIX mutex per lock id (hosted builds). The first call
+ *        initializes the mutexes.
+ */
+const allocator_lock_ops_t *allocator_lock_ops_pthread(void);
+
+/**
+ * @brief A single POSIX mutex for every lock id. Same semantics as one global
+ *        allocator lock; provided as a baseline for contention measurements.
+ */
+const allocator_lock_ops_t *allocator_lock_ops_pthread_global(void);
+
+/**
+ * @brief One FreeRTOS mutex per lock id (built with ALLOCATOR_LOCK_PORT=freertos).
+ */
+const allocator_lock_ops_t *allocator_lock_ops_freertos(void);
+
+/**
+ * @brief One Zephyr k_mutex per lock id (built with ALLOCATOR_LOCK_PORT=zephyr).
+ */
+const allocator_lock_ops_t *allocator_lock_ops_zephyr(void);
+
+#endif /* ALLOCATOR_LOCK_H */
@@ -0,0 +1,202 @@
+#ifndef ALLOCATOR_MAGAZINE_H
+#define ALLOCATOR_MAGAZINE_H
+
+/**
+ * @file allocator_magazine.h
+ * @brief Per-core magazine caches balanced through a global depot.
+ *
+ * Follows the magazine/depot design of Bonwick's slab and vmem allocators.
+ * Each core (or thread) keeps, per size class, a loaded and a previous
+ * magazine: small arrays of free blocks. mag_alloc() pops from the loaded
+ * magazine and mag_free() pushes onto it, without locks. When the loaded
+ * magazine runs empty (or full), the core swaps it with the previous one;
+ * only when both are exhausted does it visit the depot, which exchanges an
+ * empty magazine for a full one (or the other way round) under the depot
+ * lock of that size class. A core that mostly frees thus hands whole
+ * magazines to a core that mostly allocates, instead of both falling through
+ * to the shared size-class lists.
+ *
+ * Magazine sizes are tunable per size class with mag_depot_set_size(); with
+ * ALLOCATOR_MAGAZINE_GROW_AFTER set, a class whose depot lock keeps being
+ * contended doubles its magazine size (up to ALLOCATOR_MAGAZINE_MAX), which
+ * halves its depot traffic. Contention is measured with the optional trylock
+ * callback of the installed lock implementation (allocator_lock.h).
+ *
+ * Blocks from a magazine cache may also be freed with deallocate() or
+ * deallocate_fast(), and blocks from any other path with mag_free().
+ */
+
+#include <stdint.h>
+#include "allocator.h"
+
+/**
+ * @struct mag_magazine_t
+ * @brief Array of free blocks of one size class.
+ *
+ * @var mag_magazine_t::next
+ *      Link in a depot list.
+ * @var mag_magazine_t::rounds
+ *      Number of blocks held.
+ * @var mag_magazine_t::capacity
+ *      Number of blocks the magazine holds when full.
+ * @var mag_magazine_t::round
+ *      The blocks (storage for ALLOCATOR_MAGAZINE_MAX).
+ */
+typedef struct mag_magazine {
+    struct mag_magazine *next;
+    uint16_t rounds;
+    uint16_t capacity;
+    int *round[ALLOCATOR_MAGAZINE_MAX];
+} mag_magazine_t;
+
+/**
+ * @struct mag_cache_t
+ * @brief Magazines of one core.
+ *
+ * @var mag_cache_t::loaded
+ *      Magazine served first, per size class (NULL until first used).
+ * @var mag_cache_t::previous
+ *      Spare magazine, always either full or empty, per size class.
+ * @var mag_cache_t::depot_exchanges
+ *      Magazines obtained from the depot.
+ * @var mag_cache_t::slab_allocs
+ *      Allocations that fell through to the shared size-class lists.
+ * @var mag_cache_t::slab_frees
+ *      Frees that fell through to the shared size-class lists.
+ */
+typedef struct {
+    mag_magazine_t *loaded[ALLOCATOR_NUM_CLASSES];
+    mag_magazine_t *previous[ALLOCATOR_NUM_CLASSES];
+    uint32_t depot_exchanges;
+    uint32_t slab_allocs;
+    uint32_t slab_frees;
+} mag_cache_t;
+
+/**
+ * @struct mag_depot_stats_t
+ * @brief Statistics of the depot of one size class.
+ *
+ * @var mag_depot_stats_t::magazine_size
+ *      Capacity given to magazines entering service.
+ * @var mag_depot_stats_t::full
+ *      Full magazines currently in the depot.
+ * @var mag_depot_stats_t::empty
+ *      Empty magazines currently in the depot.
+ * @var mag_depot_stats_t::full_gets
+ *      Full magazines handed to a core.
+ * @var mag_depot_stats_t::full_misses
+ *      Depot visits that found no full magazine.
+ * @var mag_depot_stats_t::empty_gets
+ *      Empty magazines handed to a core.
+ * @var mag_depot_stats_t::accesses
+ *      Acquisitions of the depot lock.
+ * @var mag_depot_stats_t::contended
+ *      Acquisitions that found the depot lock taken.
+ * @var mag_depot_stats_t::resizes
+ *      Automatic magazine size increases.
+ */
+typedef struct {
+    uint32_t magazine_size;
+    uint32_t full;
+    uint32_t empty;
+    uint32_t full_gets;
+    uint32_t full_misses;
+    uint32_t empty_gets;
+    uint32_t accesses;
+    uint32_t contended;
+    uint32_t resizes;
+} mag_depot_stats_t;
+
+/**
+ * @brief Initializes a magazine cache (no memory is taken until first use).
+ */
+void mag_cache_init(mag_cache_t *cc);
+
+/**
+ * @brief Returns a cache's magazines to the depot.
+ *
+ * Full magazines stay stocked for other cores; the blocks of partly filled
+ * ones go back to the shared size-class lists.
+ */
+void mag_cache_flush(mag_cache_t *cc);
+
+/**
+ * @brief Sets the magazine size of a size class.
+ *
+ * Applies to magazines entering service from now on; magazines already in use
+ * keep their size.
+ *
+ * @param cls    Size class.
+ * @param rounds Blocks per magazine (clamped to 1 .. ALLOCATOR_MAGAZINE_MAX).
+ */
+void mag_depot_set_size(uint32_t cls, uint32_t rounds);
+
+/**
+ * @brief Reads the depot statistics of a size class.
+ */
+void mag_depot_get_stats(uint32_t cls, mag_depot_stats_t *out);
+
+/**
+ * @brief Frees every magazine held by the depot and the blocks in them.
+ *
+ * Magazines held by caches are not affected; flush those first to release
+ * everything (e.g. before allocator_trim()).
+ */
+void mag_depot_reap(void);
+
+/**
+ * @brief Slow path of mag_alloc(): swaps magazines or visits the depot.
+ */
+int *mag_alloc_slow(mag_cache_t *cc, uint32_t cls);
+
+/**
+ * @brief Slow path of mag_free(): swaps magazines or visits the depot.
+ */
+void mag_free_slow(mag_cache_t *cc, int *ptr, uint32_t cls);
+
+/**
+ * @brief Allocates a block through a magazine cache.
+ *
+ * Requests larger than ALLOCATOR_SMALL_MAX fall back to allocate().
+ *
+ * @param cc   Cache of the calling core.
+ * @param size Number of bytes to allocate (must be > 0).
+ * @return Pointer to allocated memory, or NULL if allocation fails.
+ */
+ALLOCATOR_INLINE int *mag_alloc(mag_cache_t *cc, int size) {
+    uint32_t req = (uint32_t)size;
+    if (ALLOCATOR_LIKELY(req - 1u < ALLOCATOR_SMALL_MAX)) {
+        uint32_t cls = allocator_size_class(req);
+        mag_magazine_t *m = cc->loaded[cls];
+        if (ALLOCATOR_LIKELY(m != NULL && m->rounds != 0)) return m->round[--m->rounds];
+        return mag_alloc_slow(cc, cls);
+    }
+    return allocate(size);
+}
+
+/**
+ * @brief Frees a block through a magazine cache.
+ *
+ * Blocks that do not belong to a slab are passed on to deallocate().
+ *
+ * @param cc  Cache of the calling core.
+ * @param ptr Block to free (NULL is ignored).
+ */
+ALLOCATOR_INLINE void mag_free(mag_cache_t *cc, int *ptr) {
+    uintptr_t off = (uintptr_t)ptr - (uintptr_t)allocator_pool_base;
+    if (ALLOCATOR_LIKELY(off < ALLOCATOR_TOTAL_MEMORY)) {
+        uint8_t tag = allocator_slab_class[off >> ALLOCATOR_SLAB_SHIFT];
+        if (ALLOCATOR_LIKELY(tag != 0)) {
+            mag_magazine_t *m = cc->loaded[tag - 1u];
+            if (ALLOCATOR_LIKELY(m != NULL && m->rounds < m->capacity)) {
+                m->round[m->rounds++] = ptr;
+                return;
+            }
+            mag_free_slow(cc, ptr, tag - 1u);
+            return;
+        }
+    }
+    deallocate(ptr);
+}
+
+#endif /* ALLOCATOR_MAGAZINE_H */
@@ -0,0 +1,133 @@
+#ifndef ALLOCATOR_MBUF_H
+#define ALLOCATOR_MBUF_H
+
+/**
+ * @file allocator_mbuf.h
+ * @brief Reference-counted message buffers for zero-copy layering.
+ *
+ * An mbuf is a header (reference count, offset, length) describing a window
+ * onto payload storage allocated from the pool. Instead of copying a payload
+ * when it crosses a layer, the layer takes a reference:
+ *
+ * - mbuf_ref() shares the same header; nothing is allocated.
+ * - mbuf_clone() and mbuf_slice() allocate only a small header (from the
+ *   size-class fast path) with its own window onto the same storage, which
+ *   the receiving layer may narrow with mbuf_pull()/mbuf_trim() to strip its
+ *   protocol header or trailer.
+ *
+ * The storage goes back to the allocator when the last header referencing it
+ * is released. Reference counts are atomic, so buffers may be handed between
+ * threads (the allocator itself must then be built with locks). Storage is
+ * shared: write to it only while mbuf_is_shared() is false.
+ */
+
+#include <stdatomic.h>
+#include <stdint.h>
+#include "allocator.h"
+
+/**
+ * @struct mbuf_t
+ * @brief Buffer header.
+ *
+ * @var mbuf_t::refs
+ *      References to this header.
+ * @var mbuf_t::offset
+ *      Start of the window, from the start of the storage.
+ * @var mbuf_t::floor
+ *      Lowest offset mbuf_push() may reach: 0 for mbuf_alloc() buffers, the
+ *      start of the slice for mbuf_slice() headers.
+ * @var mbuf_t::length
+ *      Length of the window in bytes.
+ * @var mbuf_t::capacity
+ *      Size of the storage (meaningful in the storage owner only).
+ * @var mbuf_t::owner
+ *      Header that carries the storage: itself for mbuf_alloc() buffers;
+ *      its references count the headers sharing the storage.
+ */
+typedef struct mbuf {
+    _Atomic uint32_t refs;
+    uint32_t offset;
+    uint32_t floor;
+    uint32_t length;
+    uint32_t capacity;
+    struct mbuf *owner;
+} mbuf_t;
+
+/**
+ * @brief Allocates a buffer with @p headroom bytes reserved in front of a
+ *        @p length byte window (for headers added later with mbuf_push()).
+ *
+ * @return Buffer with one reference, or NULL if the pool is exhausted.
+ */
+mbuf_t *mbuf_alloc(uint32_t headroom, uint32_t length);
+
+/**
+ * @brief Creates a new header with the same window (and headroom) onto the
+ *        same storage.
+ *
+ * @return New buffer with one reference, or NULL if no header is available.
+ */
+mbuf_t *mbuf_clone(mbuf_t *b);
+
+/**
+ * @brief Creates a new header for @p length bytes at @p offset within the
+ *        window of @p b. The slice has no headroom of its own.
+ *
+ * @return New buffer with one reference, or NULL if the range is outside the
+ *         window or no header is available.
+ */
+mbuf_t *mbuf_slice(mbuf_t *b, uint32_t offset, uint32_t length);
+
+/**
+ * @brief Drops a reference; the header and, with its last header, the
+ *        storage are freed when their counts reach zero. NULL is ignored.
+ */
+void mbuf_release(mbuf_t *b);
+
+/** Takes another reference to the same header. */
+static inline mbuf_t *mbuf_ref(mbuf_t *b) {
+    atomic_fetch_add_explicit(&b->refs, 1u, memory_order_relaxed);
+    return b;
+}
+
+/** First byte of the window. */
+static inline uint8_t *mbuf_data(const mbuf_t *b) {
+    return (uint8_t*)(void*)(b->owner + 1) + b->offset;
+}
+
+/** Length of the window. */
+static inline uint32_t mbuf_len(const mbuf_t *b) {
+    return b->length;
+}
+
+/**
+ * @brief Whether anyone else can see the storage (other references to this
+ *        header, or other headers).
+ */
+static inline int mbuf_is_shared(const mbuf_t *b) {
+    return atomic_load_explicit(&b->refs, memory_order_acquire) != 1u ||
+           atomic_load_explicit(&b->owner->refs, memory_order_acquire) != 1u;
+}
+
+/**
+ * @brief Removes @p n bytes from the front of the window (e.g. a header
+ *        consumed by this layer).
+ *
+ * @return Start of the remaining window, or NULL if @p n exceeds the length.
+ */
+uint8_t *mbuf_pull(mbuf_t *b, uint32_t n);
+
+/**
+ * @brief Extends the window @p n bytes into the headroom (e.g. to prepend a
+ *        header).
+ *
+ * @return Start of the extended window, or NULL if the headroom is too small.
+ */
+uint8_t *mbuf_push(mbuf_t *b, uint32_t n);
+
+/**
+ * @brief Shortens the window to @p length bytes (no effect if longer).
+ */
+void mbuf_trim(mbuf_t *b, uint32_t length);
+
+#endif /* ALLOCATOR_MBUF_H */
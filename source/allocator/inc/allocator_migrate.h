@@ -0,0 +1,125 @@
+#ifndef ALLOCATOR_MIGRATE_H
+#define ALLOCATOR_MIGRATE_H
+
+/**
+ * @file allocator_migrate.h
+ * @brief Relocatable blocks migrated between the memory tiers by access
+ *        frequency.
+ *
+ * A block allocated with mig_alloc() is reached through a handle, so the
+ * allocator may move it. Every access through mig_get() counts a touch; at
+ * idle time, mig_rebalance() turns the touches into a decaying heat per block,
+ * moves the hottest blocks of the main pool into the fast tier (see
+ * allocate_tier()) and, to make room, moves colder blocks out of it. The
+ * working set thus ends up in fast memory even when hints at allocation time
+ * were wrong.
+ *
+ * A raw pointer from mig_get() or mig_ptr() is only valid until the next
+ * mig_rebalance(); pin the block with mig_pin() to keep it in place across
+ * one. The module is not thread-safe: call mig_rebalance() from the idle
+ * task while no other task is accessing migrated blocks. The handle table is
+ * not part of an allocator snapshot (see allocator_snapshot.h).
+ */
+
+#include <stdint.h>
+#include "allocator.h"
+
+/** Handle of a relocatable block (index + 1; 0 is the null handle). */
+typedef uint16_t mig_handle_t;
+
+/**
+ * @struct mig_entry_t
+ * @brief Handle table entry. Internal — use the functions below.
+ *
+ * @var mig_entry_t::ptr
+ *      Current location of the block (NULL = free entry).
+ * @var mig_entry_t::size
+ *      Requested size in bytes.
+ * @var mig_entry_t::touches
+ *      Accesses since the last rebalance.
+ * @var mig_entry_t::heat
+ *      Decaying access frequency computed by mig_rebalance().
+ * @var mig_entry_t::pins
+ *      Pin count; a pinned block is never moved.
+ */
+typedef struct {
+    void    *ptr;
+    uint32_t size;
+    uint32_t touches;
+    uint32_t heat;
+    uint16_t pins;
+} mig_entry_t;
+
+/** Handle table. Internal. */
+extern mig_entry_t mig_table[ALLOCATOR_MIGRATE_MAX_HANDLES];
+
+/**
+ * @struct mig_stats_t
+ * @brief Counters of mig_rebalance().
+ */
+typedef struct {
+    uint32_t passes;      /**< mig_rebalance() calls. */
+    uint32_t promotions;  /**< Blocks moved into the fast tier. */
+    uint32_t demotions;   /**< Blocks moved out of the fast tier. */
+    uint32_t bytes_moved; /**< Bytes copied by both. */
+} mig_stats_t;
+
+/**
+ * @brief Allocates a relocatable block.
+ *
+ * @param size Number of bytes (must be > 0).
+ * @param hint Initial placement, ALLOCATOR_TIER_HOT or ALLOCATOR_TIER_COLD.
+ * @return Handle, or 0 if the handle table or the pool is exhausted.
+ */
+mig_handle_t mig_alloc(int size, uint32_t hint);
+
+/**
+ * @brief Frees a relocatable block. 0 is ignored.
+ */
+void mig_free(mig_handle_t h);
+
+/** Current address of a block, without counting an access. */
+static inline void *mig_ptr(mig_handle_t h) {
+    return mig_table[h - 1u].ptr;
+}
+
+/** Current address of a block, counting an access. */
+static inline void *mig_get(mig_handle_t h) {
+    mig_entry_t *e = &mig_table[h - 1u];
+    if (e->touches != UINT32_MAX) ++e->touches;
+    return e->ptr;
+}
+
+/** Keeps a block in place until the matching mig_unpin(). */
+static inline void mig_pin(mig_handle_t h) {
+    ++mig_table[h - 1u].pins;
+}
+
+/** Releases a pin taken with mig_pin(). */
+static inline void mig_unpin(mig_handle_t h) {
+    --mig_table[h - 1u].pins;
+}
+
+/**
+ * @brief Migrates blocks between the tiers according to their heat.
+ *
+ * Halves every block's heat and adds the touches counted since the previous
+ * pass, then promotes the hottest blocks of the main pool while the fast tier
+ * has room, demoting fast-tier blocks that are colder than the candidate.
+ *
+ * @param max_moves Upper bound on the blocks moved (bounds the time spent).
+ * @return Number of blocks moved.
+ */
+uint32_t mig_rebalance(uint32_t max_moves);
+
+/**
+ * @brief Whether a block currently lives in the fast tier.
+ */
+int mig_is_fast(mig_handle_t h);
+
+/**
+ * @brief Copies the counters of mig_rebalance().
+ */
+void mig_get_stats(mig_stats_t *stats);
+
+#endif /* ALLOCATOR_MIGRATE_H */
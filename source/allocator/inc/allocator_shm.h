@@ -0,0 +1,145 @@
+#ifndef ALLOCATOR_SHM_H
+#define ALLOCATOR_SHM_H
+
+/**
+ * @file allocator_shm.h
+ * @brief Allocation arenas in POSIX shared memory (hosted builds).
+ *
+ * A shared arena is a named shared-memory object that holds both the pool and
+ * its metadata: a header, an array of block nodes like the ones of the core
+ * allocator, and the data area. Nothing lives in process memory except the
+ * mapping itself, so any process that opens the arena can allocate and free.
+ *
+ * Each process maps the region at its own address, so blocks are identified
+ * by shm_handle_t offsets into the region; shm_ptr() turns a handle into a
+ * pointer valid in the calling process. Objects linked through handles can be
+ * passed between processes without copying: a producer allocates a message
+ * buffer, fills it and hands over the handle; the consumer reads it in place
+ * and frees it.
+ *
+ * The arena lock and the root reference are C11 atomics in the region.
+ * Lock-free atomics are address-free, so they work across processes mapping
+ * the same memory. A process that dies while holding the lock leaves the
+ * arena locked; the arena does not try to recover from that.
+ *
+ * Blocks start on a cache line and are padded to whole lines, so two
+ * processes writing neighbouring messages do not share a line.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief Reference to a block in a shared arena (offset from the start of the
+ *        region + 1; 0 is the null handle). Same in every process.
+ */
+typedef uint32_t shm_handle_t;
+
+/** Region header, at the start of the shared-memory object. */
+struct shm_header;
+
+/**
+ * @struct shm_arena_t
+ * @brief Process-local view of a shared arena.
+ *
+ * @var shm_arena_t::hdr
+ *      Region header (mapped).
+ * @var shm_arena_t::base
+ *      Address at which this process mapped the region.
+ * @var shm_arena_t::size
+ *      Size of the region in bytes.
+ */
+typedef struct {
+    struct shm_header *hdr;
+    uint8_t *base;
+    size_t size;
+} shm_arena_t;
+
+/**
+ * @struct shm_arena_stats_t
+ * @brief Usage counters of a shared arena (all processes together).
+ */
+typedef struct {
+    uint32_t bytes_in_use;  /**< Bytes in live blocks, padding included. */
+    uint32_t blocks;        /**< Live blocks. */
+    uint32_t allocs;        /**< Successful shm_alloc() calls. */
+    uint32_t frees;         /**< Successful shm_free() calls. */
+    uint32_t failures;      /**< shm_alloc() calls that found no space. */
+} shm_arena_stats_t;
+
+/**
+ * @brief Creates and maps a new shared arena.
+ *
+ * @param arena      Receives the mapping.
+ * @param name       Shared-memory object name ("/name", see shm_open()).
+ * @param size       Size of the region in bytes, metadata included.
+ * @param max_blocks Number of block nodes, i.e. the maximum of live blocks.
+ * @return 0 on success, -1 if the object exists, cannot be created or is too
+ *         small for the metadata.
+ */
+int shm_arena_create(shm_arena_t *arena, const char *name, uint32_t size,
+                     uint32_t max_blocks);
+
+/**
+ * @brief Maps an existing shared arena created by shm_arena_create().
+ *
+ * @return 0 on success, -1 if the object does not exist or is not an arena.
+ */
+int shm_arena_open(shm_arena_t *arena, const char *name);
+
+/**
+ * @brief Unmaps the arena from this process. Handles stay valid for others.
+ */
+void shm_arena_close(shm_arena_t *arena);
+
+/**
+ * @brief Removes the shared-memory object name; the memory is released once
+ *        every process has closed the arena.
+ *
+ * @return 0 on success, -1 on error.
+ */
+int shm_arena_unlink(const char *name);
+
+/**
+ * @brief Allocates a block (first fit, cache-line aligned).
+ *
+ * @param size Number of bytes (must be > 0).
+ * @return Handle of the block, or 0 if the arena is full.
+ */
+shm_handle_t shm_alloc(shm_arena_t *arena, uint32_t size);
+
+/**
+ * @brief Frees a block allocated by any process. 0 and unknown handles are
+ *        ignored.
+ */
+void shm_free(shm_arena_t *arena, shm_handle_t handle);
+
+/**
+ * @brief Sets the root handle, through which other processes find the
+ *        application's data (e.g. a message queue).
+ */
+void shm_set_root(shm_arena_t *arena, shm_handle_t root);
+
+/**
+ * @brief Returns the root handle (0 if not set).
+ */
+shm_handle_t shm_get_root(const shm_arena_t *arena);
+
+/**
+ * @brief Copies the usage counters of the arena.
+ */
+void shm_arena_get_stats(shm_arena_t *arena, shm_arena_stats_t *stats);
+
+/** Converts a handle to a pointer in this process (0 gives NULL). */
+static inline void *shm_ptr(const shm_arena_t *arena, shm_handle_t handle) {
+    if (handle == 0) return NULL;
+    return arena->base + (handle - 1u);
+}
+
+/** Converts a pointer into the mapped region (or NULL) to a handle. */
+static inline shm_handle_t shm_handle(const shm_arena_t *arena, const void *ptr) {
+    if (ptr == NULL) return 0;
+    return (shm_handle_t)((const uint8_t*)ptr - arena->base) + 1u;
+}
+
+#endif /* ALLOCATOR_SHM_H */
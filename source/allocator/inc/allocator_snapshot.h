@@ -0,0 +1,159 @@
+#ifndef ALLOCATOR_SNAPSHOT_H
+#define ALLOCATOR_SNAPSHOT_H
+
+/**
+ * @file allocator_snapshot.h
+ * @brief Persistent allocator state: snapshots and warm restart.
+ *
+ * Two ways to carry a populated heap across a reboot, skipping the
+ * allocation storm of a cold start:
+ *
+ * - Images: allocator_snapshot_write() streams the allocator metadata and the
+ *   pool to any sink (flash, a file, a buffer); allocator_snapshot_read()
+ *   restores it. Free-list links are relocated if the pool now lives at a
+ *   different address (e.g. a position-independent host executable).
+ *
+ * - Retained RAM: build with ALLOCATOR_RETAINED_SECTION naming a section that
+ *   startup code does not clear (".noinit" in the port linker scripts). The
+ *   pool then survives a reset in place; allocator_retain() records the
+ *   metadata next to it and allocator_warm_boot() adopts it after checking
+ *   the block list and free lists, without copying the pool.
+ *
+ * Pointers stored inside pool objects are only valid after a restore if the
+ * pool is at the same address; store allocator_rel_t offsets instead. The
+ * application finds its data again through a root reference saved with the
+ * metadata (allocator_set_root()).
+ *
+ * Only the allocator core is captured: flush per-thread caches and magazines
+ * and drain interrupt pools first, or their blocks stay allocated. The DMA
+ * pool (ALLOCATOR_DMA_MEMORY) and the fast tier (ALLOCATOR_FAST_MEMORY) are
+ * not part of a snapshot: a restore leaves them as they are, and after a
+ * reboot they start empty, so keep nothing there that the restored heap
+ * points to. The handle table of allocator_migrate.h holds raw pointers into
+ * the main pool and the fast tier; after a restore it describes the old heap
+ * (and after a relocated one its pointers dangle), so do not use or free
+ * handles from before the restore. Neither call may run concurrently with
+ * other allocator use.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include "allocator.h"
+
+/**
+ * @brief Pool-relative reference to an allocated object (offset + 1; 0 is
+ *        the null reference). Survives relocation of the pool.
+ */
+typedef uint32_t allocator_rel_t;
+
+/** Converts a pointer into the pool (or NULL) to a relative reference. */
+static inline allocator_rel_t allocator_ptr_to_rel(const void *ptr) {
+    if (ptr == NULL) return 0;
+    return (allocator_rel_t)((uintptr_t)ptr - (uintptr_t)allocator_pool_base) + 1u;
+}
+
+/** Converts a relative reference back to a pointer (0 gives NULL). */
+static inline void *allocator_rel_to_ptr(allocator_rel_t rel) {
+    if (rel == 0) return NULL;
+    return allocator_pool_base + (rel - 1u);
+}
+
+/**
+ * @brief Sets the root reference saved with the metadata, typically the
+ *        object from which the application reaches the rest of its heap.
+ */
+void allocator_set_root(allocator_rel_t root);
+
+/**
+ * @brief Returns the root reference (restored by a snapshot or warm boot).
+ */
+allocator_rel_t allocator_get_root(void);
+
+/**
+ * @brief Output callback of allocator_snapshot_write().
+ * @return 0 on success, nonzero to abort.
+ */
+typedef int (*allocator_snapshot_write_fn)(void *ctx, const void *data, size_t len);
+
+/**
+ * @brief Input callback of allocator_snapshot_read().
+ * @return 0 if exactly @p len bytes were read, nonzero otherwise.
+ */
+typedef int (*allocator_snapshot_read_fn)(void *ctx, void *data, size_t len);
+
+/**
+ * @brief Size of a snapshot image in bytes (metadata plus pool).
+ */
+size_t allocator_snapshot_size(void);
+
+/**
+ * @brief Streams a snapshot image of the allocator.
+ *
+ * @param write Output callback.
+ * @param ctx   Passed to @p write.
+ * @return 0 on success, -1 if @p write failed.
+ */
+int allocator_snapshot_write(allocator_snapshot_write_fn write, void *ctx);
+
+/**
+ * @brief Replaces the allocator state with a snapshot image.
+ *
+ * The metadata is checked (format, configuration, checksum) before anything
+ * is changed; if the image is rejected the current state is kept. If the pool
+ * part cannot be read completely, the allocator is reset to empty.
+ *
+ * @param read Input callback.
+ * @param ctx  Passed to @p read.
+ * @return 0 on success, -1 on an invalid or truncated image.
+ */
+int allocator_snapshot_read(allocator_snapshot_read_fn read, void *ctx);
+
+/**
+ * @brief Writes a snapshot image into a buffer.
+ *
+ * @return Bytes written, or 0 if @p len < allocator_snapshot_size().
+ */
+size_t allocator_snapshot_save(void *buf, size_t len);
+
+/**
+ * @brief Restores a snapshot image from a buffer.
+ *
+ * @return 0 on success, -1 on an invalid or truncated image.
+ */
+int allocator_snapshot_restore(const void *buf, size_t len);
+
+/**
+ * @brief Records the current metadata next to the pool in retained RAM.
+ *
+ * Call right before a planned reset. The record only describes the heap as
+ * it is now: the first change after the call (any allocation or free that
+ * reaches the allocator core, or allocator_set_root()) discards it, and
+ * allocator_warm_boot() then starts cold.
+ */
+void allocator_retain(void);
+
+/**
+ * @brief Adopts the metadata recorded by allocator_retain(), if valid.
+ *
+ * Call once at boot before any allocation. The block list, the large runs
+ * and the free lists are checked against the pool first; if they do not
+ * match, the allocator starts empty. The record is consumed, so a later reset
+ * without a new allocator_retain() starts cold.
+ *
+ * @return 1 if the previous heap was adopted, 0 if the allocator starts empty.
+ */
+int allocator_warm_boot(void);
+
+/**
+ * @brief Saves a snapshot image to a file (hosted builds).
+ * @return 0 on success, -1 on I/O error.
+ */
+int allocator_snapshot_save_file(const char *path);
+
+/**
+ * @brief Restores a snapshot image from a file (hosted builds).
+ * @return 0 on success, -1 on I/O error or an invalid image.
+ */
+int allocator_snapshot_load_file(const char *path);
+
+#endif /* ALLOCATOR_SNAPSHOT_H */
@@ -0,0 +1,143 @@
+#ifndef ALLOCATOR_TCACHE_H
+#define ALLOCATOR_TCACHE_H
+
+/**
+ * @file allocator_tcache.h
+ * @brief Per-thread caches with remote-free queues for cross-thread frees.
+ *
+ * A thread cache owns whole slabs: tcache_alloc() and tcache_free() of its
+ * own blocks touch only the cache's private free lists, with no locks and no
+ * atomics. A block freed by another thread is not pushed onto the owner's
+ * lists (which would bounce their cache lines between cores); instead it is
+ * pushed onto the owner's remote-free queue, a lock-free stack that the owner
+ * takes over in one exchange when its private list for a class runs dry, or
+ * when tcache_collect() is called.
+ *
+ * Each thread initializes its own allocator_tcache_t and passes it to every
+ * call. Blocks from a thread cache may be freed with tcache_free() by any
+ * thread, or with deallocate()/deallocate_fast(); blocks from allocate() or
+ * allocate_fast() may also be given to tcache_free().
+ */
+
+#include <stdint.h>
+#include "allocator.h"
+
+/**
+ * @struct allocator_tcache_t
+ * @brief Private allocation state of one thread.
+ *
+ * @var allocator_tcache_t::free
+ *      Free lists of the cache's own slabs, one per size class.
+ * @var allocator_tcache_t::owner
+ *      Owner tag of the cache's slabs (1 .. ALLOCATOR_TCACHE_MAX).
+ * @var allocator_tcache_t::remote_sent
+ *      Blocks this thread freed to other caches' remote queues.
+ * @var allocator_tcache_t::remote_received
+ *      Blocks taken back from this cache's remote queue.
+ * @var allocator_tcache_t::collects
+ *      Number of non-empty remote queue takeovers.
+ */
+typedef struct {
+    allocator_free_block_t *free[ALLOCATOR_NUM_CLASSES];
+    uint32_t owner;
+    uint32_t remote_sent;
+    uint32_t remote_received;
+    uint32_t collects;
+} allocator_tcache_t;
+
+/**
+ * @brief Registers a thread cache.
+ *
+ * @param tc Cache to initialize (owned by the calling thread).
+ * @return 0 on success, -1 if ALLOCATOR_TCACHE_MAX caches are already alive.
+ */
+int tcache_init(allocator_tcache_t *tc);
+
+/**
+ * @brief Unregisters a thread cache.
+ *
+ * Gives the cache's slabs and free blocks to the shared size-class lists,
+ * where allocator_trim() can reclaim them. Blocks still in use stay valid and
+ * may be freed by any thread.
+ *
+ * @param tc Cache to release.
+ */
+void tcache_destroy(allocator_tcache_t *tc);
+
+/**
+ * @brief Moves every block on the cache's remote-free queue to its free lists.
+ *
+ * @param tc Cache of the calling thread.
+ * @return Number of blocks collected.
+ */
+uint32_t tcache_collect(allocator_tcache_t *tc);
+
+/**
+ * @brief Slow path of tcache_alloc(): collects remote frees or carves a slab.
+ *
+ * @param tc  Cache of the calling thread.
+ * @param cls Size class whose private list is empty.
+ * @return Pointer to a block of the class, or NULL if the pool is exhausted.
+ */
+int *tcache_refill(allocator_tcache_t *tc, uint32_t cls);
+
+/**
+ * @brief Slow path of tcache_free(): blocks the cache does not own.
+ *
+ * @param tc    Cache of the calling thread.
+ * @param ptr   Block to free.
+ * @param owner Owner tag of the block's slab (0 = shared slab or no slab).
+ */
+void tcache_free_foreign(allocator_tcache_t *tc, int *ptr, uint32_t owner);
+
+/**
+ * @brief Allocates a block through the thread cache.
+ *
+ * Requests larger than ALLOCATOR_SMALL_MAX fall back to allocate().
+ *
+ * @param tc   Cache of the calling thread.
+ * @param size Number of bytes to allocate (must be > 0).
+ * @return Pointer to allocated memory, or NULL if allocation fails.
+ */
+ALLOCATOR_INLINE int *tcache_alloc(allocator_tcache_t *tc, int size) {
+    uint32_t req = (uint32_t)size;
+    if (ALLOCATOR_LIKELY(req - 1u < ALLOCATOR_SMALL_MAX)) {
+        uint32_t cls = allocator_size_class(req);
+        allocator_free_block_t *b = tc->free[cls];
+        if (ALLOCATOR_LIKELY(b != NULL)) {
+            tc->free[cls] = b->next;
+            return (int*)(void*)b;
+        }
+        return tcache_refill(tc, cls);
+    }
+    return allocate(size);
+}
+
+/**
+ * @brief Frees a block from any thread.
+ *
+ * Blocks owned by @p tc go onto its private list; blocks owned by another
+ * cache go onto that cache's remote-free queue; anything else is passed on to
+ * deallocate_fast().
+ *
+ * @param tc  Cache of the calling thread.
+ * @param ptr Block to free (NULL is ignored).
+ */
+ALLOCATOR_INLINE void tcache_free(allocator_tcache_t *tc, int *ptr) {
+    uintptr_t off = (uintptr_t)ptr - (uintptr_t)allocator_pool_base;
+    uint32_t owner = 0;
+    if (ALLOCATOR_LIKELY(off < ALLOCATOR_TOTAL_MEMORY)) {
+        owner = atomic_load_explicit(&allocator_slab_owner[off >> ALLOCATOR_SLAB_SHIFT],
+                                     memory_order_relaxed);
+        if (ALLOCATOR_LIKELY(owner == tc->owner)) {
+            uint32_t cls = allocator_slab_class[off >> ALLOCATOR_SLAB_SHIFT] - 1u;
+            allocator_free_block_t *b = (allocator_free_block_t*)(void*)ptr;
+            b->next = tc->free[cls];
+            tc->free[cls] = b;
+            return;
+        }
+    }
+    tcache_free_foreign(tc, ptr, owner);
+}
+
+#endif /* ALLOCATOR_TCACHE_H */
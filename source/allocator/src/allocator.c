@@ -9,8 +9,13 @@
  */
 
 #include "allocator.h"
+#include "allocator_classes.h"
+#include "allocator_config.h"
+#include "allocator_lock.h"
+#include "allocator_snapshot.h"
 #include <stdint.h>
 #include <stddef.h>
+#include <string.h>
 
 /* ---------------------------------------------------------------------------- */
 /*                           Configuration Constants                            */
@@ -20,13 +25,13 @@
  * @def TOTAL_MEMORY
  * @brief Total managed memory in bytes (pool + optional metadata).
  */
-#define TOTAL_MEMORY   (100u * 1024u)  /**< 100 KB */
+#define TOTAL_MEMORY   ALLOCATOR_TOTAL_MEMORY
 
 /**
  * @def MAX_NODES
  * @brief Maximum number of allocation metadata entries.
  */
-#define MAX_NODES      96
+#define MAX_NODES      ALLOCATOR_MAX_NODES
 
 /**
  * @def NODE_POOL_BYTES
@@ -34,6 +39,26 @@
  */
 #define NODE_POOL_BYTES  ((uint32_t)(MAX_NODES * (uint32_t)sizeof(alloc_node_t)))
 
+/**
+ * @def ALIGN_UP
+ * @brief Rounds @p x up to a multiple of the power of two @p a.
+ */
+#define ALIGN_UP(x, a)   (((x) + ((uint32_t)(a) - 1u)) & ~((uint32_t)(a) - 1u))
+
+/**
+ * @def USABLE_BASE
+ * @brief Offset of the first byte available for blocks (after the metadata).
+ */
+#define USABLE_BASE      ALIGN_UP(NODE_POOL_BYTES, ALLOCATOR_ALIGNMENT)
+
+/**
+ * @def PAGE_SHIFT
+ * @brief log2 of the page size of large-object runs (a slab frame).
+ */
+#define PAGE_SHIFT       ALLOCATOR_SLAB_SHIFT
+#define PAGE_BYTES       ALLOCATOR_SLAB_BYTES
+#define PAGE_COUNT       ALLOCATOR_SLAB_COUNT
+
 /* ---------------------------------------------------------------------------- */
 /*                              Internal Data Types                             */
 /* ---------------------------------------------------------------------------- */
@@ -73,8 +98,44 @@ typedef union {
 /*                                 Internal State                               */
 /* ---------------------------------------------------------------------------- */
 
-/** Primary memory pool. */
-static ram_block_t g_mem;
+/**
+ * @def RETAINED
+ * @brief Places the pool and its retained metadata in ALLOCATOR_RETAINED_SECTION.
+ */
+#ifdef ALLOCATOR_RETAINED_SECTION
+#define RETAINED __attribute__((section(ALLOCATOR_RETAINED_SECTION)))
+#else
+#define RETAINED
+#endif
+
+/**
+ * @def HAVE_REGIONS
+ * @brief Whether any secondary region (DMA pool, fast tier) is configured.
+ */
+#define HAVE_REGIONS  (ALLOCATOR_DMA_MEMORY > 0u || ALLOCATOR_FAST_MEMORY > 0u)
+
+/**
+ * @def FAST_SECTION
+ * @brief Places the fast tier in ALLOCATOR_FAST_SECTION.
+ */
+#ifdef ALLOCATOR_FAST_SECTION
+#define FAST_SECTION __attribute__((section(ALLOCATOR_FAST_SECTION)))
+#else
+#define FAST_SECTION
+#endif
+
+/**
+ * @def DMA_SECTION
+ * @brief Places the DMA pool in ALLOCATOR_DMA_SECTION.
+ */
+#ifdef ALLOCATOR_DMA_SECTION
+#define DMA_SECTION __attribute__((section(ALLOCATOR_DMA_SECTION)))
+#else
+#define DMA_SECTION
+#endif
+
+/** Primary memory pool, aligned so that slab frames are slab-aligned in memory. */
+static RETAINED _Alignas(ALLOCATOR_SLAB_BYTES) ram_block_t g_mem;
 
 /** Pointer to carved metadata area (NULL if uninitialized). */
 static alloc_node_t *node_pool = NULL;
@@ -82,8 +143,378 @@ static alloc_node_t *node_pool = NULL;
 /** Index of first allocated block in sorted list (-1 if empty). */
 static int32_t head_index = -1;
 
-/** Flag indicating the entire memory pool is allocated in one block. */
-static uint8_t full_taken = 0;
+/** Index of the last block of the list (-1 if empty). */
+static int32_t tail_index = -1;
+
+/**
+ * Upper bound on the size of the holes: the gaps below the last block of the
+ * list. Above it, up to large_floor, lies the wilderness, which is never
+ * fragmented.
+ */
+static uint32_t hole_bound = 0;
+
+/** First unused metadata slot (-1 = none); unused slots are chained by next. */
+static int32_t free_slot = -1;
+
+/**
+ * Start of the large-object area: the lowest live run, or TOTAL_MEMORY if
+ * there is none. Blocks of the list stay below it.
+ */
+static uint32_t large_floor = TOTAL_MEMORY;
+
+/** Length in pages of the live large run starting at each page (0 = none). */
+static uint16_t large_run[PAGE_COUNT];
+
+/**
+ * Blocks of the list of at least this size are placed from the high end
+ * (UINT32_MAX = first fit for all); see allocator_set_placement().
+ */
+static uint32_t pool_split = ALLOCATOR_PLACEMENT_SPLIT ? ALLOCATOR_PLACEMENT_SPLIT : UINT32_MAX;
+
+/** Number of slabs currently carved for the size-class free lists. */
+static uint32_t slab_count = 0;
+
+/** Color (first block offset, in granules) of each slab frame. */
+static uint8_t slab_color[ALLOCATOR_SLAB_COUNT];
+
+/** Color given to the next slab of each size class, in bytes. */
+static uint32_t next_color[ALLOCATOR_NUM_CLASSES];
+
+/**
+ * @struct region_t
+ * @brief Secondary pool (DMA, fast tier) with its own block list. Its
+ *        metadata stays in ordinary memory. Protected by ALLOCATOR_LOCK_CORE.
+ *
+ * @var region_t::base
+ *      Start of the region.
+ * @var region_t::size
+ *      Size of the region in bytes.
+ * @var region_t::nodes
+ *      Block metadata (size 0 = unused slot).
+ * @var region_t::max_nodes
+ *      Number of entries in @c nodes.
+ * @var region_t::head
+ *      First block in offset order (-1 if empty).
+ * @var region_t::used
+ *      Bytes in live blocks.
+ * @var region_t::split
+ *      Blocks of at least this size are placed from the high end
+ *      (UINT32_MAX = never); see allocator_set_placement().
+ */
+typedef struct {
+    uint8_t      *base;
+    uint32_t      size;
+    alloc_node_t *nodes;
+    uint32_t      max_nodes;
+    int32_t       head;
+    uint32_t      used;
+    uint32_t      split;
+} region_t;
+
+#if ALLOCATOR_DMA_MEMORY > 0u
+static DMA_SECTION _Alignas(ALLOCATOR_CACHE_LINE) uint8_t dma_mem[ALLOCATOR_DMA_MEMORY];
+static alloc_node_t dma_nodes[ALLOCATOR_DMA_MAX_NODES];
+
+/** Pool reserved for allocate_dma(). */
+static region_t dma_region = {
+    dma_mem, ALLOCATOR_DMA_MEMORY, dma_nodes, ALLOCATOR_DMA_MAX_NODES, -1, 0, UINT32_MAX
+};
+#endif
+
+#if ALLOCATOR_FAST_MEMORY > 0u
+static FAST_SECTION _Alignas(ALLOCATOR_CACHE_LINE) uint8_t fast_mem[ALLOCATOR_FAST_MEMORY];
+static alloc_node_t fast_nodes[ALLOCATOR_FAST_MAX_NODES];
+
+/** Fast tier for allocate_tier(). */
+static region_t fast_region = {
+    fast_mem, ALLOCATOR_FAST_MEMORY, fast_nodes, ALLOCATOR_FAST_MAX_NODES, -1, 0, UINT32_MAX
+};
+#endif
+
+/** Placement counters of allocate_tier(). */
+static allocator_tier_stats_t tier_stats;
+
+/** Counters of allocate_hint(). */
+static allocator_life_stats_t life_stats;
+
+#if ALLOCATOR_SITE_LIFETIMES
+/**
+ * @struct site_t
+ * @brief Lifetime statistics of one call site of allocate().
+ *
+ * @var site_t::pc
+ *      Return address of the call (0 = unused entry).
+ * @var site_t::mean
+ *      Moving average of the measured lifetimes, in allocate() calls.
+ * @var site_t::samples
+ *      Lifetimes measured, saturating.
+ */
+typedef struct {
+    uintptr_t pc;
+    uint32_t  mean;
+    uint16_t  samples;
+} site_t;
+
+/**
+ * @struct site_sample_t
+ * @brief A block whose lifetime is being measured.
+ *
+ * @var site_sample_t::off
+ *      Offset of the block (0 = unused entry; no block starts there).
+ * @var site_sample_t::birth
+ *      Value of site_clock when it was allocated.
+ * @var site_sample_t::site
+ *      Index of its site in sites[].
+ */
+typedef struct {
+    uint32_t off;
+    uint32_t birth;
+    uint32_t site;
+} site_sample_t;
+
+/** Call sites, open addressing on the return address. */
+static site_t sites[ALLOCATOR_SITE_SLOTS];
+
+/** Blocks being measured. */
+static site_sample_t site_samples[ALLOCATOR_SITE_SAMPLES];
+
+/** Number of entries of site_samples[] in use. */
+static uint32_t site_pending;
+
+/** Calls of allocate() that reached the block list: the lifetime clock. */
+static uint32_t site_clock;
+
+/** Counters reported by allocator_get_site_stats(). */
+static uint32_t site_measured, site_routed;
+#endif
+
+/* The fast path in allocator.h reads these directly. */
+allocator_free_block_t *allocator_class_free[ALLOCATOR_NUM_CLASSES];
+uint8_t allocator_slab_class[ALLOCATOR_SLAB_COUNT];
+_Atomic uint8_t allocator_slab_owner[ALLOCATOR_SLAB_COUNT];
+uint32_t allocator_slab_busy[ALLOCATOR_SLAB_COUNT][ALLOCATOR_SLAB_MAP_WORDS];
+uint8_t *const allocator_pool_base = g_mem.raw;
+_Atomic uint8_t allocator_retained;
+
+#if ALLOCATOR_ADAPTIVE_CLASSES
+/* All zero: the default layout until allocator_classes_apply(). */
+uint8_t allocator_class_index[ALLOCATOR_CLASS_BUCKETS];
+uint16_t allocator_class_bytes[ALLOCATOR_NUM_CLASSES];
+_Atomic uint32_t allocator_size_hist[ALLOCATOR_CLASS_BUCKETS + 1u];
+#elif ALLOCATOR_CLASS_TABLES
+const uint8_t allocator_class_index[ALLOCATOR_CLASS_BUCKETS] = ALLOCATOR_CLASS_INDEX;
+const uint16_t allocator_class_bytes[ALLOCATOR_NUM_CLASSES] = ALLOCATOR_CLASS_TABLE;
+#endif
+
+/* ---------------------------------------------------------------------------- */
+/*                              Segment Tree Backend                            */
+/* ---------------------------------------------------------------------------- */
+
+#if ALLOCATOR_BACKEND_SEGTREE
+
+/**
+ * @def SEG_GRANULES
+ * @brief Granules (ALLOCATOR_ALIGNMENT bytes) of the pool, one bit each.
+ */
+#define SEG_GRANULES  (TOTAL_MEMORY / (uint32_t)ALLOCATOR_ALIGNMENT)
+
+/**
+ * @def SEG_LEAVES
+ * @brief Leaves of the tree: 64-bit words of the bitmap, rounded up to a
+ *        power of two.
+ */
+#define SEG_WORDS         ((SEG_GRANULES + 63u) / 64u)
+#define SEG_OR_SHIFT(v, s) ((v) | ((v) >> (s)))
+#define SEG_LEAVES        (SEG_OR_SHIFT(SEG_OR_SHIFT(SEG_OR_SHIFT(SEG_OR_SHIFT(SEG_OR_SHIFT( \
+                               SEG_WORDS - 1u, 1), 2), 4), 8), 16) + 1u)
+
+_Static_assert(SEG_GRANULES <= UINT16_MAX,
+               "ALLOCATOR_BACKEND_SEGTREE needs at most 65535 granules in the pool");
+
+/**
+ * @struct seg_node_t
+ * @brief Free runs among the granules under a node of the tree.
+ *
+ * @var seg_node_t::pre
+ *      Free granules at the low end.
+ * @var seg_node_t::suf
+ *      Free granules at the high end.
+ * @var seg_node_t::max
+ *      Longest free run.
+ */
+typedef struct {
+    uint16_t pre;
+    uint16_t suf;
+    uint16_t max;
+} seg_node_t;
+
+/**
+ * One bit per granule, set while the granule is not available to the block
+ * list: live blocks, the node pool, everything from large_floor up and the
+ * padding after the pool.
+ */
+static uint64_t seg_used[SEG_LEAVES];
+
+/** Node i has children 2i and 2i + 1; word w of seg_used[] is leaf SEG_LEAVES + w. */
+static seg_node_t seg_tree[2u * SEG_LEAVES];
+
+/** Whether seg_used[] and seg_tree[] have been built since the last reset. */
+static uint8_t seg_ready;
+
+/** Index of the lowest set bit of @p w (not 0). */
+static uint32_t seg_ctz(uint64_t w) {
+#if defined(__GNUC__) || defined(__clang__)
+    return (uint32_t)__builtin_ctzll(w);
+#else
+    uint32_t n = 0;
+    while ((w & 1u) == 0) { w >>= 1; ++n; }
+    return n;
+#endif
+}
+
+/** Number of clear bits above the highest set bit of @p w (not 0). */
+static uint32_t seg_clz(uint64_t w) {
+#if defined(__GNUC__) || defined(__clang__)
+    return (uint32_t)__builtin_clzll(w);
+#else
+    uint32_t n = 0;
+    while ((w >> 63) == 0) { w <<= 1; ++n; }
+    return n;
+#endif
+}
+
+/** Recomputes the leaf of bitmap word @p w. */
+static void seg_leaf(uint32_t w) {
+    uint64_t used = seg_used[w];
+    seg_node_t *n = &seg_tree[SEG_LEAVES + w];
+    n->pre = (uint16_t)(used ? seg_ctz(used) : 64u);
+    n->suf = (uint16_t)(used ? seg_clz(used) : 64u);
+
+    /* Jump from one free run to the next */
+    uint32_t longest = 0;
+    for (uint64_t free = ~used; free != 0; ) {
+        free >>= seg_ctz(free);
+        uint32_t len = (~free == 0) ? 64u : seg_ctz(~free);
+        if (len > longest) longest = len;
+        if (len == 64u) break;
+        free >>= len;
+    }
+    n->max = (uint16_t)longest;
+}
+
+/**
+ * @brief Recomputes inner node @p i, whose children cover @p half granules
+ *        each.
+ *
+ * @return Whether the node changed.
+ */
+static int seg_pull(uint32_t i, uint32_t half) {
+    const seg_node_t *l = &seg_tree[2u * i];
+    const seg_node_t *r = &seg_tree[2u * i + 1u];
+    seg_node_t *n = &seg_tree[i];
+    seg_node_t old = *n;
+    n->pre = (uint16_t)((l->pre == half) ? half + r->pre : l->pre);
+    n->suf = (uint16_t)((r->suf == half) ? half + l->suf : r->suf);
+    uint32_t longest = (uint32_t)l->suf + r->pre;
+    if (l->max > longest) longest = l->max;
+    if (r->max > longest) longest = r->max;
+    n->max = (uint16_t)longest;
+    return n->pre != old.pre || n->suf != old.suf || n->max != old.max;
+}
+
+/** Sets or clears the bits of granules [first, end), without touching the tree. */
+static void seg_set_bits(uint32_t first, uint32_t end, int used) {
+    for (uint32_t g = first; g < end; ) {
+        uint32_t bit = g & 63u;
+        uint32_t n = (end - g < 64u - bit) ? end - g : 64u - bit;
+        uint64_t mask = (n == 64u) ? ~(uint64_t)0 : (((uint64_t)1 << n) - 1u) << bit;
+        if (used) seg_used[g >> 6] |= mask;
+        else seg_used[g >> 6] &= ~mask;
+        g += n;
+    }
+}
+
+/**
+ * @brief Marks the bytes [start, end) of the pool as used or free and
+ *        updates the nodes above them.
+ */
+static void seg_mark(uint32_t start, uint32_t end, int used) {
+    uint32_t first = start / (uint32_t)ALLOCATOR_ALIGNMENT;
+    uint32_t last  = end / (uint32_t)ALLOCATOR_ALIGNMENT;
+    if (first >= last) return;
+    seg_set_bits(first, last, used);
+
+    uint32_t lo = first >> 6;
+    uint32_t hi = (last - 1u) >> 6;
+    for (uint32_t w = lo; w <= hi; ++w) seg_leaf(w);
+    lo += SEG_LEAVES;
+    hi += SEG_LEAVES;
+    for (uint32_t half = 64u; lo > 1u; half *= 2u) {
+        lo >>= 1;
+        hi >>= 1;
+        int changed = 0;
+        for (uint32_t i = lo; i <= hi; ++i) changed |= seg_pull(i, half);
+        if (!changed) break;  /* the nodes above depend only on these */
+    }
+}
+
+/**
+ * @brief Rebuilds the tree for an empty block list below large_floor.
+ */
+static void seg_reset(void) {
+    seg_ready = 1;
+    for (uint32_t w = 0; w < SEG_LEAVES; ++w) seg_used[w] = 0;
+    seg_set_bits(0, USABLE_BASE / (uint32_t)ALLOCATOR_ALIGNMENT, 1);
+    seg_set_bits(large_floor / (uint32_t)ALLOCATOR_ALIGNMENT, SEG_LEAVES * 64u, 1);
+
+    for (uint32_t w = 0; w < SEG_LEAVES; ++w) seg_leaf(w);
+    for (uint32_t lo = SEG_LEAVES / 2u, half = 64u; lo != 0; lo /= 2u, half *= 2u) {
+        for (uint32_t i = lo; i < 2u * lo; ++i) seg_pull(i, half);
+    }
+}
+
+/**
+ * @brief Lowest gap of the block list that can hold @p req bytes.
+ *
+ * Fails in constant time when the root has no run long enough; otherwise
+ * descends to the lowest one, preferring a run in the left child, then one
+ * straddling both children, then the right child.
+ *
+ * @param req Block size in bytes (a multiple of ALLOCATOR_ALIGNMENT).
+ * @return Offset of the gap, or UINT32_MAX if none fits.
+ */
+static uint32_t seg_find(uint32_t req) {
+    uint32_t need = req / (uint32_t)ALLOCATOR_ALIGNMENT;
+    if (seg_tree[1].max < need) return UINT32_MAX;
+
+    uint32_t i = 1;
+    uint32_t base = 0;
+    uint32_t len = SEG_LEAVES * 64u;
+    while (i < SEG_LEAVES) {
+        len /= 2u;
+        const seg_node_t *l = &seg_tree[2u * i];
+        if (l->max >= need) {
+            i = 2u * i;
+        } else if ((uint32_t)l->suf + seg_tree[2u * i + 1u].pre >= need) {
+            return (base + len - l->suf) * (uint32_t)ALLOCATOR_ALIGNMENT;
+        } else {
+            i = 2u * i + 1u;
+            base += len;
+        }
+    }
+
+    /* Within one word: bit k of fits ends up set if granules k .. k+need-1
+     * are free, doubling the length checked at each step */
+    uint64_t fits = ~seg_used[i - SEG_LEAVES];
+    for (uint32_t covered = 1; covered < need; ) {
+        uint32_t step = (need - covered < covered) ? need - covered : covered;
+        fits &= fits >> step;
+        covered += step;
+    }
+    return (base + seg_ctz(fits)) * (uint32_t)ALLOCATOR_ALIGNMENT;
+}
+
+#endif /* ALLOCATOR_BACKEND_SEGTREE */
 
 /* ---------------------------------------------------------------------------- */
 /*                                 Internal Helpers                             */
@@ -92,24 +523,29 @@ static uint8_t full_taken = 0;
 /**
  * @brief Lazily initializes metadata by carving it from the start of g_mem.raw[].
  *
- * Called only when the first non-special allocation occurs.
- * If the full memory pool is already taken or there is insufficient space,
- * metadata is not initialized.
+ * Called only when the first block of the list is allocated. If large runs
+ * leave no room for the metadata, it is not initialized.
  */
-static void ensure_node_pool(void) {
+ALLOCATOR_SLOW_PATH static void ensure_node_pool(void) {
     if (node_pool != NULL) return;                  /* already initialized */
-    if (full_taken) return;                         /* can't carve if full buffer taken */
-    if (NODE_POOL_BYTES >= TOTAL_MEMORY) return;    /* not enough space */
+    if (NODE_POOL_BYTES >= large_floor) return;     /* not enough space */
 
     node_pool = (alloc_node_t*)(void*)g_mem.raw;
 
-    /* Mark all metadata slots as unused */
+    /* Mark all metadata slots as unused and chain them */
     for (uint32_t i = 0; i < MAX_NODES; ++i) {
         node_pool[i].offset = 0;
         node_pool[i].size   = 0;
-        node_pool[i].next   = -1;
+        node_pool[i].next   = (i + 1u < MAX_NODES) ? (int32_t)(i + 1u) : -1;
     }
+    free_slot = 0;
     head_index = -1;
+    tail_index = -1;
+    hole_bound = 0;
+#if ALLOCATOR_BACKEND_SEGTREE
+    /* An empty list leaves the tree as it was built; large runs keep it current */
+    if (!seg_ready) seg_reset();
+#endif
 }
 
 /**
@@ -118,19 +554,83 @@ static void ensure_node_pool(void) {
  * @return Index of a free metadata slot, or -1 if none are available.
  */
 static int32_t node_slot_alloc(void) {
-    for (uint32_t i = 0; i < MAX_NODES; ++i) {
-        if (node_pool[i].size == 0) return (int32_t)i;
+    int32_t idx = free_slot;
+    if (idx != -1) free_slot = node_pool[idx].next;
+    return idx;
+}
+
+/**
+ * @brief Marks a metadata slot (already unlinked from the list) as unused.
+ */
+static void node_slot_free(int32_t idx) {
+    allocator_heap_changed();
+#if ALLOCATOR_BACKEND_SEGTREE
+    seg_mark(node_pool[idx].offset, node_pool[idx].offset + node_pool[idx].size, 0);
+#endif
+    node_pool[idx].size   = 0;
+    node_pool[idx].offset = 0;
+    node_pool[idx].next   = free_slot;
+    free_slot = idx;
+}
+
+/**
+ * @brief Start of the wilderness: the end of the last block of the list.
+ */
+static uint32_t wild_start(void) {
+    if (tail_index == -1) return USABLE_BASE;
+    return node_pool[tail_index].offset + node_pool[tail_index].size;
+}
+
+/**
+ * @brief Rebuilds the tail, hole bound and unused-slot chain (and the segment
+ *        tree) from the list, for metadata adopted from a snapshot.
+ */
+static void list_index_rebuild(void) {
+    uint32_t gap_start = USABLE_BASE;
+    tail_index = -1;
+    hole_bound = 0;
+#if ALLOCATOR_BACKEND_SEGTREE
+    seg_reset();
+#endif
+    for (int32_t cur = head_index; cur != -1; cur = node_pool[cur].next) {
+#if ALLOCATOR_BACKEND_SEGTREE
+        seg_mark(node_pool[cur].offset, node_pool[cur].offset + node_pool[cur].size, 1);
+#endif
+        uint32_t gap_end = node_pool[cur].offset;
+        if (gap_end > gap_start && gap_end - gap_start > hole_bound) {
+            hole_bound = gap_end - gap_start;
+        }
+        gap_start = gap_end + node_pool[cur].size;
+        tail_index = cur;
+    }
+    free_slot = -1;
+    for (uint32_t i = MAX_NODES; i-- > 0; ) {
+        if (node_pool[i].size != 0) continue;
+        node_pool[i].next = free_slot;
+        free_slot = (int32_t)i;
     }
-    return -1;
 }
 
 /**
  * @brief Inserts a node into the linked list of allocations in offset order.
  *
+ * Appending after the last block takes constant time.
+ *
  * @param idx Index of the metadata node to insert.
  */
 static void list_insert_sorted(int32_t idx) {
-    if (head_index == -1 || node_pool[idx].offset < node_pool[head_index].offset) {
+    uint32_t off = node_pool[idx].offset;
+    if (tail_index == -1 || off > node_pool[tail_index].offset) {
+        /* The part of the wilderness skipped over becomes a hole */
+        uint32_t skipped = off - wild_start();
+        if (skipped > hole_bound) hole_bound = skipped;
+        node_pool[idx].next = -1;
+        if (tail_index == -1) head_index = idx;
+        else node_pool[tail_index].next = idx;
+        tail_index = idx;
+        return;
+    }
+    if (node_pool[idx].offset < node_pool[head_index].offset) {
         node_pool[idx].next = head_index;
         head_index = idx;
         return;
@@ -155,9 +655,22 @@ static int32_t list_remove_by_offset(uint32_t off) {
     int32_t cur = head_index;
     while (cur != -1) {
         if (node_pool[cur].offset == off) {
-            if (prev == -1) head_index = node_pool[cur].next;
-            else node_pool[prev].next = node_pool[cur].next;
+            int32_t nxt = node_pool[cur].next;
+            if (prev == -1) head_index = nxt;
+            else node_pool[prev].next = nxt;
             node_pool[cur].next = -1;
+
+            if (nxt == -1) {
+                /* The wilderness grows down to the previous block */
+                tail_index = prev;
+                if (prev == -1) hole_bound = 0;
+            } else {
+                uint32_t start = (prev == -1) ? USABLE_BASE
+                                              : node_pool[prev].offset + node_pool[prev].size;
+                if (node_pool[nxt].offset - start > hole_bound) {
+                    hole_bound = node_pool[nxt].offset - start;
+                }
+            }
             return cur;
         }
         prev = cur;
@@ -166,123 +679,1831 @@ static int32_t list_remove_by_offset(uint32_t off) {
     return -1;
 }
 
+/**
+ * @brief Takes every class lock and the core lock, in lock order.
+ */
+static void lock_all(void) {
+    for (uint32_t cls = 0; cls < ALLOCATOR_NUM_CLASSES; ++cls) {
+        allocator_lock(ALLOCATOR_LOCK_CLASS(cls));
+    }
+    allocator_lock(ALLOCATOR_LOCK_CORE);
+}
+
+/**
+ * @brief Releases the locks taken by lock_all().
+ */
+static void unlock_all(void) {
+    allocator_unlock(ALLOCATOR_LOCK_CORE);
+    for (uint32_t cls = ALLOCATOR_NUM_CLASSES; cls-- > 0; ) {
+        allocator_unlock(ALLOCATOR_LOCK_CLASS(cls));
+    }
+}
+
 /**
  * @brief Resets node_pool to NULL when all allocations are freed.
  */
-static void try_uncarve_when_empty(void) {
+ALLOCATOR_SLOW_PATH static void try_uncarve_when_empty(void) {
     if (head_index != -1) return; /* still in use */
     node_pool = NULL;
 }
 
-/* ---------------------------------------------------------------------------- */
-/*                              Public API Implementation                       */
-/* ---------------------------------------------------------------------------- */
+/**
+ * @brief Records a new block in a free metadata slot and links it in order.
+ *
+ * @param off Offset of the block in bytes from g_mem.raw[].
+ * @param req Block size in bytes.
+ * @return Pointer to the block, or NULL if no metadata slot is available.
+ */
+static int *commit_block(uint32_t off, uint32_t req) {
+    int32_t idx = node_slot_alloc();
+    if (idx < 0) return NULL;
+    allocator_heap_changed();
+    node_pool[idx].offset = off;
+    node_pool[idx].size   = req;
+    list_insert_sorted(idx);
+#if ALLOCATOR_BACKEND_SEGTREE
+    seg_mark(off, off + req, 1);
+#endif
+    return (int*)(void*)(&g_mem.raw[off]);
+}
 
 /**
- * @brief Allocates a block of memory from the static memory pool.
+ * @brief Lowest start within a gap for a block with placement constraints.
  *
- * @param size Number of bytes to allocate (must be > 0).
- * @return Pointer to allocated memory (aligned to sizeof(int)), or NULL if
- *         allocation fails (insufficient space or invalid request).
+ * Alignment and boundary apply to addresses, not offsets, so they hold for
+ * values larger than the alignment of the pool itself. A block that would
+ * straddle a boundary moves up to the boundary, which costs less padding
+ * than aligning every block to the boundary.
  *
- * @note If the request size equals TOTAL_MEMORY, the allocator will
- *       bypass metadata tracking and give the whole pool.
+ * @param base     Address of offset 0.
+ * @param start    Start of the gap (offset).
+ * @param end      End of the gap (offset, exclusive).
+ * @param req      Block size in bytes (at most @p boundary if one is given).
+ * @param align    Alignment of the block start (power of two).
+ * @param boundary Power of two the block must not cross, or 0.
+ * @return Offset of the block start, or UINT32_MAX if the gap is too small.
  */
-int *allocate(int size) {
-    if (size <= 0) return NULL;
-    uint32_t req = (uint32_t)size;
-
-    /* Special case: allocate entire pool */
-    if (req == TOTAL_MEMORY) {
-        if (full_taken || node_pool != NULL || head_index != -1) return NULL;
-        full_taken = 1;
-        return (int*)(void*)&g_mem.raw[0];
+static uint32_t gap_fit(const uint8_t *base, uint32_t start, uint32_t end,
+                        uint32_t req, uint32_t align, uint32_t boundary) {
+    /* Rounding up may wrap past the top of the address space (e.g. a 2 GB
+     * alignment with RAM at 0x80000000); the result is then below the gap */
+    uintptr_t lo = (uintptr_t)base + start;
+    uintptr_t addr = (lo + (align - 1u)) & ~(uintptr_t)(align - 1u);
+    if (addr < lo) return UINT32_MAX;
+    if (boundary != 0 && (addr & (boundary - 1u)) + req > boundary) {
+        addr = (addr + (boundary - 1u)) & ~(uintptr_t)(boundary - 1u);
+        if (addr < lo) return UINT32_MAX;
     }
+    uintptr_t limit = (uintptr_t)base + end;
+    if (addr > limit || limit - addr < req) return UINT32_MAX;
+    return (uint32_t)(addr - (uintptr_t)base);
+}
 
-    /* Pool is fully taken — no further allocations */
-    if (full_taken) return NULL;
-
-    ensure_node_pool();
-    if (node_pool == NULL) return NULL;
+/**
+ * @brief Highest start within a gap for a block with placement constraints;
+ *        the counterpart of gap_fit() for placement from the high end.
+ *
+ * @return Offset of the block start, or UINT32_MAX if the gap is too small.
+ */
+static uint32_t gap_fit_top(const uint8_t *base, uint32_t start, uint32_t end,
+                            uint32_t req, uint32_t align, uint32_t boundary) {
+    uintptr_t lo = (uintptr_t)base + start;
+    uintptr_t hi = (uintptr_t)base + end;
+    if (end < start || hi - lo < req) return UINT32_MAX;
+    uintptr_t addr = (hi - req) & ~(uintptr_t)(align - 1u);
+    if (boundary != 0 && (addr & (boundary - 1u)) + req > boundary) {
+        uintptr_t edge = (addr + req) & ~(uintptr_t)(boundary - 1u);
+        if (edge < req) return UINT32_MAX;
+        addr = (edge - req) & ~(uintptr_t)(align - 1u);
+    }
+    if (addr < lo) return UINT32_MAX;
+    return (uint32_t)(addr - (uintptr_t)base);
+}
 
-    const uint32_t USABLE_BASE  = NODE_POOL_BYTES;
-    const uint32_t USABLE_LIMIT = TOTAL_MEMORY; /* exclusive */
-
-    /* Case 1: no allocations yet */
-    if (head_index == -1) {
-        if (USABLE_BASE + req <= USABLE_LIMIT) {
-            int32_t idx = node_slot_alloc();
-            if (idx < 0) return NULL;
-            node_pool[idx].offset = USABLE_BASE;
-            node_pool[idx].size   = req;
-            list_insert_sorted(idx);
-            return (int*)(void*)(&g_mem.raw[node_pool[idx].offset]);
+/**
+ * @brief Finds the lowest (or highest) gap of a block list that can hold a
+ *        constrained block.
+ *
+ * @param nodes Metadata array of the list.
+ * @param head  First block in offset order (-1 = none).
+ * @param base  Address of offset 0.
+ * @param lo    First usable offset.
+ * @param hi    End of the usable range (exclusive).
+ * @param top   Take the highest gap that fits and place the block at its
+ *              end, instead of the lowest gap and its start.
+ * @param prev  If not NULL, receives the block after which the new one goes
+ *              (-1 = before @p head).
+ * @return Offset of the block start, or UINT32_MAX if no gap fits.
+ */
+static uint32_t find_gap_in(const alloc_node_t *nodes, int32_t head, const uint8_t *base,
+                            uint32_t lo, uint32_t hi, uint32_t req, uint32_t align,
+                            uint32_t boundary, int top, int32_t *prev) {
+    uint32_t gap_start = lo;
+    uint32_t found = UINT32_MAX;
+    int32_t before = -1;
+    for (int32_t cur = head; ; before = cur, cur = nodes[cur].next) {
+        uint32_t gap_end = (cur == -1) ? hi : nodes[cur].offset;
+        uint32_t start = top ? gap_fit_top(base, gap_start, gap_end, req, align, boundary)
+                             : gap_fit(base, gap_start, gap_end, req, align, boundary);
+        if (start != UINT32_MAX) {
+            if (prev) *prev = before;
+            found = start;
+            if (!top) return found;
         }
-        return NULL;
-    }
-
-    /* Case 2: gap before first allocation */
-    {
-        uint32_t first_off = node_pool[head_index].offset;
-        if (first_off >= USABLE_BASE + req) {
-            int32_t idx = node_slot_alloc();
-            if (idx < 0) return NULL;
-            node_pool[idx].offset = USABLE_BASE;
-            node_pool[idx].size   = req;
-            list_insert_sorted(idx);
-            return (int*)(void*)(&g_mem.raw[node_pool[idx].offset]);
+        if (cur == -1) return found;
+        gap_start = nodes[cur].offset + nodes[cur].size;
+    }
+}
+
+/**
+ * @brief Size of the largest gap of a block list within [lo, hi).
+ *
+ * @param total Incremented by the size of every gap.
+ */
+static uint32_t largest_gap_in(const alloc_node_t *nodes, int32_t head, uint32_t lo, uint32_t hi,
+                               uint32_t *total) {
+    uint32_t best = 0;
+    uint32_t gap_start = lo;
+    for (int32_t cur = head; ; cur = nodes[cur].next) {
+        uint32_t gap_end = (cur == -1) ? hi : nodes[cur].offset;
+        if (gap_end > gap_start) {
+            *total += gap_end - gap_start;
+            if (gap_end - gap_start > best) best = gap_end - gap_start;
         }
+        if (cur == -1) return best;
+        gap_start = nodes[cur].offset + nodes[cur].size;
     }
+}
+
+/**
+ * @brief Finds the lowest (or highest) gap of the pool that can hold a
+ *        constrained block.
+ *
+ * @param req      Block size in bytes.
+ * @param align    Required alignment of the block start (power of two).
+ * @param boundary Power of two the block must not cross, or 0.
+ * @param top      Place from the high end; see find_gap_in().
+ * @return Offset of the block start, or UINT32_MAX if no gap fits.
+ */
+static uint32_t find_gap_aligned(uint32_t req, uint32_t align, uint32_t boundary, int top) {
+    return find_gap_in(node_pool, head_index, g_mem.raw, USABLE_BASE, large_floor,
+                       req, align, boundary, top, NULL);
+}
+
+#if !ALLOCATOR_BACKEND_SEGTREE
+/**
+ * @brief Appends a block at the start of the wilderness, if it fits.
+ */
+static int *wild_alloc(uint32_t req) {
+    uint32_t start = wild_start();
+    if (large_floor < start || large_floor - start < req) return NULL;
+    return commit_block(start, req);
+}
+#endif
+
+/**
+ * @brief Searches the gaps between blocks for the lowest one that fits.
+ *
+ * The segment tree backend asks the tree. Otherwise holes are walked only
+ * when hole_bound says one may be large enough; a walk that finds none makes
+ * the bound exact. Otherwise the block goes to the wilderness in constant
+ * time.
+ *
+ * @param req Block size in bytes.
+ * @return Pointer to the new block, or NULL if no gap fits.
+ */
+static int *allocate_from_gaps(uint32_t req) {
+#if ALLOCATOR_BACKEND_SEGTREE
+    uint32_t off = seg_find(req);
+    return (off != UINT32_MAX) ? commit_block(off, req) : NULL;
+#else
+    if (ALLOCATOR_LIKELY(req > hole_bound)) return wild_alloc(req);
 
-    /* Case 3: gaps between existing blocks */
+    uint32_t largest = 0;
+    uint32_t gap_start = USABLE_BASE;
     for (int32_t cur = head_index; cur != -1; cur = node_pool[cur].next) {
-        int32_t nxt = node_pool[cur].next;
-        uint32_t gap_start = node_pool[cur].offset + node_pool[cur].size;
-        uint32_t gap_end   = (nxt == -1) ? USABLE_LIMIT : node_pool[nxt].offset;
-        if (gap_end > gap_start && (gap_end - gap_start) >= req) {
-            int32_t idx = node_slot_alloc();
-            if (idx < 0) return NULL;
-            node_pool[idx].offset = gap_start;
-            node_pool[idx].size   = req;
-            list_insert_sorted(idx);
-            return (int*)(void*)(&g_mem.raw[node_pool[idx].offset]);
+        uint32_t gap_end = node_pool[cur].offset;
+        if (gap_end > gap_start) {
+            if (gap_end - gap_start >= req) return commit_block(gap_start, req);
+            if (gap_end - gap_start > largest) largest = gap_end - gap_start;
         }
+        gap_start = gap_end + node_pool[cur].size;
     }
+    hole_bound = largest;
+    return wild_alloc(req);
+#endif
+}
+
+/**
+ * @brief Places a block with the given alignment.
+ *
+ * Caller holds ALLOCATOR_LOCK_CORE.
+ *
+ * @param req      Block size in bytes (a multiple of ALLOCATOR_ALIGNMENT).
+ * @param align    Alignment of the block start (power of two).
+ * @param boundary Power of two the block must not cross, or 0.
+ * @return Pointer to the new block, or NULL if it does not fit.
+ */
+static int *allocate_locked(uint32_t req, uint32_t align, uint32_t boundary) {
+    if (node_pool == NULL) ensure_node_pool();
+    if (node_pool == NULL) return NULL;
+    int top = (req >= pool_split);
+    if (align <= ALLOCATOR_ALIGNMENT && boundary == 0 && !top) return allocate_from_gaps(req);
 
-    return NULL; /* no suitable space */
+    uint32_t off = find_gap_aligned(req, align, boundary, top);
+    return (off != UINT32_MAX) ? commit_block(off, req) : NULL;
 }
 
 /**
- * @brief Frees a previously allocated memory block.
+ * @brief Retries a failed allocation after returning empty slabs to the pool.
  *
- * @param ptr Pointer returned by allocate().
+ * Called without any lock held.
  *
- * @note If freeing the full pool allocation, metadata tracking is not restored.
+ * @param req      Block size in bytes.
+ * @param align    Alignment of the block start.
+ * @param boundary Power of two the block must not cross, or 0.
+ * @return Pointer to the new block, or NULL if it still does not fit.
  */
-void deallocate(int *ptr) {
-    if (!ptr) return;
-    uint8_t *p = (uint8_t*)(void*)ptr;
+ALLOCATOR_SLOW_PATH static int *allocate_after_trim(uint32_t req, uint32_t align,
+                                                    uint32_t boundary) {
+    if (slab_count == 0) return NULL;
+    allocator_trim();
 
-    if (p < g_mem.raw || p >= (g_mem.raw + TOTAL_MEMORY)) return;
+    allocator_lock(ALLOCATOR_LOCK_CORE);
+    int *p = allocate_locked(req, align, boundary);
+    allocator_unlock(ALLOCATOR_LOCK_CORE);
+    return p;
+}
 
-    /* Special case: freeing full buffer */
-    if (full_taken && p == &g_mem.raw[0]) {
-        full_taken = 0;
-        return;
+/**
+ * @brief Number of blocks in a slab of a size class.
+ *
+ * Whatever the blocks leave over (at least ALLOCATOR_SLAB_COLOR_RESERVE) is
+ * the room for slab colors.
+ */
+static uint32_t class_block_count(uint32_t cls) {
+    return (ALLOCATOR_SLAB_BYTES - ALLOCATOR_SLAB_COLOR_RESERVE) / allocator_class_size(cls);
+}
+
+/**
+ * @brief Picks the color of a new slab and advances the class's cursor.
+ *
+ * Caller holds ALLOCATOR_LOCK_CORE.
+ *
+ * @param cls Size class of the slab.
+ * @return Offset of the first block within the slab, in bytes.
+ */
+static uint32_t slab_next_color(uint32_t cls) {
+#if ALLOCATOR_SLAB_COLOR_STEP > 0
+    uint32_t slack = ALLOCATOR_SLAB_BYTES -
+                     class_block_count(cls) * allocator_class_size(cls);
+    uint32_t color = next_color[cls];
+    if (color > slack) color = 0;
+    next_color[cls] = color + ALLOCATOR_SLAB_COLOR_STEP;
+    return color;
+#else
+    (void)cls;
+    return 0;
+#endif
+}
+
+/**
+ * @brief Pushes a block onto the free list of its size class, unless it is
+ *        not a block in use (see allocator_slab_busy).
+ *
+ * Caller holds ALLOCATOR_LOCK_CLASS(cls).
+ *
+ * @param ptr Granule-aligned pointer inside a slab.
+ * @param cls Size class of the slab.
+ */
+static void class_push(void *ptr, uint32_t cls) {
+    uint32_t bit;
+    uint32_t *word = allocator_busy_word((uintptr_t)((uint8_t*)ptr - g_mem.raw), &bit);
+    if ((*word & bit) == 0) return; /* free already, or not a block start */
+    allocator_heap_changed();
+    *word &= ~bit;
+
+    allocator_free_block_t *b = (allocator_free_block_t*)ptr;
+    b->next = allocator_class_free[cls];
+    allocator_class_free[cls] = b;
+}
+
+/**
+ * @brief End of the last block of the list: the large area may grow down to
+ *        here. Caller holds ALLOCATOR_LOCK_CORE.
+ */
+static uint32_t small_top(void) {
+    if (node_pool == NULL) return 0;
+    return wild_start();
+}
+
+/**
+ * @brief Moves the start of the large-object area. Caller holds
+ *        ALLOCATOR_LOCK_CORE.
+ */
+static void set_large_floor(uint32_t floor) {
+#if ALLOCATOR_BACKEND_SEGTREE
+    /* The node pool stays marked even when a run covers it */
+    uint32_t lo = (floor < large_floor) ? floor : large_floor;
+    uint32_t hi = (floor < large_floor) ? large_floor : floor;
+    if (seg_ready && hi > USABLE_BASE) {
+        seg_mark(lo > USABLE_BASE ? lo : USABLE_BASE, hi, floor < large_floor);
     }
+#endif
+    large_floor = floor;
+}
 
-    if (node_pool == NULL) return;
+/**
+ * @brief Highest page-aligned start for a run of @p req bytes ending by
+ *        @p end, or UINT32_MAX if @p req exceeds @p end.
+ */
+static uint32_t run_start_below(uint32_t end, uint32_t req) {
+    if (end < req) return UINT32_MAX;
+    return ((end - req) >> PAGE_SHIFT) << PAGE_SHIFT;
+}
 
-    uint32_t off = (uint32_t)(p - g_mem.raw);
-    int32_t idx = list_remove_by_offset(off);
-    if (idx < 0) return; /* invalid */
+/**
+ * @brief Places a large block as a run of pages, as high in the pool as
+ *        possible. Caller holds ALLOCATOR_LOCK_CORE.
+ *
+ * The highest span of free pages between live runs is tried first; otherwise
+ * the run goes below the lowest one, as long as it stays above the block
+ * list. The run needs no metadata slot.
+ *
+ * @param req Block size in bytes.
+ * @return Pointer to the block, or NULL if it does not fit.
+ */
+static int *large_alloc_locked(uint32_t req) {
+    uint32_t best = UINT32_MAX;
+    uint32_t page = (large_floor < TOTAL_MEMORY) ? large_floor >> PAGE_SHIFT : PAGE_COUNT;
+    while (page < PAGE_COUNT) {
+        if (large_run[page] != 0) {
+            page += large_run[page];
+            continue;
+        }
+        uint32_t span_start = page << PAGE_SHIFT;
+        while (page < PAGE_COUNT && large_run[page] == 0) ++page;
+        uint32_t span_end = (page < PAGE_COUNT) ? page << PAGE_SHIFT : TOTAL_MEMORY;
+        uint32_t start = run_start_below(span_end, req);
+        if (start != UINT32_MAX && start >= span_start) best = start;
+    }
 
-    /* Mark slot as free */
-    node_pool[idx].size   = 0;
-    node_pool[idx].offset = 0;
+    if (best == UINT32_MAX) {
+        best = run_start_below(large_floor, req);
+        if (best == UINT32_MAX || best < ALIGN_UP(small_top(), PAGE_BYTES)) return NULL;
+        set_large_floor(best);
+    }
+    allocator_heap_changed();
+    uint32_t first = best >> PAGE_SHIFT;
+    large_run[first] = (uint16_t)(((best + req + PAGE_BYTES - 1u) >> PAGE_SHIFT) - first);
+    return (int*)(void*)&g_mem.raw[best];
+}
+
+/**
+ * @brief Frees the large run starting at @p page. Caller holds
+ *        ALLOCATOR_LOCK_CORE.
+ */
+static void large_free_locked(uint32_t page) {
+    allocator_heap_changed();
+    uint32_t next = page + large_run[page];
+    large_run[page] = 0;
+    if ((page << PAGE_SHIFT) != large_floor) return;
+
+    /* The lowest run is gone: the block list may grow up to the next one */
+    while (next < PAGE_COUNT && large_run[next] == 0) ++next;
+    set_large_floor((next < PAGE_COUNT) ? next << PAGE_SHIFT : TOTAL_MEMORY);
+}
+
+/**
+ * @brief Allocates a large block (or the whole pool) from the top of the
+ *        pool, away from the small blocks.
+ *
+ * Falls back to a gap of the block list only when no run fits even after
+ * returning empty slabs.
+ *
+ * @param req Block size in bytes.
+ * @return Pointer to the block, or NULL if it does not fit.
+ */
+ALLOCATOR_SLOW_PATH static int *allocate_large(uint32_t req) {
+    if (req > TOTAL_MEMORY) return NULL;
+
+    allocator_lock(ALLOCATOR_LOCK_CORE);
+    int *p = large_alloc_locked(req);
+    allocator_unlock(ALLOCATOR_LOCK_CORE);
+    if (p != NULL) return p;
+
+    /* Released slabs may lower the end of the block list */
+    if (slab_count != 0) {
+        allocator_trim();
+        allocator_lock(ALLOCATOR_LOCK_CORE);
+        p = large_alloc_locked(req);
+        allocator_unlock(ALLOCATOR_LOCK_CORE);
+        if (p != NULL) return p;
+    }
+
+    req = ALIGN_UP(req, ALLOCATOR_ALIGNMENT);
+    if (req > TOTAL_MEMORY - USABLE_BASE) return NULL;
+    allocator_lock(ALLOCATOR_LOCK_CORE);
+    p = allocate_locked(req, ALLOCATOR_ALIGNMENT, 0);
+    allocator_unlock(ALLOCATOR_LOCK_CORE);
+    return p;
+}
+
+/* ---------------------------------------------------------------------------- */
+/*                              Public API Implementation                       */
+/* ---------------------------------------------------------------------------- */
+
+/** Active lock implementation; see allocator_lock.h. */
+const allocator_lock_ops_t *allocator_lock_impl = NULL;
+
+void allocator_set_lock_ops(const allocator_lock_ops_t *ops) {
+    allocator_lock_impl = ops;
+}
+
+#if ALLOCATOR_SITE_LIFETIMES
+/* Defined with the call-site lifetimes below. */
+static int *site_alloc_locked(uint32_t req, uintptr_t site);
+#endif
+
+/**
+ * @brief Allocates a block of memory from the static memory pool.
+ *
+ * @param size Number of bytes to allocate (must be > 0).
+ * @return Pointer to allocated memory (aligned to ALLOCATOR_ALIGNMENT), or
+ *         NULL if allocation fails (insufficient space or invalid request).
+ *
+ * @note Requests of ALLOCATOR_LARGE_MIN bytes or more, including one for
+ *       the whole pool (TOTAL_MEMORY), are served as page runs from the top
+ *       of the pool without metadata slots.
+ */
+#if ALLOCATOR_SITE_LIFETIMES
+/* Inlined into a caller (LTO), ALLOCATOR_CALLER() would name the wrong site */
+ALLOCATOR_NOINLINE
+#endif
+int *allocate(int size) {
+    if (ALLOCATOR_UNLIKELY(size <= 0)) return NULL;
+    uint32_t req = (uint32_t)size;
+#if ALLOCATOR_ADAPTIVE_CLASSES
+    atomic_fetch_add_explicit(&allocator_size_hist[req <= ALLOCATOR_SMALL_MAX
+                                                       ? (req - 1u) / ALLOCATOR_CLASS_GRANULE
+                                                       : ALLOCATOR_CLASS_BUCKETS],
+                              1u, memory_order_relaxed);
+#endif
+
+    /* Large blocks and the entire pool come from the top */
+    if (ALLOCATOR_UNLIKELY(req >= ALLOCATOR_LARGE_MIN || req > TOTAL_MEMORY - USABLE_BASE)) {
+        return allocate_large(req);
+    }
+
+    /* Keep every block (and so every gap) aligned */
+    req = ALIGN_UP(req, ALLOCATOR_ALIGNMENT);
+
+    allocator_lock(ALLOCATOR_LOCK_CORE);
+    int *p = NULL;
+    if (ALLOCATOR_UNLIKELY(node_pool == NULL)) ensure_node_pool();
+    if (ALLOCATOR_LIKELY(node_pool != NULL)) {
+#if ALLOCATOR_SITE_LIFETIMES
+        p = site_alloc_locked(req, (uintptr_t)ALLOCATOR_CALLER());
+#else
+        p = ALLOCATOR_LIKELY(req < pool_split) ? allocate_from_gaps(req)
+                                               : allocate_locked(req, ALLOCATOR_ALIGNMENT, 0);
+#endif
+    }
+    allocator_unlock(ALLOCATOR_LOCK_CORE);
+
+    if (ALLOCATOR_UNLIKELY(p == NULL)) p = allocate_after_trim(req, ALLOCATOR_ALIGNMENT, 0);
+    return p;
+}
+
+/* Defined with the memory tiers below. */
+static int *allocate_fast_tier(int size, uint32_t flags);
+
+/**
+ * @brief Allocates a block with placement options.
+ *
+ * @param size  Number of bytes to allocate (must be > 0).
+ * @param flags Bitwise OR of ALLOCATOR_F_* flags.
+ * @return Pointer to allocated memory, or NULL if allocation fails.
+ */
+int *allocate_flags(int size, uint32_t flags) {
+    if (flags & ALLOCATOR_F_FAST) return allocate_fast_tier(size, flags);
+    if (!(flags & ALLOCATOR_F_CACHELINE)) return allocate(size);
+    if (size <= 0) return NULL;
+
+    /* Whole lines only, so the next block cannot start inside this one's last line */
+    uint32_t req = ALIGN_UP((uint32_t)size, ALLOCATOR_CACHE_LINE);
+    if (req > TOTAL_MEMORY - USABLE_BASE) return NULL;
+
+    allocator_lock(ALLOCATOR_LOCK_CORE);
+    int *p = allocate_locked(req, ALLOCATOR_CACHE_LINE, 0);
+    allocator_unlock(ALLOCATOR_LOCK_CORE);
+
+    if (p == NULL) p = allocate_after_trim(req, ALLOCATOR_CACHE_LINE, 0);
+    return p;
+}
+
+/**
+ * @brief Whether at least @p want metadata slots are unused.
+ */
+static int node_slots_available(uint32_t want) {
+    for (uint32_t i = 0; i < MAX_NODES && want != 0; ++i) {
+        if (node_pool[i].size == 0) --want;
+    }
+    return want == 0;
+}
+
+/**
+ * @brief Places a scatter-gather allocation; caller holds ALLOCATOR_LOCK_CORE.
+ *
+ * Gaps are collected first and committed afterwards, so that the list is not
+ * modified while it is walked.
+ *
+ * @param req      Total size, a multiple of ALLOCATOR_ALIGNMENT.
+ * @param last_pad Alignment padding at the end of the last segment, which is
+ *                 not reported in its length.
+ * @return Number of segments, or 0 if they do not fit.
+ */
+static uint32_t allocate_sg_locked(uint32_t req, uint32_t last_pad, uint32_t max_segments,
+                                   allocator_iovec_t *iov) {
+    if (node_pool == NULL) ensure_node_pool();
+    if (node_pool == NULL) return 0;
+
+    uint32_t n = 0;
+    uint32_t remaining = req;
+    uint32_t gap_start = USABLE_BASE;
+    for (int32_t cur = head_index; remaining != 0 && n < max_segments; cur = node_pool[cur].next) {
+        uint32_t gap_end = (cur == -1) ? large_floor : node_pool[cur].offset;
+        if (gap_end > gap_start) {
+            uint32_t take = (gap_end - gap_start < remaining) ? gap_end - gap_start : remaining;
+            iov[n].iov_base = &g_mem.raw[gap_start];
+            iov[n].iov_len  = take;
+            ++n;
+            remaining -= take;
+        }
+        if (cur == -1) break;
+        gap_start = node_pool[cur].offset + node_pool[cur].size;
+    }
+    if (remaining != 0 || !node_slots_available(n)) return 0;
+
+    for (uint32_t i = 0; i < n; ++i) {
+        commit_block((uint32_t)((uint8_t*)iov[i].iov_base - g_mem.raw), (uint32_t)iov[i].iov_len);
+    }
+    iov[n - 1u].iov_len -= last_pad;
+    return n;
+}
+
+/**
+ * @brief Allocates @p total bytes as discontiguous segments.
+ *
+ * @param total        Number of bytes to allocate (must be > 0).
+ * @param max_segments Capacity of @p iov_out.
+ * @param iov_out      Receives the segments, in address order.
+ * @return Number of segments, or 0 if the request cannot be satisfied.
+ */
+uint32_t allocate_sg(int total, uint32_t max_segments, allocator_iovec_t *iov_out) {
+    if (total <= 0 || max_segments == 0 || iov_out == NULL) return 0;
+    if ((uint32_t)total > TOTAL_MEMORY - USABLE_BASE) return 0;
+
+    /* Every segment is a normal block: whole alignment units */
+    uint32_t req = ALIGN_UP((uint32_t)total, ALLOCATOR_ALIGNMENT);
+    uint32_t pad = req - (uint32_t)total;
+
+    allocator_lock(ALLOCATOR_LOCK_CORE);
+    uint32_t n = allocate_sg_locked(req, pad, max_segments, iov_out);
+    allocator_unlock(ALLOCATOR_LOCK_CORE);
+
+    if (n == 0 && slab_count != 0) {
+        allocator_trim();
+        allocator_lock(ALLOCATOR_LOCK_CORE);
+        n = allocate_sg_locked(req, pad, max_segments, iov_out);
+        allocator_unlock(ALLOCATOR_LOCK_CORE);
+    }
+    return n;
+}
+
+/**
+ * @brief Frees the segments of an allocate_sg() allocation.
+ */
+void deallocate_sg(const allocator_iovec_t *iov, uint32_t count) {
+    for (uint32_t i = 0; i < count; ++i) deallocate((int*)iov[i].iov_base);
+}
+
+/* ---------------------------------------------------------------------------- */
+/*                               Secondary Regions                              */
+/* ---------------------------------------------------------------------------- */
+
+#if HAVE_REGIONS
+/**
+ * @brief Places a block in a secondary region; caller holds
+ *        ALLOCATOR_LOCK_CORE.
+ *
+ * @return Pointer to the block, or NULL if it does not fit.
+ */
+static int *region_alloc_locked(region_t *r, uint32_t req, uint32_t align, uint32_t boundary) {
+    int32_t idx = -1;
+    for (uint32_t i = 0; i < r->max_nodes; ++i) {
+        if (r->nodes[i].size == 0) { idx = (int32_t)i; break; }
+    }
+    if (idx < 0) return NULL;
+
+    int32_t prev;
+    uint32_t off = find_gap_in(r->nodes, r->head, r->base, 0, r->size,
+                               req, align, boundary, req >= r->split, &prev);
+    if (off == UINT32_MAX) return NULL;
+
+    r->nodes[idx].offset = off;
+    r->nodes[idx].size   = req;
+    if (prev == -1) {
+        r->nodes[idx].next = r->head;
+        r->head = idx;
+    } else {
+        r->nodes[idx].next = r->nodes[prev].next;
+        r->nodes[prev].next = idx;
+    }
+    r->used += req;
+    return (int*)(void*)&r->base[off];
+}
+
+/**
+ * @brief Frees a block of a secondary region; caller holds
+ *        ALLOCATOR_LOCK_CORE. Unknown pointers are ignored.
+ */
+static void region_free_locked(region_t *r, const uint8_t *p) {
+    uint32_t off = (uint32_t)(p - r->base);
+    for (int32_t prev = -1, cur = r->head; cur != -1; prev = cur, cur = r->nodes[cur].next) {
+        if (r->nodes[cur].offset != off) continue;
+        if (prev == -1) r->head = r->nodes[cur].next;
+        else r->nodes[prev].next = r->nodes[cur].next;
+        r->used -= r->nodes[cur].size;
+        r->nodes[cur].size = 0;
+        r->nodes[cur].next = -1;
+        return;
+    }
+}
+
+/** Whether @p p points into a secondary region. */
+static int region_contains(const region_t *r, const uint8_t *p) {
+    return p >= r->base && p < r->base + r->size;
+}
+
+/**
+ * @brief Frees @p p if it belongs to a secondary region.
+ *
+ * @return 1 if @p p was in a secondary region, 0 otherwise.
+ */
+static int region_free(const uint8_t *p) {
+    region_t *r = NULL;
+#if ALLOCATOR_DMA_MEMORY > 0u
+    if (region_contains(&dma_region, p)) r = &dma_region;
+#endif
+#if ALLOCATOR_FAST_MEMORY > 0u
+    if (region_contains(&fast_region, p)) r = &fast_region;
+#endif
+    if (r == NULL) return 0;
+    allocator_lock(ALLOCATOR_LOCK_CORE);
+    region_free_locked(r, p);
+    allocator_unlock(ALLOCATOR_LOCK_CORE);
+    return 1;
+}
+#endif /* HAVE_REGIONS */
+
+/* ---------------------------------------------------------------------------- */
+/*                                  DMA Buffers                                 */
+/* ---------------------------------------------------------------------------- */
+
+/**
+ * @brief Allocates a buffer for a DMA engine.
+ *
+ * @param size     Number of bytes (must be > 0); rounded up to whole cache
+ *                 lines so that cache maintenance on the buffer cannot touch
+ *                 a neighbour.
+ * @param align    Alignment of the start (power of two; at least a cache line
+ *                 is always used).
+ * @param boundary Power of two the buffer must not cross (e.g. 1024 or 4096),
+ *                 or 0 for none.
+ * @return Pointer to the buffer, or NULL if the request is invalid or does
+ *         not fit.
+ */
+int *allocate_dma(int size, uint32_t align, uint32_t boundary) {
+    if (size <= 0) return NULL;
+    if ((align & (align - 1u)) != 0 || (boundary & (boundary - 1u)) != 0) return NULL;
+    if (align < ALLOCATOR_CACHE_LINE) align = ALLOCATOR_CACHE_LINE;
+    if ((uint32_t)size > TOTAL_MEMORY) return NULL;
+
+    uint32_t req = ALIGN_UP((uint32_t)size, ALLOCATOR_CACHE_LINE);
+    if (boundary != 0 && req > boundary) return NULL;
+
+    int *p = NULL;
+#if ALLOCATOR_DMA_MEMORY > 0u
+    allocator_lock(ALLOCATOR_LOCK_CORE);
+    p = region_alloc_locked(&dma_region, req, align, boundary);
+    allocator_unlock(ALLOCATOR_LOCK_CORE);
+    if (p != NULL) return p;
+#endif
+    if (!(ALLOCATOR_POOL_ATTRS & ALLOCATOR_REGION_DMA)) return NULL;
+
+    allocator_lock(ALLOCATOR_LOCK_CORE);
+    p = allocate_locked(req, align, boundary);
+    allocator_unlock(ALLOCATOR_LOCK_CORE);
+
+    if (p == NULL) p = allocate_after_trim(req, align, boundary);
+    return p;
+}
+
+/**
+ * @brief Attributes of the memory holding @p ptr.
+ *
+ * @return ALLOCATOR_REGION_* flags of the main or DMA pool, or 0 if @p ptr
+ *         belongs to neither.
+ */
+uint32_t allocator_region_attrs(const void *ptr) {
+    const uint8_t *p = (const uint8_t*)ptr;
+    if (p >= g_mem.raw && p < g_mem.raw + TOTAL_MEMORY) return ALLOCATOR_POOL_ATTRS;
+#if ALLOCATOR_DMA_MEMORY > 0u
+    if (region_contains(&dma_region, p)) return ALLOCATOR_DMA_ATTRS;
+#endif
+#if ALLOCATOR_FAST_MEMORY > 0u
+    if (region_contains(&fast_region, p)) return ALLOCATOR_FAST_ATTRS;
+#endif
+    return 0;
+}
+
+#if HAVE_REGIONS
+/**
+ * @brief Region behind a secondary heap identifier, or NULL.
+ */
+static region_t *heap_region(uint32_t heap) {
+#if ALLOCATOR_DMA_MEMORY > 0u
+    if (heap == ALLOCATOR_HEAP_DMA) return &dma_region;
+#endif
+#if ALLOCATOR_FAST_MEMORY > 0u
+    if (heap == ALLOCATOR_HEAP_FAST) return &fast_region;
+#endif
+    (void)heap;
+    return NULL;
+}
+#endif /* HAVE_REGIONS */
+
+int allocator_set_placement(uint32_t heap, uint32_t split) {
+    uint32_t value = (split != 0) ? split : UINT32_MAX;
+    if (heap == ALLOCATOR_HEAP_POOL) {
+        allocator_lock(ALLOCATOR_LOCK_CORE);
+        pool_split = value;
+        allocator_unlock(ALLOCATOR_LOCK_CORE);
+        return 0;
+    }
+#if HAVE_REGIONS
+    region_t *r = heap_region(heap);
+    if (r != NULL) {
+        allocator_lock(ALLOCATOR_LOCK_CORE);
+        r->split = value;
+        allocator_unlock(ALLOCATOR_LOCK_CORE);
+        return 0;
+    }
+#endif
+    return -1;
+}
+
+/**
+ * @brief Largest free extent of a heap; adds every free extent to @p total.
+ */
+static uint32_t heap_free_extents(uint32_t heap, uint32_t *total) {
+    uint32_t best = 0;
+    allocator_lock(ALLOCATOR_LOCK_CORE);
+    if (heap == ALLOCATOR_HEAP_POOL) {
+        /* Below the large runs, then the free spans between them */
+        if (node_pool == NULL) {
+            best = *total = large_floor;
+        } else {
+            best = largest_gap_in(node_pool, head_index, USABLE_BASE, large_floor, total);
+        }
+        uint32_t page = (large_floor < TOTAL_MEMORY) ? large_floor >> PAGE_SHIFT : PAGE_COUNT;
+        while (page < PAGE_COUNT) {
+            if (large_run[page] != 0) {
+                page += large_run[page];
+                continue;
+            }
+            uint32_t span_start = page << PAGE_SHIFT;
+            while (page < PAGE_COUNT && large_run[page] == 0) ++page;
+            uint32_t span_end = (page < PAGE_COUNT) ? page << PAGE_SHIFT : TOTAL_MEMORY;
+            *total += span_end - span_start;
+            if (span_end - span_start > best) best = span_end - span_start;
+        }
+    }
+#if HAVE_REGIONS
+    region_t *r = heap_region(heap);
+    if (r != NULL) best = largest_gap_in(r->nodes, r->head, 0, r->size, total);
+#endif
+    allocator_unlock(ALLOCATOR_LOCK_CORE);
+    return best;
+}
+
+uint32_t allocator_largest_free(uint32_t heap) {
+    uint32_t total = 0;
+    return heap_free_extents(heap, &total);
+}
+
+uint32_t allocator_free_bytes(uint32_t heap) {
+    uint32_t total = 0;
+    heap_free_extents(heap, &total);
+    return total;
+}
+
+/* ---------------------------------------------------------------------------- */
+/*                                 Memory Tiers                                 */
+/* ---------------------------------------------------------------------------- */
+
+/**
+ * @brief Allocates a block in the memory tier matching a hotness hint.
+ *
+ * Hot blocks go to the fast tier and spill to the main pool when it is full;
+ * cold blocks go to the main pool and use the fast tier only as a last
+ * resort.
+ *
+ * @param size Number of bytes to allocate (must be > 0).
+ * @param hint ALLOCATOR_TIER_HOT or ALLOCATOR_TIER_COLD.
+ * @return Pointer to allocated memory, or NULL if neither tier has room.
+ */
+int *allocate_tier(int size, uint32_t hint) {
+    if (size <= 0) return NULL;
+    int *p = NULL;
+#if ALLOCATOR_FAST_MEMORY > 0u
+    uint32_t req = ALIGN_UP((uint32_t)size, ALLOCATOR_ALIGNMENT);
+    if (req > ALLOCATOR_FAST_MEMORY) req = 0;   /* never fits */
+#endif
+
+    if (hint == ALLOCATOR_TIER_HOT) {
+#if ALLOCATOR_FAST_MEMORY > 0u
+        allocator_lock(ALLOCATOR_LOCK_CORE);
+        if (req != 0) p = region_alloc_locked(&fast_region, req, ALLOCATOR_ALIGNMENT, 0);
+        ++tier_stats.hot_requests;
+        if (p != NULL) ++tier_stats.hot_fast;
+        allocator_unlock(ALLOCATOR_LOCK_CORE);
+        if (p != NULL) return p;
+#else
+        allocator_lock(ALLOCATOR_LOCK_CORE);
+        ++tier_stats.hot_requests;
+        allocator_unlock(ALLOCATOR_LOCK_CORE);
+#endif
+        p = allocate(size);
+        if (p != NULL) {
+            allocator_lock(ALLOCATOR_LOCK_CORE);
+            ++tier_stats.hot_spilled;
+            allocator_unlock(ALLOCATOR_LOCK_CORE);
+        }
+        return p;
+    }
+
+    p = allocate(size);
+    allocator_lock(ALLOCATOR_LOCK_CORE);
+    ++tier_stats.cold_requests;
+#if ALLOCATOR_FAST_MEMORY > 0u
+    if (p == NULL && req != 0) {
+        p = region_alloc_locked(&fast_region, req, ALLOCATOR_ALIGNMENT, 0);
+        if (p != NULL) ++tier_stats.cold_fast;
+    }
+#endif
+    allocator_unlock(ALLOCATOR_LOCK_CORE);
+    return p;
+}
+
+/**
+ * @brief allocate_flags() with ALLOCATOR_F_FAST: fast tier only, no spill and
+ *        no tier statistics.
+ */
+static int *allocate_fast_tier(int size, uint32_t flags) {
+#if ALLOCATOR_FAST_MEMORY > 0u
+    if (size <= 0 || (uint32_t)size > ALLOCATOR_FAST_MEMORY) return NULL;
+    uint32_t align = (flags & ALLOCATOR_F_CACHELINE) ? ALLOCATOR_CACHE_LINE : ALLOCATOR_ALIGNMENT;
+    uint32_t req = ALIGN_UP((uint32_t)size, align);
+
+    allocator_lock(ALLOCATOR_LOCK_CORE);
+    int *p = region_alloc_locked(&fast_region, req, align, 0);
+    allocator_unlock(ALLOCATOR_LOCK_CORE);
+    return p;
+#else
+    (void)size;
+    (void)flags;
+    return NULL;
+#endif
+}
+
+/**
+ * @brief Copies the placement counters of allocate_tier().
+ */
+void allocator_get_tier_stats(allocator_tier_stats_t *stats) {
+    allocator_lock(ALLOCATOR_LOCK_CORE);
+    *stats = tier_stats;
+#if ALLOCATOR_FAST_MEMORY > 0u
+    stats->fast_used = fast_region.used;
+#endif
+    allocator_unlock(ALLOCATOR_LOCK_CORE);
+}
+
+/**
+ * @brief Resets the placement counters of allocate_tier().
+ */
+void allocator_reset_tier_stats(void) {
+    allocator_lock(ALLOCATOR_LOCK_CORE);
+    memset(&tier_stats, 0, sizeof tier_stats);
+    allocator_unlock(ALLOCATOR_LOCK_CORE);
+}
+
+/* ---------------------------------------------------------------------------- */
+/*                                 Lifetime Hints                               */
+/* ---------------------------------------------------------------------------- */
+
+/**
+ * @brief Places a block at the end of the block list matching its lifetime.
+ *        Caller holds ALLOCATOR_LOCK_CORE.
+ *
+ * Long-lived blocks take the lowest gap that fits, so they pack at the
+ * bottom; the others take the highest. The free space between the two
+ * stays in one piece however the boundary moves.
+ *
+ * @param req      Block size in bytes (a multiple of ALLOCATOR_ALIGNMENT).
+ * @param lifetime ALLOCATOR_LIFE_* hint.
+ * @return Pointer to the new block, or NULL if it does not fit.
+ */
+static int *hint_alloc_locked(uint32_t req, uint32_t lifetime) {
+    if (node_pool == NULL) ensure_node_pool();
+    if (node_pool == NULL) return NULL;
+    if (lifetime == ALLOCATOR_LIFE_LONG) return allocate_from_gaps(req);
+
+    uint32_t off = find_gap_aligned(req, ALLOCATOR_ALIGNMENT, 0, 1);
+    return (off != UINT32_MAX) ? commit_block(off, req) : NULL;
+}
+
+/**
+ * @brief Allocates a block at the end of the pool matching its lifetime.
+ *
+ * @param size     Number of bytes to allocate (must be > 0).
+ * @param lifetime ALLOCATOR_LIFE_* hint.
+ * @return Pointer to allocated memory, or NULL if allocation fails.
+ */
+int *allocate_hint(int size, uint32_t lifetime) {
+    if (size <= 0 || lifetime >= ALLOCATOR_LIFE_CLASSES) return NULL;
+    uint32_t req = (uint32_t)size;
+    int *p = NULL;
+
+    if (req >= ALLOCATOR_LARGE_MIN || req > TOTAL_MEMORY - USABLE_BASE) {
+        p = allocate_large(req);
+    } else {
+        req = ALIGN_UP(req, ALLOCATOR_ALIGNMENT);
+        allocator_lock(ALLOCATOR_LOCK_CORE);
+        p = hint_alloc_locked(req, lifetime);
+        allocator_unlock(ALLOCATOR_LOCK_CORE);
+        if (p == NULL && slab_count != 0) {
+            allocator_trim();
+            allocator_lock(ALLOCATOR_LOCK_CORE);
+            p = hint_alloc_locked(req, lifetime);
+            allocator_unlock(ALLOCATOR_LOCK_CORE);
+        }
+    }
+
+    allocator_lock(ALLOCATOR_LOCK_CORE);
+    ++life_stats.requests[lifetime];
+    if (p == NULL) ++life_stats.failed[lifetime];
+    allocator_unlock(ALLOCATOR_LOCK_CORE);
+    return p;
+}
+
+/**
+ * @brief Copies the counters of allocate_hint().
+ */
+void allocator_get_life_stats(allocator_life_stats_t *stats) {
+    allocator_lock(ALLOCATOR_LOCK_CORE);
+    *stats = life_stats;
+    allocator_unlock(ALLOCATOR_LOCK_CORE);
+}
+
+/**
+ * @brief Resets the counters of allocate_hint().
+ */
+void allocator_reset_life_stats(void) {
+    allocator_lock(ALLOCATOR_LOCK_CORE);
+    memset(&life_stats, 0, sizeof life_stats);
+    allocator_unlock(ALLOCATOR_LOCK_CORE);
+}
+
+/* ---------------------------------------------------------------------------- */
+/*                               Call-Site Lifetimes                            */
+/* ---------------------------------------------------------------------------- */
+
+#if ALLOCATOR_SITE_LIFETIMES
+/** Longest lifetime measured; older samples are recorded as this. */
+#define SITE_LIFE_CAP  ALLOCATOR_SITE_LONG_LIFE
+
+/**
+ * @brief Forgets the blocks being measured. Caller holds ALLOCATOR_LOCK_CORE.
+ */
+static void site_samples_clear(void) {
+    memset(site_samples, 0, sizeof site_samples);
+    site_pending = 0;
+}
+
+/**
+ * @brief Index of the entry of a call site, added if new; UINT32_MAX if the
+ *        table is full.
+ */
+static uint32_t site_lookup(uintptr_t pc) {
+    if (pc == 0) return UINT32_MAX;
+    uint32_t i = (uint32_t)((pc >> 2) * 2654435761u) & (ALLOCATOR_SITE_SLOTS - 1u);
+    for (uint32_t n = 0; n < ALLOCATOR_SITE_SLOTS; ++n, i = (i + 1u) & (ALLOCATOR_SITE_SLOTS - 1u)) {
+        if (sites[i].pc == pc) return i;
+        if (sites[i].pc == 0) {
+            sites[i].pc = pc;
+            return i;
+        }
+    }
+    return UINT32_MAX;
+}
+
+/**
+ * @brief Adds a measured lifetime to the moving average of a site.
+ */
+static void site_record(uint32_t site, uint32_t life) {
+    site_t *s = &sites[site];
+    if (life > SITE_LIFE_CAP) life = SITE_LIFE_CAP;
+    if (s->samples == 0) {
+        s->mean = life;
+    } else {
+        s->mean = s->mean - (s->mean >> 3) + (life >> 3);
+    }
+    if (s->samples != UINT16_MAX) ++s->samples;
+    ++site_measured;
+}
+
+/**
+ * @brief Starts measuring the lifetime of a block. A sample older than
+ *        SITE_LIFE_CAP makes room: it is recorded as long-lived.
+ */
+static void site_sample_take(uint32_t off, uint32_t site) {
+    for (uint32_t i = 0; i < ALLOCATOR_SITE_SAMPLES; ++i) {
+        site_sample_t *t = &site_samples[i];
+        if (t->off != 0) {
+            if (site_clock - t->birth < SITE_LIFE_CAP) continue;
+            site_record(t->site, SITE_LIFE_CAP);
+            --site_pending;
+        }
+        t->off = off;
+        t->birth = site_clock;
+        t->site = site;
+        ++site_pending;
+        return;
+    }
+}
+
+/**
+ * @brief Ends the measurement of a freed block, if it was sampled. Caller
+ *        holds ALLOCATOR_LOCK_CORE.
+ */
+static void site_sample_free(uint32_t off) {
+    for (uint32_t i = 0; i < ALLOCATOR_SITE_SAMPLES; ++i) {
+        site_sample_t *t = &site_samples[i];
+        if (t->off != off) continue;
+        site_record(t->site, site_clock - t->birth);
+        t->off = 0;
+        --site_pending;
+        return;
+    }
+}
+
+/** Whether a site has shown blocks that are not long-lived. */
+static int site_is_short(uint32_t site) {
+    return site != UINT32_MAX && sites[site].samples >= ALLOCATOR_SITE_MIN_SAMPLES &&
+           sites[site].mean < ALLOCATOR_SITE_LONG_LIFE;
+}
+
+/**
+ * @brief allocate() with call-site learning. Caller holds
+ *        ALLOCATOR_LOCK_CORE and has set up the node pool.
+ *
+ * Blocks of sites that are not long-lived take the highest gap that fits, as
+ * with ALLOCATOR_LIFE_SHORT; the others, and those of sites not measured
+ * yet, are placed as usual. Every
+ * ALLOCATOR_SITE_SAMPLE_PERIOD-th block is sampled.
+ */
+static int *site_alloc_locked(uint32_t req, uintptr_t pc) {
+    uint32_t site = site_lookup(pc);
+    ++site_clock;
+
+    int *p;
+    if (site_is_short(site)) {
+        p = hint_alloc_locked(req, ALLOCATOR_LIFE_SHORT);
+        if (p != NULL) ++site_routed;
+    } else {
+        p = (req < pool_split) ? allocate_from_gaps(req) : allocate_locked(req, ALLOCATOR_ALIGNMENT, 0);
+    }
+
+    if (p != NULL && site != UINT32_MAX && (site_clock & (ALLOCATOR_SITE_SAMPLE_PERIOD - 1u)) == 0) {
+        site_sample_take((uint32_t)((uint8_t*)p - g_mem.raw), site);
+    }
+    return p;
+}
+
+/**
+ * @brief Copies the counters of call-site learning.
+ */
+void allocator_get_site_stats(allocator_site_stats_t *stats) {
+    memset(stats, 0, sizeof *stats);
+    allocator_lock(ALLOCATOR_LOCK_CORE);
+    for (uint32_t i = 0; i < ALLOCATOR_SITE_SLOTS; ++i) {
+        if (sites[i].pc == 0) continue;
+        ++stats->sites;
+        if (site_is_short(i)) ++stats->short_sites;
+    }
+    stats->measured = site_measured;
+    stats->routed = site_routed;
+    allocator_unlock(ALLOCATOR_LOCK_CORE);
+}
+
+/**
+ * @brief Mean lifetime learned for a call site.
+ */
+uint32_t allocator_site_lifetime(const void *site) {
+    uint32_t mean = UINT32_MAX;
+    allocator_lock(ALLOCATOR_LOCK_CORE);
+    for (uint32_t i = 0; i < ALLOCATOR_SITE_SLOTS; ++i) {
+        if (sites[i].pc == (uintptr_t)site && sites[i].samples != 0) mean = sites[i].mean;
+    }
+    allocator_unlock(ALLOCATOR_LOCK_CORE);
+    return mean;
+}
+
+/**
+ * @brief Forgets every call site and the counters.
+ */
+void allocator_reset_sites(void) {
+    allocator_lock(ALLOCATOR_LOCK_CORE);
+    memset(sites, 0, sizeof sites);
+    site_samples_clear();
+    site_clock = 0;
+    site_measured = 0;
+    site_routed = 0;
+    allocator_unlock(ALLOCATOR_LOCK_CORE);
+}
+#endif /* ALLOCATOR_SITE_LIFETIMES */
+
+/**
+ * @brief Frees a previously allocated memory block.
+ *
+ * @param ptr Pointer returned by allocate().
+ *
+ * @note If freeing the full pool allocation, metadata tracking is not restored.
+ */
+void deallocate(int *ptr) {
+    if (!ptr) return;
+    uint8_t *p = (uint8_t*)(void*)ptr;
+
+    if (p < g_mem.raw || p >= (g_mem.raw + TOTAL_MEMORY)) {
+#if HAVE_REGIONS
+        region_free(p);
+#endif
+        return;
+    }
+
+    uint32_t off = (uint32_t)(p - g_mem.raw);
+
+    /* Blocks inside a slab go back to their size-class free list. A live
+     * block keeps its slab from being trimmed, so the tag is stable here;
+     * class_push() drops anything that is not a block in use. */
+    uint8_t tag = allocator_slab_class[off >> ALLOCATOR_SLAB_SHIFT];
+    if (tag != 0) {
+        if ((off & (ALLOCATOR_CLASS_GRANULE - 1u)) != 0) return; /* invalid */
+        allocator_lock(ALLOCATOR_LOCK_CLASS(tag - 1u));
+        class_push(p, tag - 1u);
+        allocator_unlock(ALLOCATOR_LOCK_CLASS(tag - 1u));
+        return;
+    }
+
+    allocator_lock(ALLOCATOR_LOCK_CORE);
+
+    /* Large runs (including the whole pool) start on a page above the floor */
+    if ((off & (PAGE_BYTES - 1u)) == 0 && off >= large_floor && large_run[off >> PAGE_SHIFT] != 0) {
+        large_free_locked(off >> PAGE_SHIFT);
+    } else if (node_pool != NULL) {
+        int32_t idx = list_remove_by_offset(off);
+#if ALLOCATOR_SITE_LIFETIMES
+        if (idx >= 0 && site_pending != 0) site_sample_free(off);
+#endif
+        if (idx >= 0) {
+            node_slot_free(idx);
+
+            /* If nothing left, release metadata */
+            if (head_index == -1) {
+                try_uncarve_when_empty();
+            }
+        }
+    }
+
+    allocator_unlock(ALLOCATOR_LOCK_CORE);
+}
+
+/**
+ * @brief Carves a new slab and chains its blocks in address order.
+ *
+ * @param cls   Size class of the slab.
+ * @param owner Owner tag stored in allocator_slab_owner[] (0 = shared).
+ * @param last  Receives the last block of the chain.
+ * @return First block of the chain (terminated by NULL), or NULL if no
+ *         slab-aligned gap is left.
+ */
+allocator_free_block_t *allocator_slab_carve(uint32_t cls, uint32_t owner,
+                                             allocator_free_block_t **last) {
+    if (cls >= ALLOCATOR_NUM_CLASSES) return NULL;
+
+    uint32_t block = allocator_class_size(cls);
+    uint32_t count = class_block_count(cls);
+    uint32_t off = UINT32_MAX;
+    uint32_t color = 0;
+    allocator_lock(ALLOCATOR_LOCK_CORE);
+    if (node_pool == NULL) ensure_node_pool();
+    if (node_pool != NULL) {
+        off = find_gap_aligned(ALLOCATOR_SLAB_BYTES, ALLOCATOR_SLAB_BYTES, 0, 0);
+        if (off != UINT32_MAX && commit_block(off, ALLOCATOR_SLAB_BYTES) == NULL) {
+            off = UINT32_MAX;
+        }
+        if (off == UINT32_MAX && head_index == -1) try_uncarve_when_empty();
+    }
+    if (off != UINT32_MAX) {
+        color = slab_next_color(cls);
+        slab_color[off >> ALLOCATOR_SLAB_SHIFT] = (uint8_t)(color / ALLOCATOR_CLASS_GRANULE);
+        /* Busy bits before the class tag: no free can reach the frame yet */
+        for (uint32_t i = 0; i < count; ++i) {
+            uint32_t bit;
+            *allocator_busy_word(off + color + i * block, &bit) |= bit;
+        }
+        allocator_slab_class[off >> ALLOCATOR_SLAB_SHIFT] = (uint8_t)(cls + 1u);
+        atomic_store_explicit(&allocator_slab_owner[off >> ALLOCATOR_SLAB_SHIFT],
+                              (uint8_t)owner, memory_order_relaxed);
+        ++slab_count;
+    }
+    allocator_unlock(ALLOCATOR_LOCK_CORE);
+    if (off == UINT32_MAX) return NULL;
+
+    off += color;
+    allocator_free_block_t *first = (allocator_free_block_t*)(void*)&g_mem.raw[off];
+    allocator_free_block_t *tail  = first;
+    for (uint32_t i = 1; i < count; ++i) {
+        tail->next = (allocator_free_block_t*)(void*)&g_mem.raw[off + i * block];
+        tail = tail->next;
+    }
+    tail->next = NULL;
+    *last = tail;
+    return first;
+}
+
+/**
+ * @brief Carves a new shared slab and splits it into blocks of one size class.
+ *
+ * @param cls Size class whose free list is empty.
+ * @return Pointer to the first block of the slab, or NULL if no slab-aligned
+ *         gap is left.
+ */
+int *allocator_class_refill(uint32_t cls) {
+    if (cls >= ALLOCATOR_NUM_CLASSES) return NULL;
+
+    /* Another thread may have refilled the list meanwhile */
+    allocator_lock(ALLOCATOR_LOCK_CLASS(cls));
+    allocator_free_block_t *b = allocator_class_free[cls];
+    if (b != NULL) {
+        uint32_t bit;
+        allocator_heap_changed();
+        allocator_class_free[cls] = b->next;
+        *allocator_busy_word((uintptr_t)((uint8_t*)b - g_mem.raw), &bit) |= bit;
+    }
+    allocator_unlock(ALLOCATOR_LOCK_CLASS(cls));
+    if (b != NULL) return (int*)(void*)b;
+
+    allocator_free_block_t *last;
+    b = allocator_slab_carve(cls, 0, &last);
+    if (b == NULL) return NULL;
+
+    /* Keep the first block, splice the rest in */
+    if (b->next != NULL) allocator_slab_share(cls, b->next, last);
+    return (int*)(void*)b;
+}
+
+void allocator_slab_share(uint32_t cls, allocator_free_block_t *first,
+                          allocator_free_block_t *last) {
+    allocator_lock(ALLOCATOR_LOCK_CLASS(cls));
+    for (allocator_free_block_t *b = first; ; b = b->next) {
+        uint32_t bit;
+        *allocator_busy_word((uintptr_t)((uint8_t*)b - g_mem.raw), &bit) &= ~bit;
+        if (b == last) break;
+    }
+    last->next = allocator_class_free[cls];
+    allocator_class_free[cls] = first;
+    allocator_unlock(ALLOCATOR_LOCK_CLASS(cls));
+}
+
+/**
+ * @brief Returns slabs whose blocks are all free back to the pool.
+ *
+ * Counts the free blocks of every slab by walking the class free lists, drops
+ * the blocks of completely free slabs from the lists and removes those slabs
+ * from the block list. Holds every lock while doing so.
+ */
+void allocator_trim(void) {
+    lock_all();
+
+    uint16_t free_blocks[ALLOCATOR_SLAB_COUNT] = { 0 };
+    uint32_t released = 0;
+
+    if (slab_count != 0) {
+        for (uint32_t cls = 0; cls < ALLOCATOR_NUM_CLASSES; ++cls) {
+            for (allocator_free_block_t *b = allocator_class_free[cls]; b; b = b->next) {
+                ++free_blocks[((uint8_t*)b - g_mem.raw) >> ALLOCATOR_SLAB_SHIFT];
+            }
+        }
+
+        /* Decide which slabs go; mark them with a count of UINT16_MAX */
+        for (uint32_t i = 0; i < ALLOCATOR_SLAB_COUNT; ++i) {
+            uint8_t tag = allocator_slab_class[i];
+            if (tag == 0) continue;
+            uint32_t count = class_block_count(tag - 1u);
+            if (free_blocks[i] == count) {
+                free_blocks[i] = UINT16_MAX;
+                ++released;
+            }
+        }
+    }
+
+    if (released != 0) {
+        /* Unlink the blocks of released slabs, keeping the order of the rest */
+        for (uint32_t cls = 0; cls < ALLOCATOR_NUM_CLASSES; ++cls) {
+            allocator_free_block_t **link = &allocator_class_free[cls];
+            while (*link) {
+                uint32_t slab = (uint32_t)(((uint8_t*)*link - g_mem.raw) >> ALLOCATOR_SLAB_SHIFT);
+                if (free_blocks[slab] == UINT16_MAX) *link = (*link)->next;
+                else link = &(*link)->next;
+            }
+        }
+
+        for (uint32_t i = 0; i < ALLOCATOR_SLAB_COUNT; ++i) {
+            if (free_blocks[i] != UINT16_MAX) continue;
+            int32_t idx = list_remove_by_offset(i << ALLOCATOR_SLAB_SHIFT);
+            if (idx >= 0) node_slot_free(idx);
+            allocator_slab_class[i] = 0;
+            atomic_store_explicit(&allocator_slab_owner[i], 0, memory_order_relaxed);
+            memset(allocator_slab_busy[i], 0, sizeof allocator_slab_busy[i]);
+            --slab_count;
+        }
+
+        if (head_index == -1) try_uncarve_when_empty();
+    }
+
+    unlock_all();
+}
+
+#if ALLOCATOR_ADAPTIVE_CLASSES
+int allocator_classes_apply(const allocator_class_layout_t *layout) {
+    uint8_t index[ALLOCATOR_CLASS_BUCKETS];
+    uint32_t cls = 0;
+    for (cls = 0; cls < ALLOCATOR_NUM_CLASSES; ++cls) {
+        uint32_t bytes = layout->size[cls];
+        if (bytes == 0 || bytes % ALLOCATOR_CLASS_GRANULE != 0 || bytes > ALLOCATOR_SMALL_MAX ||
+            (cls != 0 && bytes <= layout->size[cls - 1u])) {
+            return -1;
+        }
+    }
+    if (layout->size[ALLOCATOR_NUM_CLASSES - 1u] != ALLOCATOR_SMALL_MAX) return -1;
+
+    /* Each granule goes to the smallest class that holds it */
+    cls = 0;
+    for (uint32_t bucket = 0; bucket < ALLOCATOR_CLASS_BUCKETS; ++bucket) {
+        while (layout->size[cls] < (bucket + 1u) * ALLOCATOR_CLASS_GRANULE) ++cls;
+        index[bucket] = (uint8_t)(cls + 1u);
+    }
+
+    /* Blocks of the old classes must be gone: they are sized by their tag */
+    allocator_trim();
+    lock_all();
+    int rc = -1;
+    if (slab_count == 0) {
+        memcpy(allocator_class_index, index, sizeof index);
+        for (cls = 0; cls < ALLOCATOR_NUM_CLASSES; ++cls) {
+            allocator_class_bytes[cls] = layout->size[cls];
+            next_color[cls] = 0;
+        }
+        rc = 0;
+    }
+    unlock_all();
+    return rc;
+}
+#endif
+
+/* ---------------------------------------------------------------------------- */
+/*                              Snapshot and Warm Restart                       */
+/* ---------------------------------------------------------------------------- */
+
+/** Identifies a snapshot header ("ALSN"). */
+#define SNAPSHOT_MAGIC    0x4E534C41u
+
+/** Bumped whenever snapshot_meta_t changes. */
+#define SNAPSHOT_VERSION  2u
+
+/**
+ * @struct snapshot_meta_t
+ * @brief Allocator metadata outside the pool; the node pool itself lives at
+ *        the start of the pool and travels with it.
+ *
+ * Free-list heads are stored as offsets + 1 (0 = empty). The links inside
+ * free blocks are absolute and are relocated against @c base on restore.
+ */
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t config;
+    uint32_t checksum;
+    uint64_t base;
+    int32_t  head_index;
+    uint8_t  node_pool_ready;
+    uint8_t  reserved[3];
+    uint32_t large_floor;
+    uint32_t slab_count;
+    uint32_t root;
+    uint32_t class_free[ALLOCATOR_NUM_CLASSES];
+    uint32_t next_color[ALLOCATOR_NUM_CLASSES];
+    uint8_t  slab_class[ALLOCATOR_SLAB_COUNT];
+    uint8_t  slab_color[ALLOCATOR_SLAB_COUNT];
+    uint16_t large_run[PAGE_COUNT];
+} snapshot_meta_t;
+
+/** Metadata kept next to the pool for allocator_warm_boot(). */
+static RETAINED snapshot_meta_t retained_meta;
+
+/** Application root reference; see allocator_set_root(). */
+static allocator_rel_t root_ref;
+
+/**
+ * @brief FNV-1a over a byte range, continuing from @p h.
+ */
+static uint32_t fnv1a(uint32_t h, const void *data, size_t len) {
+    const uint8_t *p = (const uint8_t*)data;
+    for (size_t i = 0; i < len; ++i) {
+        h ^= p[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+/**
+ * @brief Fingerprint of every setting that changes the pool layout.
+ */
+static uint32_t config_fingerprint(void) {
+    const uint32_t cfg[] = {
+        TOTAL_MEMORY, MAX_NODES, (uint32_t)ALLOCATOR_ALIGNMENT,
+        ALLOCATOR_CLASS_GRANULE, ALLOCATOR_NUM_CLASSES, ALLOCATOR_SLAB_SHIFT,
+        ALLOCATOR_SLAB_COLOR_STEP, ALLOCATOR_SLAB_COLOR_RESERVE,
+        (uint32_t)sizeof(void*), (uint32_t)sizeof(alloc_node_t)
+    };
+    uint32_t h = fnv1a(2166136261u, cfg, sizeof cfg);
+    for (uint32_t cls = 0; cls < ALLOCATOR_NUM_CLASSES; ++cls) {
+        uint32_t bytes = allocator_class_size(cls);
+        h = fnv1a(h, &bytes, sizeof bytes);
+    }
+    return h;
+}
+
+/**
+ * @brief Checksum of the metadata bytes around @c checksum.
+ *
+ * Hashed in place: a struct copy need not preserve the trailing padding, which
+ * snapshot_capture() zeroes and the snapshot stores byte for byte.
+ */
+static uint32_t meta_checksum(const snapshot_meta_t *m) {
+    const uint8_t *p = (const uint8_t*)m;
+    const size_t at = offsetof(snapshot_meta_t, checksum);
+    const size_t after = at + sizeof m->checksum;
+    return fnv1a(fnv1a(2166136261u, p, at), p + after, sizeof *m - after);
+}
+
+/**
+ * @brief Captures the metadata. Caller holds every lock.
+ */
+static void snapshot_capture(snapshot_meta_t *m) {
+    memset(m, 0, sizeof *m);
+    m->magic = SNAPSHOT_MAGIC;
+    m->version = SNAPSHOT_VERSION;
+    m->config = config_fingerprint();
+    m->base = (uint64_t)(uintptr_t)g_mem.raw;
+    m->head_index = head_index;
+    m->large_floor = large_floor;
+    m->node_pool_ready = (node_pool != NULL);
+    m->slab_count = slab_count;
+    m->root = root_ref;
+    for (uint32_t cls = 0; cls < ALLOCATOR_NUM_CLASSES; ++cls) {
+        allocator_free_block_t *b = allocator_class_free[cls];
+        m->class_free[cls] = b ? (uint32_t)((uint8_t*)b - g_mem.raw) + 1u : 0u;
+        m->next_color[cls] = next_color[cls];
+    }
+    memcpy(m->slab_class, allocator_slab_class, sizeof m->slab_class);
+    memcpy(m->slab_color, slab_color, sizeof m->slab_color);
+    memcpy(m->large_run, large_run, sizeof m->large_run);
+    m->checksum = meta_checksum(m);
+}
+
+static int snapshot_valid(const snapshot_meta_t *m) {
+    return m->magic == SNAPSHOT_MAGIC && m->version == SNAPSHOT_VERSION &&
+           m->config == config_fingerprint() && m->checksum == meta_checksum(m) &&
+           m->head_index >= -1 && m->head_index < (int32_t)MAX_NODES &&
+           m->large_floor <= TOTAL_MEMORY;
+}
+
+/**
+ * @brief Empties the allocator. Caller holds every lock.
+ */
+static void reset_state(void) {
+    node_pool = NULL;
+    head_index = -1;
+    tail_index = -1;
+    hole_bound = 0;
+    free_slot = -1;
+    large_floor = TOTAL_MEMORY;
+#if ALLOCATOR_BACKEND_SEGTREE
+    seg_ready = 0;
+#endif
+    slab_count = 0;
+    root_ref = 0;
+    for (uint32_t cls = 0; cls < ALLOCATOR_NUM_CLASSES; ++cls) {
+        allocator_class_free[cls] = NULL;
+        next_color[cls] = 0;
+    }
+#if ALLOCATOR_SITE_LIFETIMES
+    site_samples_clear();
+#endif
+    for (uint32_t i = 0; i < ALLOCATOR_SLAB_COUNT; ++i) {
+        allocator_slab_class[i] = 0;
+        slab_color[i] = 0;
+        atomic_store_explicit(&allocator_slab_owner[i], 0, memory_order_relaxed);
+        large_run[i] = 0;
+    }
+    memset(allocator_slab_busy, 0, sizeof allocator_slab_busy);
+}
+
+/**
+ * @brief Checks the block list, the large runs and the slabs of a snapshot
+ *        against the pool contents, before anything is installed.
+ *
+ * The list must be acyclic, sorted and non-overlapping within
+ * [USABLE_BASE, large_floor), with every used node slot on it; runs must lie
+ * above the floor without overlapping; every slab must be a block of the list.
+ *
+ * @return 1 if consistent, 0 otherwise.
+ */
+static int snapshot_layout_valid(const snapshot_meta_t *m) {
+    const alloc_node_t *nodes = (const alloc_node_t*)(const void*)g_mem.raw;
+    uint32_t floor = m->large_floor;
+    if (floor != TOTAL_MEMORY && (floor & (PAGE_BYTES - 1u)) != 0) return 0;
+
+    uint32_t listed = 0, slabs = 0;
+    if (!m->node_pool_ready) {
+        if (m->head_index != -1) return 0;
+    } else {
+        if (floor < USABLE_BASE) return 0;
+        uint32_t end = USABLE_BASE;
+        for (int32_t cur = m->head_index; cur != -1; cur = nodes[cur].next) {
+            if (cur < 0 || cur >= (int32_t)MAX_NODES || ++listed > MAX_NODES) return 0;
+            uint32_t off = nodes[cur].offset, size = nodes[cur].size;
+            if (size == 0 || off < end || off > floor || size > floor - off) return 0;
+            end = off + size;
+            if ((off & (ALLOCATOR_SLAB_BYTES - 1u)) == 0 && size == ALLOCATOR_SLAB_BYTES &&
+                m->slab_class[off >> ALLOCATOR_SLAB_SHIFT] != 0) {
+                ++slabs;
+            }
+        }
+        uint32_t used = 0;
+        for (uint32_t i = 0; i < MAX_NODES; ++i) used += (nodes[i].size != 0);
+        if (used != listed) return 0;
+    }
+
+    uint32_t tagged = 0;
+    for (uint32_t i = 0; i < ALLOCATOR_SLAB_COUNT; ++i) {
+        uint8_t tag = m->slab_class[i];
+        if (tag == 0) continue;
+        if (tag > ALLOCATOR_NUM_CLASSES ||
+            m->slab_color[i] * ALLOCATOR_CLASS_GRANULE +
+            class_block_count(tag - 1u) * allocator_class_size(tag - 1u) > ALLOCATOR_SLAB_BYTES) {
+            return 0;
+        }
+        ++tagged;
+    }
+    if (tagged != slabs || tagged != m->slab_count) return 0;
+
+    for (uint32_t page = 0; page < PAGE_COUNT; ) {
+        uint32_t run = m->large_run[page];
+        if (run == 0) {
+            ++page;
+            continue;
+        }
+        if ((page << PAGE_SHIFT) < floor || run > PAGE_COUNT - page) return 0;
+        for (uint32_t i = page + 1u; i < page + run; ++i) {
+            if (m->large_run[i] != 0) return 0;
+        }
+        page += run;
+    }
+    return floor == TOTAL_MEMORY || m->large_run[floor >> PAGE_SHIFT] != 0;
+}
+
+/**
+ * @brief Rebuilds allocator_slab_busy from the slabs and the class free lists.
+ *        Caller holds every lock.
+ *
+ * @return 0 on success, -1 if a free list holds something other than a block
+ *         of a slab of its class, or holds a block twice.
+ */
+static int slab_busy_rebuild(void) {
+    memset(allocator_slab_busy, 0, sizeof allocator_slab_busy);
+    for (uint32_t i = 0; i < ALLOCATOR_SLAB_COUNT; ++i) {
+        uint8_t tag = allocator_slab_class[i];
+        if (tag == 0) continue;
+        uint32_t block = allocator_class_size(tag - 1u);
+        uint32_t off = (i << ALLOCATOR_SLAB_SHIFT) + slab_color[i] * ALLOCATOR_CLASS_GRANULE;
+        for (uint32_t n = 0; n < class_block_count(tag - 1u); ++n) {
+            uint32_t bit;
+            *allocator_busy_word(off + n * block, &bit) |= bit;
+        }
+    }
+
+    for (uint32_t cls = 0; cls < ALLOCATOR_NUM_CLASSES; ++cls) {
+        for (allocator_free_block_t *b = allocator_class_free[cls]; b; b = b->next) {
+            uintptr_t off = (uintptr_t)((uint8_t*)b - g_mem.raw);
+            if (off >= TOTAL_MEMORY || (off & (ALLOCATOR_CLASS_GRANULE - 1u)) != 0 ||
+                allocator_slab_class[off >> ALLOCATOR_SLAB_SHIFT] != cls + 1u) {
+                return -1;
+            }
+            uint32_t bit;
+            uint32_t *word = allocator_busy_word(off, &bit);
+            if ((*word & bit) == 0) return -1; /* not a block start, or a cycle */
+            *word &= ~bit;
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief Installs validated metadata over a pool that already holds the
+ *        matching contents. Caller holds every lock.
+ *
+ * Walks the block list and the free small blocks to check them, and relocates
+ * the free-list links if the pool is no longer at its recorded address. The
+ * rest of the pool is not touched.
+ *
+ * @return 0 on success, -1 if the block list, the large runs or the free lists
+ *         are inconsistent (the allocator is then reset to empty).
+ */
+static int snapshot_adopt(const snapshot_meta_t *m) {
+    uintptr_t old_base = (uintptr_t)m->base;
+    uintptr_t new_base = (uintptr_t)g_mem.raw;
+
+    if (!snapshot_layout_valid(m)) goto corrupt;
+    node_pool = m->node_pool_ready ? (alloc_node_t*)(void*)g_mem.raw : NULL;
+    head_index = m->head_index;
+    large_floor = m->large_floor;
+#if ALLOCATOR_BACKEND_SEGTREE
+    seg_ready = 0;
+#endif
+    if (node_pool != NULL) list_index_rebuild();
+    slab_count = m->slab_count;
+    root_ref = m->root;
+#if ALLOCATOR_SITE_LIFETIMES
+    /* Pending samples refer to blocks of the heap being replaced */
+    site_samples_clear();
+#endif
+    memcpy(allocator_slab_class, m->slab_class, sizeof m->slab_class);
+    memcpy(slab_color, m->slab_color, sizeof m->slab_color);
+    memcpy(large_run, m->large_run, sizeof large_run);
+    for (uint32_t i = 0; i < ALLOCATOR_SLAB_COUNT; ++i) {
+        /* Thread caches do not survive a restart: every slab becomes shared */
+        atomic_store_explicit(&allocator_slab_owner[i], 0, memory_order_relaxed);
+    }
+
+    for (uint32_t cls = 0; cls < ALLOCATOR_NUM_CLASSES; ++cls) {
+        next_color[cls] = m->next_color[cls];
+        uint32_t head = m->class_free[cls];
+        if (head > TOTAL_MEMORY) goto corrupt;
+        allocator_class_free[cls] = head ? (allocator_free_block_t*)(void*)&g_mem.raw[head - 1u] : NULL;
+
+        if (old_base == new_base) continue;
+        uint32_t steps = 0;
+        for (allocator_free_block_t *b = allocator_class_free[cls]; b; b = b->next) {
+            /* A list longer than the pool has blocks is a cycle */
+            if (b->next == NULL) break;
+            if (++steps > TOTAL_MEMORY / ALLOCATOR_CLASS_GRANULE) goto corrupt;
+            uintptr_t off = (uintptr_t)b->next - old_base;
+            if (off >= TOTAL_MEMORY) goto corrupt;
+            b->next = (allocator_free_block_t*)(void*)(new_base + off);
+        }
+    }
+    if (slab_busy_rebuild() != 0) goto corrupt;
+    return 0;
+
+corrupt:
+    reset_state();
+    return -1;
+}
+
+void allocator_set_root(allocator_rel_t root) {
+    allocator_lock(ALLOCATOR_LOCK_CORE);
+    allocator_heap_changed();
+    root_ref = root;
+    allocator_unlock(ALLOCATOR_LOCK_CORE);
+}
+
+allocator_rel_t allocator_get_root(void) {
+    return root_ref;
+}
+
+size_t allocator_snapshot_size(void) {
+    return sizeof(snapshot_meta_t) + TOTAL_MEMORY;
+}
+
+int allocator_snapshot_write(allocator_snapshot_write_fn write, void *ctx) {
+    if (!write) return -1;
+    snapshot_meta_t meta;
+    lock_all();
+    snapshot_capture(&meta);
+    int rc = write(ctx, &meta, sizeof meta);
+    if (rc == 0) rc = write(ctx, g_mem.raw, TOTAL_MEMORY);
+    unlock_all();
+    return rc == 0 ? 0 : -1;
+}
+
+int allocator_snapshot_read(allocator_snapshot_read_fn read, void *ctx) {
+    if (!read) return -1;
+    snapshot_meta_t meta;
+    if (read(ctx, &meta, sizeof meta) != 0 || !snapshot_valid(&meta)) return -1;
+
+    lock_all();
+    int rc = -1;
+    if (read(ctx, g_mem.raw, TOTAL_MEMORY) != 0) reset_state();
+    else rc = snapshot_adopt(&meta);
+    unlock_all();
+    return rc;
+}
+
+/** Cursor over a caller-provided buffer. */
+typedef struct {
+    uint8_t *pos;
+    size_t left;
+} snapshot_buffer_t;
+
+static int buffer_write(void *ctx, const void *data, size_t len) {
+    snapshot_buffer_t *b = (snapshot_buffer_t*)ctx;
+    if (len > b->left) return -1;
+    memcpy(b->pos, data, len);
+    b->pos += len;
+    b->left -= len;
+    return 0;
+}
+
+static int buffer_read(void *ctx, void *data, size_t len) {
+    snapshot_buffer_t *b = (snapshot_buffer_t*)ctx;
+    if (len > b->left) return -1;
+    memcpy(data, b->pos, len);
+    b->pos += len;
+    b->left -= len;
+    return 0;
+}
+
+size_t allocator_snapshot_save(void *buf, size_t len) {
+    if (!buf || len < allocator_snapshot_size()) return 0;
+    snapshot_buffer_t b = { (uint8_t*)buf, len };
+    return allocator_snapshot_write(buffer_write, &b) == 0 ? allocator_snapshot_size() : 0;
+}
+
+int allocator_snapshot_restore(const void *buf, size_t len) {
+    if (!buf) return -1;
+    snapshot_buffer_t b = { (uint8_t*)(uintptr_t)buf, len };
+    return allocator_snapshot_read(buffer_read, &b);
+}
+
+void allocator_retain(void) {
+    lock_all();
+    snapshot_capture(&retained_meta);
+    atomic_store_explicit(&allocator_retained, 1, memory_order_relaxed);
+    unlock_all();
+}
+
+void allocator_retain_drop(void) {
+    /* Callers may hold different locks; only the first one clears the record */
+    if (atomic_exchange_explicit(&allocator_retained, 0, memory_order_relaxed) != 0) {
+        retained_meta.magic = 0;
+    }
+}
 
-    /* If nothing left, release metadata */
-    if (head_index == -1) {
-        try_uncarve_when_empty();
+int allocator_warm_boot(void) {
+    int adopted = 0;
+    lock_all();
+    if (snapshot_valid(&retained_meta) && retained_meta.base == (uint64_t)(uintptr_t)g_mem.raw) {
+        adopted = (snapshot_adopt(&retained_meta) == 0);
+    } else {
+        reset_state();
     }
+    retained_meta.magic = 0;
+    atomic_store_explicit(&allocator_retained, 0, memory_order_relaxed);
+    unlock_all();
+    return adopted;
 }
@@ -0,0 +1,220 @@
+/**
+ * @file allocator_cache.c
+ * @brief Object caches with constructed-state caching.
+ *
+ * A slab is one block of the pool: a header with the stack of free object
+ * indices, then the objects at the alignment of the cache. Slabs with a
+ * free object are on the partial list, the others on the full list.
+ */
+
+#include <string.h>
+#include "allocator_cache.h"
+
+/** Fewest objects in a slab, whatever ALLOCATOR_CACHE_SLAB_BYTES says. */
+#define CACHE_MIN_OBJECTS  4u
+
+/** Most objects in a slab (8-bit indices). */
+#define CACHE_MAX_OBJECTS  255u
+
+/**
+ * @struct cache_slab_t
+ * @brief Header at the start of a slab.
+ *
+ * @var cache_slab_t::next
+ *      Next slab on the same list.
+ * @var cache_slab_t::objs
+ *      First object.
+ * @var cache_slab_t::free_count
+ *      Entries of @c free in use.
+ * @var cache_slab_t::free_map
+ *      One bit per object, set while its index is in @c free.
+ * @var cache_slab_t::free
+ *      Indices of the free objects; the last one is handed out next.
+ */
+typedef struct cache_slab {
+    struct cache_slab *next;
+    uint8_t *objs;
+    uint32_t free_count;
+    uint32_t free_map[(CACHE_MAX_OBJECTS + 32u) / 32u];
+    uint8_t  free[];
+} cache_slab_t;
+
+struct cache {
+    uint32_t      stride;       /**< Distance between objects. */
+    uint32_t      align;        /**< Alignment of the objects. */
+    uint32_t      per_slab;     /**< Objects per slab. */
+    uint32_t      slab_bytes;   /**< Size of the block of a slab. */
+    cache_fn      ctor;
+    cache_fn      dtor;
+    cache_slab_t *partial;      /**< Slabs with at least one free object. */
+    cache_slab_t *full;         /**< Slabs with every object in use. */
+    cache_stats_t stats;
+};
+
+/* ---------------------------------------------------------------------------- */
+/*                                 Internal Helpers                             */
+/* ---------------------------------------------------------------------------- */
+
+/** Bytes of a slab header with room for @p n free indices. */
+static uint32_t header_bytes(uint32_t n) {
+    return (uint32_t)sizeof(cache_slab_t) + n;
+}
+
+/**
+ * @brief Allocates a slab and constructs all of its objects.
+ *
+ * @return The slab, with every object free, or NULL if the pool is exhausted.
+ */
+static cache_slab_t *slab_create(cache_t *c) {
+    cache_slab_t *s = (cache_slab_t*)(void*)allocate((int)c->slab_bytes);
+    if (s == NULL) return NULL;
+
+    uintptr_t first = (uintptr_t)s + header_bytes(c->per_slab);
+    first = (first + (c->align - 1u)) & ~(uintptr_t)(c->align - 1u);
+    s->objs = (uint8_t*)first;
+    s->free_count = c->per_slab;
+    memset(s->free_map, 0, sizeof s->free_map);
+    for (uint32_t i = 0; i < c->per_slab; ++i) {
+        /* Lowest addresses on top of the stack, so they are used first */
+        s->free[i] = (uint8_t)(c->per_slab - 1u - i);
+        s->free_map[i / 32u] |= 1u << (i % 32u);
+        if (c->ctor != NULL) c->ctor(s->objs + i * c->stride);
+    }
+    c->stats.constructed += (c->ctor != NULL) ? c->per_slab : 0;
+    ++c->stats.slabs;
+    c->stats.objects += c->per_slab;
+    return s;
+}
+
+/**
+ * @brief Destroys the objects of an empty slab and frees it.
+ */
+static void slab_release(cache_t *c, cache_slab_t *s) {
+    if (c->dtor != NULL) {
+        for (uint32_t i = 0; i < c->per_slab; ++i) c->dtor(s->objs + i * c->stride);
+    }
+    --c->stats.slabs;
+    c->stats.objects -= c->per_slab;
+    deallocate((int*)(void*)s);
+}
+
+/**
+ * @brief Finds the slab holding @p obj in a list.
+ *
+ * @param link Receives the link that points to the slab.
+ * @return The slab, or NULL if @p obj is not an object of the list.
+ */
+static cache_slab_t *slab_find(const cache_t *c, cache_slab_t **head, const uint8_t *obj,
+                               cache_slab_t ***link) {
+    for (cache_slab_t **l = head; *l != NULL; l = &(*l)->next) {
+        const uint8_t *objs = (*l)->objs;
+        if (obj < objs || obj >= objs + c->per_slab * c->stride) continue;
+        if ((uint32_t)(obj - objs) % c->stride != 0) return NULL;
+        *link = l;
+        return *l;
+    }
+    return NULL;
+}
+
+/* ---------------------------------------------------------------------------- */
+/*                              Public API Implementation                       */
+/* ---------------------------------------------------------------------------- */
+
+cache_t *cache_create(uint32_t size, uint32_t align, cache_fn ctor, cache_fn dtor) {
+    if (align == 0) align = ALLOCATOR_ALIGNMENT;
+    if (size == 0 || (align & (align - 1u)) != 0 || align > ALLOCATOR_TOTAL_MEMORY) return NULL;
+    if (size > ALLOCATOR_TOTAL_MEMORY / CACHE_MIN_OBJECTS) return NULL;
+
+    uint32_t stride = (size + (align - 1u)) & ~(align - 1u);
+    uint32_t n = (ALLOCATOR_CACHE_SLAB_BYTES - (uint32_t)sizeof(cache_slab_t)) / (stride + 1u);
+    if (n < CACHE_MIN_OBJECTS) n = CACHE_MIN_OBJECTS;
+    if (n > CACHE_MAX_OBJECTS) n = CACHE_MAX_OBJECTS;
+
+    /* Blocks are ALLOCATOR_ALIGNMENT-aligned; stricter objects need slack */
+    uint32_t pad = (align > ALLOCATOR_ALIGNMENT) ? align - ALLOCATOR_ALIGNMENT : 0;
+    uint64_t bytes = (uint64_t)header_bytes(n) + pad + (uint64_t)n * stride;
+    if (bytes > ALLOCATOR_TOTAL_MEMORY) return NULL;
+
+    cache_t *c = (cache_t*)(void*)allocate_fast((int)sizeof(cache_t));
+    if (c == NULL) return NULL;
+    memset(c, 0, sizeof *c);
+    c->stride     = stride;
+    c->align      = align;
+    c->per_slab   = n;
+    c->slab_bytes = (uint32_t)bytes;
+    c->ctor       = ctor;
+    c->dtor       = dtor;
+    return c;
+}
+
+void *cache_alloc(cache_t *cache) {
+    cache_slab_t *s = cache->partial;
+    if (ALLOCATOR_UNLIKELY(s == NULL)) {
+        s = slab_create(cache);
+        if (s == NULL) return NULL;
+        s->next = NULL;
+        cache->partial = s;
+    }
+
+    uint8_t idx = s->free[--s->free_count];
+    s->free_map[idx / 32u] &= ~(1u << (idx % 32u));
+    if (s->free_count == 0) {
+        cache->partial = s->next;
+        s->next = cache->full;
+        cache->full = s;
+    }
+    ++cache->stats.in_use;
+    ++cache->stats.allocs;
+    return s->objs + idx * cache->stride;
+}
+
+void cache_free(cache_t *cache, void *obj) {
+    if (obj == NULL) return;
+    const uint8_t *p = (const uint8_t*)obj;
+    cache_slab_t **link;
+
+    cache_slab_t *s = slab_find(cache, &cache->full, p, &link);
+    if (s != NULL) {
+        /* No longer full: move it to the front of the partial list */
+        *link = s->next;
+        s->next = cache->partial;
+        cache->partial = s;
+    } else {
+        s = slab_find(cache, &cache->partial, p, &link);
+        if (s == NULL) return;
+    }
+
+    uint32_t idx = (uint32_t)(p - s->objs) / cache->stride;
+    if (s->free_map[idx / 32u] & (1u << (idx % 32u))) return; /* double free */
+    s->free_map[idx / 32u] |= 1u << (idx % 32u);
+    s->free[s->free_count++] = (uint8_t)idx;
+    --cache->stats.in_use;
+}
+
+uint32_t cache_reap(cache_t *cache) {
+    uint32_t released = 0;
+    cache_slab_t **l = &cache->partial;
+    while (*l != NULL) {
+        cache_slab_t *s = *l;
+        if (s->free_count == cache->per_slab) {
+            *l = s->next;
+            slab_release(cache, s);
+            ++released;
+        } else {
+            l = &s->next;
+        }
+    }
+    return released;
+}
+
+int cache_destroy(cache_t *cache) {
+    if (cache == NULL) return 0;
+    if (cache->stats.in_use != 0) return -1;
+    cache_reap(cache);
+    deallocate_fast((int*)(void*)cache);
+    return 0;
+}
+
+void cache_get_stats(const cache_t *cache, cache_stats_t *stats) {
+    *stats = cache->stats;
+}
@@ -0,0 +1,207 @@
+/**
+ * @file allocator_classes.c
+ * @brief Size-class tuning from a histogram of requested sizes.
+ */
+
+#include <string.h>
+#include "allocator_classes.h"
+
+#define BUCKETS  ALLOCATOR_CLASS_BUCKETS
+#define CLASSES  ALLOCATOR_NUM_CLASSES
+#define GRANULE  ALLOCATOR_CLASS_GRANULE
+
+/* DP tables of allocator_classes_tune(); static to keep them off the stack. */
+static uint64_t cost_to[CLASSES + 1u][BUCKETS + 1u];
+static uint16_t split_at[CLASSES + 1u][BUCKETS + 1u];
+
+/* ---------------------------------------------------------------------------- */
+/*                                 Internal Helpers                             */
+/* ---------------------------------------------------------------------------- */
+
+/**
+ * @brief Maps every granule to the smallest class that holds it and sums the
+ *        bytes lost to rounding.
+ */
+static uint64_t layout_index(allocator_class_layout_t *layout, const uint32_t *hist) {
+    uint64_t waste = 0;
+    uint32_t cls = 0;
+    for (uint32_t b = 0; b < BUCKETS; ++b) {
+        while (cls < CLASSES - 1u && layout->size[cls] < (b + 1u) * GRANULE) ++cls;
+        layout->index[b] = (uint8_t)cls;
+        if (hist != NULL) waste += (uint64_t)hist[b] * (layout->size[cls] - (b + 1u) * GRANULE);
+    }
+    return waste;
+}
+
+/**
+ * @brief Appends a string to a bounded buffer, counting the full length.
+ */
+static void put_str(char *buf, size_t len, size_t *pos, const char *s) {
+    for (; *s; ++s, ++*pos) {
+        if (*pos + 1u < len) buf[*pos] = *s;
+    }
+}
+
+/**
+ * @brief Appends an unsigned decimal number.
+ */
+static void put_u(char *buf, size_t len, size_t *pos, uint64_t v) {
+    char digits[21];
+    uint32_t n = 0;
+    do {
+        digits[n++] = (char)('0' + v % 10u);
+        v /= 10u;
+    } while (v != 0);
+    char s[22];
+    for (uint32_t i = 0; i < n; ++i) s[i] = digits[n - 1u - i];
+    s[n] = '\0';
+    put_str(buf, len, pos, s);
+}
+
+/**
+ * @brief Appends "#define name { v0, v1, ... }" for a 16- or 8-bit array.
+ */
+static void put_table(char *buf, size_t len, size_t *pos, const char *name,
+                      const uint16_t *w, const uint8_t *b, uint32_t count) {
+    put_str(buf, len, pos, "#define ");
+    put_str(buf, len, pos, name);
+    put_str(buf, len, pos, " {");
+    for (uint32_t i = 0; i < count; ++i) {
+        put_str(buf, len, pos, i ? ", " : " ");
+        put_u(buf, len, pos, w ? w[i] : b[i]);
+    }
+    put_str(buf, len, pos, " }\n");
+}
+
+/* ---------------------------------------------------------------------------- */
+/*                              Public API Implementation                       */
+/* ---------------------------------------------------------------------------- */
+
+void allocator_classes_current(const uint32_t *hist, allocator_class_layout_t *layout) {
+    memset(layout, 0, sizeof *layout);
+    for (uint32_t cls = 0; cls < CLASSES; ++cls) {
+        layout->size[cls] = (uint16_t)allocator_class_size(cls);
+    }
+    layout->waste = layout_index(layout, hist);
+}
+
+void allocator_classes_tune(const uint32_t *hist, uint32_t slab_budget,
+                            allocator_class_layout_t *layout) {
+    /* Prefix sums: requests and granules requested in buckets [0, j) */
+    static uint64_t count[BUCKETS + 1u], units[BUCKETS + 1u];
+    for (uint32_t j = 0; j < BUCKETS; ++j) {
+        count[j + 1u] = count[j] + hist[j];
+        units[j + 1u] = units[j] + (uint64_t)hist[j] * (j + 1u);
+    }
+
+    /* cost_to[k][j]: least waste serving buckets [0, j) with k classes, the
+     * largest of size j granules. Class k covers buckets [i, j). */
+    for (uint32_t j = 1; j <= BUCKETS; ++j) {
+        cost_to[1][j] = GRANULE * ((uint64_t)j * count[j] - units[j]);
+        split_at[1][j] = 0;
+    }
+    for (uint32_t k = 2; k <= CLASSES; ++k) {
+        for (uint32_t j = k; j <= BUCKETS; ++j) {
+            uint64_t best = UINT64_MAX;
+            uint32_t best_i = k - 1u;
+            for (uint32_t i = k - 1u; i < j; ++i) {
+                uint64_t c = cost_to[k - 1u][i] +
+                             GRANULE * ((uint64_t)j * (count[j] - count[i]) - (units[j] - units[i]));
+                if (c < best) {
+                    best = c;
+                    best_i = i;
+                }
+            }
+            cost_to[k][j] = best;
+            split_at[k][j] = (uint16_t)best_i;
+        }
+    }
+
+    memset(layout, 0, sizeof *layout);
+    for (uint32_t k = CLASSES, j = BUCKETS; k >= 1u; j = split_at[k][j], --k) {
+        layout->size[k - 1u] = (uint16_t)(j * GRANULE);
+    }
+    layout->waste = layout_index(layout, hist);
+
+    /* Slabs in proportion to the bytes each class hands out (largest
+     * remainder, so the budget is used exactly) */
+    uint64_t demand[CLASSES] = { 0 };
+    uint64_t total = 0;
+    for (uint32_t b = 0; b < BUCKETS; ++b) {
+        uint32_t cls = layout->index[b];
+        demand[cls] += (uint64_t)hist[b] * layout->size[cls];
+        total += (uint64_t)hist[b] * layout->size[cls];
+    }
+    if (total == 0) return;
+    uint64_t rem[CLASSES];
+    uint32_t given = 0;
+    for (uint32_t cls = 0; cls < CLASSES; ++cls) {
+        uint64_t share = demand[cls] * slab_budget;
+        layout->slabs[cls] = (uint16_t)(share / total);
+        rem[cls] = share % total;
+        given += layout->slabs[cls];
+    }
+    for (; given < slab_budget; ++given) {
+        uint32_t top = 0;
+        for (uint32_t cls = 1; cls < CLASSES; ++cls) {
+            if (rem[cls] > rem[top]) top = cls;
+        }
+        ++layout->slabs[top];
+        rem[top] = 0;
+    }
+}
+
+size_t allocator_classes_export(const allocator_class_layout_t *layout, char *buf, size_t len) {
+    size_t pos = 0;
+    put_str(buf, len, &pos, "/* Size classes from allocator_classes_tune(); waste ");
+    put_u(buf, len, &pos, layout->waste);
+    put_str(buf, len, &pos, " bytes */\n#define ALLOCATOR_CLASS_GRANULE ");
+    put_u(buf, len, &pos, GRANULE);
+    put_str(buf, len, &pos, "u\n#define ALLOCATOR_NUM_CLASSES ");
+    put_u(buf, len, &pos, CLASSES);
+    put_str(buf, len, &pos, "u\n#define ALLOCATOR_SMALL_MAX ");
+    put_u(buf, len, &pos, layout->size[CLASSES - 1u]);
+    put_str(buf, len, &pos, "u\n");
+    put_table(buf, len, &pos, "ALLOCATOR_CLASS_TABLE", layout->size, NULL, CLASSES);
+    put_table(buf, len, &pos, "ALLOCATOR_CLASS_INDEX", NULL, layout->index, BUCKETS);
+    put_table(buf, len, &pos, "ALLOCATOR_CLASS_PREFILL", layout->slabs, NULL, CLASSES);
+    if (len != 0) buf[pos < len ? pos : len - 1u] = '\0';
+    return pos;
+}
+
+int allocator_classes_prefill(const uint16_t *slabs) {
+    for (uint32_t cls = 0; cls < CLASSES; ++cls) {
+        for (uint32_t n = 0; n < slabs[cls]; ++n) {
+            allocator_free_block_t *last;
+            allocator_free_block_t *first = allocator_slab_carve(cls, 0, &last);
+            if (first == NULL) return -1;
+            allocator_slab_share(cls, first, last);
+        }
+    }
+    return 0;
+}
+
+#if ALLOCATOR_ADAPTIVE_CLASSES
+/** Copy of the counters handed out by allocator_size_histogram(). */
+static uint32_t hist_copy[BUCKETS + 1u];
+
+const uint32_t *allocator_size_histogram(void) {
+    for (uint32_t i = 0; i <= BUCKETS; ++i) {
+        hist_copy[i] = atomic_load_explicit(&allocator_size_hist[i], memory_order_relaxed);
+    }
+    return hist_copy;
+}
+
+void allocator_size_histogram_reset(void) {
+    for (uint32_t i = 0; i <= BUCKETS; ++i) {
+        atomic_store_explicit(&allocator_size_hist[i], 0, memory_order_relaxed);
+    }
+}
+
+int allocator_classes_retune(uint32_t slab_budget, allocator_class_layout_t *layout) {
+    allocator_class_layout_t tuned;
+    allocator_classes_tune(allocator_size_histogram(), slab_budget, &tuned);
+    if (layout != NULL) *layout = tuned;
+    return allocator_classes_apply(&tuned);
+}
+#endif
@@ -0,0 +1,118 @@
+/**
+ * @file allocator_isr.c
+ * @brief Interrupt-safe fixed-size buffer pools refilled from the main
+ *        allocator in thread context.
+ */
+
+#include "allocator_isr.h"
+#include "allocator_irq.h"
+
+/* ---------------------------------------------------------------------------- */
+/*                                 Internal Helpers                             */
+/* ---------------------------------------------------------------------------- */
+
+/**
+ * @brief Pushes a buffer with interrupts masked for the pointer swap only.
+ */
+static void pool_push(isr_pool_t *pool, allocator_free_block_t *b) {
+    allocator_irq_state_t s = allocator_irq_save();
+    b->next = pool->free;
+    pool->free = b;
+    pool->count = (uint16_t)(pool->count + 1u);
+    allocator_irq_restore(s);
+}
+
+/**
+ * @brief Pops a buffer with interrupts masked for the pointer swap only.
+ *
+ * @return The buffer, or NULL if the list is empty.
+ */
+static allocator_free_block_t *pool_pop(isr_pool_t *pool) {
+    allocator_irq_state_t s = allocator_irq_save();
+    allocator_free_block_t *b = pool->free;
+    if (b != NULL) {
+        pool->free = b->next;
+        pool->count = (uint16_t)(pool->count - 1u);
+    }
+    allocator_irq_restore(s);
+    return b;
+}
+
+/**
+ * @brief Takes one buffer from the main allocator.
+ */
+static allocator_free_block_t *block_from_allocator(const isr_pool_t *pool) {
+    return (allocator_free_block_t*)(void*)allocate_fast((int)pool->block_size);
+}
+
+/* ---------------------------------------------------------------------------- */
+/*                              Public API Implementation                       */
+/* ---------------------------------------------------------------------------- */
+
+int isr_pool_init(isr_pool_t *pool, uint32_t block_size, uint16_t target,
+                  uint16_t low_water) {
+    if (pool == NULL || block_size == 0 || block_size > UINT16_MAX) return -1;
+    if (block_size < sizeof(allocator_free_block_t)) {
+        block_size = sizeof(allocator_free_block_t);
+    }
+
+    pool->free           = NULL;
+    pool->count          = 0;
+    pool->target         = target;
+    pool->low_water      = (low_water > target) ? target : low_water;
+    pool->block_size     = (uint16_t)block_size;
+    pool->refill_pending = 0;
+    pool->misses         = 0;
+
+    return (isr_pool_refill(pool) == target) ? 0 : -1;
+}
+
+int *isr_alloc(isr_pool_t *pool) {
+    allocator_irq_state_t s = allocator_irq_save();
+    allocator_free_block_t *b = pool->free;
+    if (ALLOCATOR_LIKELY(b != NULL)) {
+        pool->free = b->next;
+        pool->count = (uint16_t)(pool->count - 1u);
+    }
+    if (pool->count < pool->low_water) pool->refill_pending = 1;
+    if (ALLOCATOR_UNLIKELY(b == NULL)) ++pool->misses;
+    allocator_irq_restore(s);
+    return (int*)(void*)b;
+}
+
+void isr_free(isr_pool_t *pool, int *ptr) {
+    if (ptr == NULL) return;
+    pool_push(pool, (allocator_free_block_t*)(void*)ptr);
+}
+
+uint32_t isr_pool_refill(isr_pool_t *pool) {
+    uint32_t added = 0;
+    pool->refill_pending = 0;
+
+    /* Allocator calls happen with interrupts enabled; only the push masks them */
+    while (pool->count < pool->target) {
+        allocator_free_block_t *b = block_from_allocator(pool);
+        if (b == NULL) {
+            pool->refill_pending = 1;   /* try again later */
+            break;
+        }
+        pool_push(pool, b);
+        ++added;
+    }
+
+    /* Buffers freed from thread context may push the count above target */
+    while (pool->count > pool->target) {
+        allocator_free_block_t *b = pool_pop(pool);
+        if (b == NULL) break;
+        deallocate_fast((int*)(void*)b);
+    }
+    return added;
+}
+
+void isr_pool_drain(isr_pool_t *pool) {
+    allocator_free_block_t *b;
+    while ((b = pool_pop(pool)) != NULL) {
+        deallocate_fast((int*)(void*)b);
+    }
+    pool->refill_pending = 0;
+}
@@ -0,0 +1,44 @@
+/**
+ * @file allocator_lock_freertos.c
+ * @brief Allocator locks implemented with statically allocated FreeRTOS
+ *        mutexes (requires configSUPPORT_STATIC_ALLOCATION).
+ *
+ * The mutexes are created on first use of allocator_lock_ops_freertos(),
+ * which must therefore be called before the scheduler starts or from a
+ * single task.
+ */
+
+#include "FreeRTOS.h"
+#include "semphr.h"
+#include "allocator_lock.h"
+
+static StaticSemaphore_t mutex_storage[ALLOCATOR_LOCK_COUNT];
+static SemaphoreHandle_t mutexes[ALLOCATOR_LOCK_COUNT];
+
+static void freertos_lock(void *ctx, uint32_t id) {
+    (void)ctx;
+    xSemaphoreTake(mutexes[id], portMAX_DELAY);
+}
+
+static void freertos_unlock(void *ctx, uint32_t id) {
+    (void)ctx;
+    xSemaphoreGive(mutexes[id]);
+}
+
+static int freertos_trylock(void *ctx, uint32_t id) {
+    (void)ctx;
+    return xSemaphoreTake(mutexes[id], 0) == pdTRUE;
+}
+
+static const allocator_lock_ops_t freertos_ops = {
+    freertos_lock, freertos_unlock, NULL, freertos_trylock
+};
+
+const allocator_lock_ops_t *allocator_lock_ops_freertos(void) {
+    if (mutexes[0] == NULL) {
+        for (uint32_t i = 0; i < ALLOCATOR_LOCK_COUNT; ++i) {
+            mutexes[i] = xSemaphoreCreateMutexStatic(&mutex_storage[i]);
+        }
+    }
+    return &freertos_ops;
+}
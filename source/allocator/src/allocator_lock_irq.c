@@ -0,0 +1,37 @@
+/**
+ * @file allocator_lock_irq.c
+ * @brief Allocator locks implemented by masking interrupts (single core).
+ *
+ * Each lock id remembers the interrupt state saved when it was taken; since
+ * the allocator releases locks in reverse order, restoring that state unmasks
+ * interrupts exactly when the outermost lock is released.
+ */
+
+#include "allocator_lock.h"
+#include "allocator_irq.h"
+
+/** Interrupt state saved by each held lock. */
+static allocator_irq_state_t saved_state[ALLOCATOR_LOCK_COUNT];
+
+static void irq_lock(void *ctx, uint32_t id) {
+    (void)ctx;
+    allocator_irq_state_t s = allocator_irq_save();
+    saved_state[id] = s;
+}
+
+static void irq_unlock(void *ctx, uint32_t id) {
+    (void)ctx;
+    allocator_irq_restore(saved_state[id]);
+}
+
+/* With interrupts masked nothing else can hold a lock on a single core */
+static int irq_trylock(void *ctx, uint32_t id) {
+    irq_lock(ctx, id);
+    return 1;
+}
+
+static const allocator_lock_ops_t irq_ops = { irq_lock, irq_unlock, NULL, irq_trylock };
+
+const allocator_lock_ops_t *allocator_lock_ops_irq(void) {
+    return &irq_ops;
+}
@@ -0,0 +1,74 @@
+/**
+ * @file allocator_lock_pthread.c
+ * @brief Allocator locks implemented with POSIX mutexes (hosted builds).
+ */
+
+#include <pthread.h>
+#include "allocator_lock.h"
+
+/** One mutex per lock id; initialized by allocator_lock_ops_pthread(). */
+static pthread_mutex_t mutexes[ALLOCATOR_LOCK_COUNT];
+static pthread_once_t mutexes_once = PTHREAD_ONCE_INIT;
+
+/** Single mutex shared by every lock id (global-lock baseline). */
+static pthread_mutex_t global_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static void mutexes_init(void) {
+    for (uint32_t i = 0; i < ALLOCATOR_LOCK_COUNT; ++i) pthread_mutex_init(&mutexes[i], NULL);
+}
+
+static void pthread_lock(void *ctx, uint32_t id) {
+    (void)ctx;
+    pthread_mutex_lock(&mutexes[id]);
+}
+
+static void pthread_unlock(void *ctx, uint32_t id) {
+    (void)ctx;
+    pthread_mutex_unlock(&mutexes[id]);
+}
+
+static int pthread_trylock(void *ctx, uint32_t id) {
+    (void)ctx;
+    return pthread_mutex_trylock(&mutexes[id]) == 0;
+}
+
+/* The allocator may nest locks (class, then core); with one mutex only the
+ * outermost acquisition may lock it. The nesting depth is per thread. */
+static _Thread_local uint32_t global_depth;
+
+static void pthread_global_lock(void *ctx, uint32_t id) {
+    (void)ctx;
+    (void)id;
+    if (global_depth++ == 0) pthread_mutex_lock(&global_mutex);
+}
+
+static void pthread_global_unlock(void *ctx, uint32_t id) {
+    (void)ctx;
+    (void)id;
+    if (--global_depth == 0) pthread_mutex_unlock(&global_mutex);
+}
+
+static int pthread_global_trylock(void *ctx, uint32_t id) {
+    (void)ctx;
+    (void)id;
+    if (global_depth == 0 && pthread_mutex_trylock(&global_mutex) != 0) return 0;
+    ++global_depth;
+    return 1;
+}
+
+static const allocator_lock_ops_t pthread_ops = {
+    pthread_lock, pthread_unlock, NULL, pthread_trylock
+};
+
+static const allocator_lock_ops_t pthread_global_ops = {
+    pthread_global_lock, pthread_global_unlock, NULL, pthread_global_trylock
+};
+
+const allocator_lock_ops_t *allocator_lock_ops_pthread(void) {
+    pthread_once(&mutexes_once, mutexes_init);
+    return &pthread_ops;
+}
+
+const allocator_lock_ops_t *allocator_lock_ops_pthread_global(void) {
+    return &pthread_global_ops;
+}
@@ -0,0 +1,45 @@
+/**
+ * @file allocator_lock_spin.c
+ * @brief Allocator locks implemented as C11 atomic spinlocks.
+ *
+ * Suitable for SMP targets and for RTOS builds where critical sections are
+ * shorter than a context switch. Requires lock-free atomic_bool support.
+ */
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include "allocator_lock.h"
+
+/**
+ * One spinlock per lock id, each on its own cache line. Static atomics start
+ * out zero, i.e. unlocked, so the array needs no initializer.
+ */
+static struct {
+    atomic_bool locked;
+    uint8_t     _pad[64 - sizeof(atomic_bool)];
+} spin_locks[ALLOCATOR_LOCK_COUNT];
+
+static void spin_lock(void *ctx, uint32_t id) {
+    (void)ctx;
+    while (atomic_exchange_explicit(&spin_locks[id].locked, true, memory_order_acquire)) {
+#if defined(__x86_64__) || defined(__i386__)
+        __builtin_ia32_pause();
+#endif
+    }
+}
+
+static void spin_unlock(void *ctx, uint32_t id) {
+    (void)ctx;
+    atomic_store_explicit(&spin_locks[id].locked, false, memory_order_release);
+}
+
+static int spin_trylock(void *ctx, uint32_t id) {
+    (void)ctx;
+    return !atomic_exchange_explicit(&spin_locks[id].locked, true, memory_order_acquire);
+}
+
+static const allocator_lock_ops_t spin_ops = { spin_lock, spin_unlock, NULL, spin_trylock };
+
+const allocator_lock_ops_t *allocator_lock_ops_spin(void) {
+    return &spin_ops;
+}
@@ -0,0 +1,37 @@
+/**
+ * @file allocator_lock_zephyr.c
+ * @brief Allocator locks implemented with Zephyr kernel mutexes.
+ */
+
+#include <zephyr/kernel.h>
+#include "allocator_lock.h"
+
+static struct k_mutex mutexes[ALLOCATOR_LOCK_COUNT];
+static uint8_t initialized;
+
+static void zephyr_lock(void *ctx, uint32_t id) {
+    (void)ctx;
+    k_mutex_lock(&mutexes[id], K_FOREVER);
+}
+
+static void zephyr_unlock(void *ctx, uint32_t id) {
+    (void)ctx;
+    k_mutex_unlock(&mutexes[id]);
+}
+
+static int zephyr_trylock(void *ctx, uint32_t id) {
+    (void)ctx;
+    return k_mutex_lock(&mutexes[id], K_NO_WAIT) == 0;
+}
+
+static const allocator_lock_ops_t zephyr_ops = {
+    zephyr_lock, zephyr_unlock, NULL, zephyr_trylock
+};
+
+const allocator_lock_ops_t *allocator_lock_ops_zephyr(void) {
+    if (!initialized) {
+        for (uint32_t i = 0; i < ALLOCATOR_LOCK_COUNT; ++i) k_mutex_init(&mutexes[i]);
+        initialized = 1;
+    }
+    return &zephyr_ops;
+}
@@ -0,0 +1,267 @@
+/**
+ * @file allocator_magazine.c
+ * @brief Magazine depot shared by the per-core magazine caches.
+ *
+ * The depot of each size class is a pair of magazine stacks (full and empty)
+ * under ALLOCATOR_LOCK_DEPOT(cls). The depot lock is never held while calling
+ * into the allocator, so it does not nest with the class or core locks.
+ */
+
+#include "allocator_magazine.h"
+#include "allocator_lock.h"
+
+/* ---------------------------------------------------------------------------- */
+/*                                 Internal State                               */
+/* ---------------------------------------------------------------------------- */
+
+/**
+ * @struct mag_depot_t
+ * @brief Depot of one size class.
+ *
+ * @var mag_depot_t::full
+ *      Stack of full magazines.
+ * @var mag_depot_t::empty
+ *      Stack of empty magazines.
+ * @var mag_depot_t::stats
+ *      Counters and current magazine size (stats.magazine_size; 0 until the
+ *      depot is first used, see depot_get()).
+ * @var mag_depot_t::contended_since_grow
+ *      Contended accesses since the last automatic resize.
+ */
+typedef struct {
+    mag_magazine_t *full;
+    mag_magazine_t *empty;
+    mag_depot_stats_t stats;
+    uint32_t contended_since_grow;
+} mag_depot_t;
+
+static mag_depot_t depots[ALLOCATOR_NUM_CLASSES];
+
+/* ---------------------------------------------------------------------------- */
+/*                                 Internal Helpers                             */
+/* ---------------------------------------------------------------------------- */
+
+/**
+ * @brief Depot of a size class, with the default magazine size filled in on
+ *        first use. Caller holds the depot lock.
+ */
+static mag_depot_t *depot_get(uint32_t cls) {
+    mag_depot_t *d = &depots[cls];
+    if (d->stats.magazine_size == 0) d->stats.magazine_size = ALLOCATOR_MAGAZINE_SIZE;
+    return d;
+}
+
+/**
+ * @brief Takes the depot lock of a size class, recording contention and
+ *        growing the magazine size of a class that keeps contending.
+ */
+static mag_depot_t *depot_lock(uint32_t cls) {
+    int contended = allocator_lock_contended(ALLOCATOR_LOCK_DEPOT(cls));
+    mag_depot_t *d = depot_get(cls);
+    ++d->stats.accesses;
+    if (contended) {
+        ++d->stats.contended;
+#if ALLOCATOR_MAGAZINE_GROW_AFTER > 0
+        if (++d->contended_since_grow >= ALLOCATOR_MAGAZINE_GROW_AFTER &&
+            d->stats.magazine_size < ALLOCATOR_MAGAZINE_MAX) {
+            d->stats.magazine_size *= 2u;
+            if (d->stats.magazine_size > ALLOCATOR_MAGAZINE_MAX) {
+                d->stats.magazine_size = ALLOCATOR_MAGAZINE_MAX;
+            }
+            d->contended_since_grow = 0;
+            ++d->stats.resizes;
+        }
+#endif
+    }
+    return d;
+}
+
+static void depot_unlock(uint32_t cls) {
+    allocator_unlock(ALLOCATOR_LOCK_DEPOT(cls));
+}
+
+/** Pushes a magazine onto a depot stack. Caller holds the depot lock. */
+static void mag_push(mag_magazine_t **stack, mag_magazine_t *m) {
+    m->next = *stack;
+    *stack = m;
+}
+
+/** Pops a magazine from a depot stack. Caller holds the depot lock. */
+static mag_magazine_t *mag_pop(mag_magazine_t **stack) {
+    mag_magazine_t *m = *stack;
+    if (m != NULL) *stack = m->next;
+    return m;
+}
+
+/** Returns a magazine to its depot, as full or empty. */
+static void depot_put(uint32_t cls, mag_magazine_t *m, int full) {
+    mag_depot_t *d = depot_lock(cls);
+    if (full) {
+        mag_push(&d->full, m);
+        ++d->stats.full;
+    } else {
+        mag_push(&d->empty, m);
+        ++d->stats.empty;
+    }
+    depot_unlock(cls);
+}
+
+/** Frees the blocks held by a magazine to the shared size-class lists. */
+static void mag_spill(mag_magazine_t *m) {
+    while (m->rounds != 0) deallocate_fast(m->round[--m->rounds]);
+}
+
+/* ---------------------------------------------------------------------------- */
+/*                              Public API Implementation                       */
+/* ---------------------------------------------------------------------------- */
+
+void mag_cache_init(mag_cache_t *cc) {
+    if (!cc) return;
+    for (uint32_t cls = 0; cls < ALLOCATOR_NUM_CLASSES; ++cls) {
+        cc->loaded[cls] = NULL;
+        cc->previous[cls] = NULL;
+    }
+    cc->depot_exchanges = 0;
+    cc->slab_allocs = 0;
+    cc->slab_frees = 0;
+}
+
+void mag_cache_flush(mag_cache_t *cc) {
+    if (!cc) return;
+    for (uint32_t cls = 0; cls < ALLOCATOR_NUM_CLASSES; ++cls) {
+        mag_magazine_t *mags[2] = { cc->loaded[cls], cc->previous[cls] };
+        for (uint32_t i = 0; i < 2u; ++i) {
+            mag_magazine_t *m = mags[i];
+            if (m == NULL) continue;
+            int full = (m->rounds != 0 && m->rounds == m->capacity);
+            if (!full) mag_spill(m);
+            depot_put(cls, m, full);
+        }
+        cc->loaded[cls] = NULL;
+        cc->previous[cls] = NULL;
+    }
+}
+
+void mag_depot_set_size(uint32_t cls, uint32_t rounds) {
+    if (cls >= ALLOCATOR_NUM_CLASSES) return;
+    if (rounds < 1u) rounds = 1u;
+    if (rounds > ALLOCATOR_MAGAZINE_MAX) rounds = ALLOCATOR_MAGAZINE_MAX;
+    allocator_lock(ALLOCATOR_LOCK_DEPOT(cls));
+    depots[cls].stats.magazine_size = rounds;
+    depots[cls].contended_since_grow = 0;
+    allocator_unlock(ALLOCATOR_LOCK_DEPOT(cls));
+}
+
+void mag_depot_get_stats(uint32_t cls, mag_depot_stats_t *out) {
+    if (cls >= ALLOCATOR_NUM_CLASSES || !out) return;
+    allocator_lock(ALLOCATOR_LOCK_DEPOT(cls));
+    *out = depot_get(cls)->stats;
+    allocator_unlock(ALLOCATOR_LOCK_DEPOT(cls));
+}
+
+void mag_depot_reap(void) {
+    for (uint32_t cls = 0; cls < ALLOCATOR_NUM_CLASSES; ++cls) {
+        allocator_lock(ALLOCATOR_LOCK_DEPOT(cls));
+        mag_magazine_t *full = depots[cls].full;
+        mag_magazine_t *empty = depots[cls].empty;
+        depots[cls].full = NULL;
+        depots[cls].empty = NULL;
+        depots[cls].stats.full = 0;
+        depots[cls].stats.empty = 0;
+        allocator_unlock(ALLOCATOR_LOCK_DEPOT(cls));
+
+        mag_magazine_t *lists[2] = { full, empty };
+        for (uint32_t i = 0; i < 2u; ++i) {
+            mag_magazine_t *m = lists[i];
+            while (m) {
+                mag_magazine_t *next = m->next;
+                mag_spill(m);
+                deallocate((int*)(void*)m);
+                m = next;
+            }
+        }
+    }
+}
+
+int *mag_alloc_slow(mag_cache_t *cc, uint32_t cls) {
+    mag_magazine_t *m = cc->loaded[cls];
+    mag_magazine_t *prev = cc->previous[cls];
+
+    /* The previous magazine is either full or empty */
+    if (prev != NULL && prev->rounds != 0) {
+        cc->loaded[cls] = prev;
+        cc->previous[cls] = m;
+        return prev->round[--prev->rounds];
+    }
+
+    /* Both empty: trade the previous one for a full magazine */
+    mag_depot_t *d = depot_lock(cls);
+    mag_magazine_t *full = mag_pop(&d->full);
+    if (full != NULL) {
+        --d->stats.full;
+        ++d->stats.full_gets;
+        if (prev != NULL) {
+            mag_push(&d->empty, prev);
+            ++d->stats.empty;
+        }
+    } else {
+        ++d->stats.full_misses;
+    }
+    depot_unlock(cls);
+
+    if (full != NULL) {
+        ++cc->depot_exchanges;
+        cc->previous[cls] = m;
+        cc->loaded[cls] = full;
+        return full->round[--full->rounds];
+    }
+
+    ++cc->slab_allocs;
+    return allocate_fast((int)allocator_class_size(cls));
+}
+
+void mag_free_slow(mag_cache_t *cc, int *ptr, uint32_t cls) {
+    mag_magazine_t *m = cc->loaded[cls];
+    mag_magazine_t *prev = cc->previous[cls];
+
+    if (prev != NULL && prev->rounds == 0) {
+        cc->loaded[cls] = prev;
+        cc->previous[cls] = m;
+        prev->round[prev->rounds++] = ptr;
+        return;
+    }
+
+    /* Both full (or no magazine yet): trade the previous one for an empty one */
+    uint32_t size;
+    mag_depot_t *d = depot_lock(cls);
+    mag_magazine_t *empty = mag_pop(&d->empty);
+    if (empty != NULL) {
+        --d->stats.empty;
+        ++d->stats.empty_gets;
+        if (prev != NULL) {
+            mag_push(&d->full, prev);
+            ++d->stats.full;
+            prev = NULL;
+        }
+    }
+    size = d->stats.magazine_size;
+    depot_unlock(cls);
+
+    if (empty == NULL) {
+        empty = (mag_magazine_t*)(void*)allocate((int)sizeof(mag_magazine_t));
+        if (empty == NULL) {
+            ++cc->slab_frees;
+            deallocate_fast(ptr);
+            return;
+        }
+        empty->rounds = 0;
+        if (prev != NULL) depot_put(cls, prev, 1);
+    } else {
+        ++cc->depot_exchanges;
+    }
+    empty->capacity = (uint16_t)size;
+
+    cc->previous[cls] = m;
+    cc->loaded[cls] = empty;
+    empty->round[empty->rounds++] = ptr;
+}
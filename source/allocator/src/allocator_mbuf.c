@@ -0,0 +1,82 @@
+/**
+ * @file allocator_mbuf.c
+ * @brief Reference-counted message buffers.
+ *
+ * mbuf_alloc() places the owner header and the storage in one block. Headers
+ * made by mbuf_clone()/mbuf_slice() are separate small blocks that hold one
+ * reference to the owner, so the owner (and with it the storage) is freed
+ * after its own references and every other header are gone.
+ */
+
+#include "allocator_mbuf.h"
+
+/** Largest storage that still fits an int-sized request with its header. */
+#define MBUF_MAX_CAPACITY  ((uint32_t)INT32_MAX - (uint32_t)sizeof(mbuf_t))
+
+mbuf_t *mbuf_alloc(uint32_t headroom, uint32_t length) {
+    if (headroom > MBUF_MAX_CAPACITY || length > MBUF_MAX_CAPACITY - headroom) return NULL;
+    uint32_t capacity = headroom + length;
+
+    mbuf_t *b = (mbuf_t*)(void*)allocate_fast((int)(sizeof(mbuf_t) + capacity));
+    if (b == NULL) return NULL;
+    atomic_init(&b->refs, 1u);
+    b->offset   = headroom;
+    b->floor    = 0;
+    b->length   = length;
+    b->capacity = capacity;
+    b->owner    = b;
+    return b;
+}
+
+/**
+ * @brief Allocates a header onto the storage of @p b.
+ */
+static mbuf_t *header_new(mbuf_t *b, uint32_t offset, uint32_t floor, uint32_t length) {
+    mbuf_t *h = (mbuf_t*)(void*)allocate_fast((int)sizeof(mbuf_t));
+    if (h == NULL) return NULL;
+    atomic_init(&h->refs, 1u);
+    h->offset   = offset;
+    h->floor    = floor;
+    h->length   = length;
+    h->capacity = 0;
+    h->owner    = mbuf_ref(b->owner);
+    return h;
+}
+
+mbuf_t *mbuf_clone(mbuf_t *b) {
+    return header_new(b, b->offset, b->floor, b->length);
+}
+
+mbuf_t *mbuf_slice(mbuf_t *b, uint32_t offset, uint32_t length) {
+    if (offset > b->length || length > b->length - offset) return NULL;
+    uint32_t start = b->offset + offset;
+    return header_new(b, start, start, length);
+}
+
+void mbuf_release(mbuf_t *b) {
+    while (b != NULL) {
+        if (atomic_fetch_sub_explicit(&b->refs, 1u, memory_order_acq_rel) != 1u) return;
+        mbuf_t *owner = b->owner;
+        deallocate_fast((int*)(void*)b);
+        /* A separate header held one reference to the owner */
+        b = (owner != b) ? owner : NULL;
+    }
+}
+
+uint8_t *mbuf_pull(mbuf_t *b, uint32_t n) {
+    if (n > b->length) return NULL;
+    b->offset += n;
+    b->length -= n;
+    return mbuf_data(b);
+}
+
+uint8_t *mbuf_push(mbuf_t *b, uint32_t n) {
+    if (n > b->offset - b->floor) return NULL;
+    b->offset -= n;
+    b->length += n;
+    return mbuf_data(b);
+}
+
+void mbuf_trim(mbuf_t *b, uint32_t length) {
+    if (length < b->length) b->length = length;
+}
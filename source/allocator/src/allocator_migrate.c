@@ -0,0 +1,127 @@
+/**
+ * @file allocator_migrate.c
+ * @brief Relocatable blocks migrated between the memory tiers.
+ */
+
+#include <string.h>
+#include "allocator_migrate.h"
+
+mig_entry_t mig_table[ALLOCATOR_MIGRATE_MAX_HANDLES];
+
+/** Counters of mig_rebalance(). */
+static mig_stats_t stats;
+
+static int entry_is_fast(const mig_entry_t *e) {
+    return (allocator_region_attrs(e->ptr) & ALLOCATOR_REGION_FAST) != 0;
+}
+
+/**
+ * @brief Moves a block to the fast tier or to the main pool.
+ *
+ * @return 1 if the block was moved, 0 if the destination has no room.
+ */
+static int move_block(mig_entry_t *e, int to_fast) {
+    int *dst = to_fast ? allocate_flags((int)e->size, ALLOCATOR_F_FAST)
+                       : allocate((int)e->size);
+    if (dst == NULL) return 0;
+    memcpy(dst, e->ptr, e->size);
+    deallocate((int*)e->ptr);
+    e->ptr = dst;
+    if (to_fast) ++stats.promotions;
+    else ++stats.demotions;
+    stats.bytes_moved += e->size;
+    return 1;
+}
+
+/**
+ * @brief Finds the movable block of one tier with the highest (or lowest)
+ *        heat.
+ *
+ * @param fast    Tier to search (1 = fast tier, 0 = main pool).
+ * @param hottest Search for the highest heat instead of the lowest.
+ * @param limit   Only blocks with heat below this value (lowest search).
+ * @param skip    Blocks already handled in this pass.
+ * @return Index of the block, or -1 if there is none.
+ */
+static int32_t pick(int fast, int hottest, uint32_t limit, const uint8_t *skip) {
+    int32_t best = -1;
+    for (uint32_t i = 0; i < ALLOCATOR_MIGRATE_MAX_HANDLES; ++i) {
+        const mig_entry_t *e = &mig_table[i];
+        if (e->ptr == NULL || e->pins != 0 || skip[i]) continue;
+        if (entry_is_fast(e) != fast) continue;
+        if (hottest) {
+            if (e->heat == 0) continue;
+            if (best < 0 || e->heat > mig_table[best].heat) best = (int32_t)i;
+        } else {
+            if (e->heat >= limit) continue;
+            if (best < 0 || e->heat < mig_table[best].heat) best = (int32_t)i;
+        }
+    }
+    return best;
+}
+
+mig_handle_t mig_alloc(int size, uint32_t hint) {
+    if (size <= 0) return 0;
+    for (uint32_t i = 0; i < ALLOCATOR_MIGRATE_MAX_HANDLES; ++i) {
+        mig_entry_t *e = &mig_table[i];
+        if (e->ptr != NULL) continue;
+        int *p = allocate_tier(size, hint);
+        if (p == NULL) return 0;
+        e->ptr     = p;
+        e->size    = (uint32_t)size;
+        e->touches = 0;
+        /* A hot hint starts warm, so the block is not demoted right away */
+        e->heat    = (hint == ALLOCATOR_TIER_HOT) ? 1u : 0u;
+        e->pins    = 0;
+        return (mig_handle_t)(i + 1u);
+    }
+    return 0;
+}
+
+void mig_free(mig_handle_t h) {
+    if (h == 0) return;
+    mig_entry_t *e = &mig_table[h - 1u];
+    deallocate((int*)e->ptr);
+    e->ptr = NULL;
+}
+
+int mig_is_fast(mig_handle_t h) {
+    return entry_is_fast(&mig_table[h - 1u]);
+}
+
+uint32_t mig_rebalance(uint32_t max_moves) {
+    uint8_t skip[ALLOCATOR_MIGRATE_MAX_HANDLES] = { 0 };
+    uint32_t moves = 0;
+    ++stats.passes;
+
+    for (uint32_t i = 0; i < ALLOCATOR_MIGRATE_MAX_HANDLES; ++i) {
+        mig_entry_t *e = &mig_table[i];
+        if (e->ptr == NULL) continue;
+        uint32_t heat = e->heat >> 1;
+        e->heat = (e->touches > UINT32_MAX - heat) ? UINT32_MAX : heat + e->touches;
+        e->touches = 0;
+    }
+
+    /* Promote the hottest slow block; if the fast tier is full, demote
+     * colder blocks until it fits or no colder block is left. */
+    while (moves < max_moves) {
+        int32_t hot = pick(0, 1, 0, skip);
+        if (hot < 0) break;
+        skip[hot] = 1;
+        mig_entry_t *e = &mig_table[hot];
+
+        while (moves < max_moves) {
+            if (move_block(e, 1)) { ++moves; break; }
+            int32_t cold = pick(1, 0, e->heat, skip);
+            if (cold < 0 || moves + 2u > max_moves) break;
+            if (!move_block(&mig_table[cold], 0)) break;
+            skip[cold] = 1;
+            ++moves;
+        }
+    }
+    return moves;
+}
+
+void mig_get_stats(mig_stats_t *out) {
+    *out = stats;
+}
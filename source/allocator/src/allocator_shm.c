@@ -0,0 +1,295 @@
+/**
+ * @file allocator_shm.c
+ * @brief Allocation arenas in POSIX shared memory (hosted builds).
+ *
+ * Region layout, all offsets relative to the start of the region:
+ *
+ *   [ shm_header | shm_node x max_blocks | data ... ]
+ *
+ * The data area starts on a cache line. Live blocks are kept in a list sorted
+ * by offset, as in the core allocator, and placed first fit.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <fcntl.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "allocator_config.h"
+#include "allocator_shm.h"
+
+#if ATOMIC_INT_LOCK_FREE != 2
+#error "Shared arenas need lock-free (address-free) atomic ints"
+#endif
+
+/* ---------------------------------------------------------------------------- */
+/*                                 Region Layout                                */
+/* ---------------------------------------------------------------------------- */
+
+/** Identifies an initialized arena ("SHMA"). */
+#define SHM_MAGIC    0x414D4853u
+
+/** Bumped whenever the region layout changes. */
+#define SHM_VERSION  1u
+
+/** Spins on the arena lock before yielding the CPU. */
+#define SHM_SPINS    64u
+
+#define SHM_ALIGN_UP(x, a)  (((x) + ((a) - 1u)) & ~((a) - 1u))
+
+/**
+ * @struct shm_node
+ * @brief Metadata of a live block; same roles as alloc_node_t in allocator.c.
+ */
+struct shm_node {
+    uint32_t offset;  /**< Start of the block from the start of the region. */
+    uint32_t size;    /**< Block size in bytes (0 = unused slot). */
+    int32_t  next;    /**< Next block in offset order (-1 = end of list). */
+};
+
+/**
+ * @struct shm_header
+ * @brief Shared state of an arena. Fields other than the atomics are only
+ *        accessed with the lock held.
+ */
+struct shm_header {
+    _Atomic uint32_t magic;       /**< SHM_MAGIC once initialized (release). */
+    uint32_t version;             /**< SHM_VERSION. */
+    uint32_t size;                /**< Region size in bytes. */
+    uint32_t max_blocks;          /**< Number of nodes. */
+    uint32_t data_start;          /**< Offset of the data area. */
+    _Atomic uint32_t lock;        /**< Process-shared spinlock (0 = free). */
+    _Atomic uint32_t root;        /**< Root handle. */
+    int32_t  head;                /**< First block in offset order (-1 = none). */
+    shm_arena_stats_t stats;      /**< Usage counters. */
+};
+
+static struct shm_node *nodes(struct shm_header *hdr) {
+    return (struct shm_node*)(void*)((uint8_t*)hdr +
+                                     SHM_ALIGN_UP(sizeof *hdr, sizeof(uint32_t)));
+}
+
+/**
+ * @brief Offset of the data area for a given number of nodes.
+ */
+static uint64_t data_offset(uint32_t max_blocks) {
+    uint64_t meta = SHM_ALIGN_UP(sizeof(struct shm_header), sizeof(uint32_t)) +
+                    (uint64_t)max_blocks * sizeof(struct shm_node);
+    return SHM_ALIGN_UP(meta, (uint64_t)ALLOCATOR_CACHE_LINE);
+}
+
+/* ---------------------------------------------------------------------------- */
+/*                                     Lock                                     */
+/* ---------------------------------------------------------------------------- */
+
+static void arena_lock(struct shm_header *hdr) {
+    for (uint32_t spins = 0; ; ++spins) {
+        uint32_t expected = 0;
+        if (atomic_load_explicit(&hdr->lock, memory_order_relaxed) == 0 &&
+            atomic_compare_exchange_weak_explicit(&hdr->lock, &expected, 1u,
+                                                  memory_order_acquire,
+                                                  memory_order_relaxed)) {
+            return;
+        }
+        /* The holder may be another process that is not running */
+        if (spins >= SHM_SPINS) {
+            sched_yield();
+            spins = 0;
+        }
+#if defined(__x86_64__) || defined(__i386__)
+        __builtin_ia32_pause();
+#endif
+    }
+}
+
+static void arena_unlock(struct shm_header *hdr) {
+    atomic_store_explicit(&hdr->lock, 0u, memory_order_release);
+}
+
+/* ---------------------------------------------------------------------------- */
+/*                                  Block List                                  */
+/* ---------------------------------------------------------------------------- */
+
+/**
+ * @brief Records a block in a free node and links it in offset order.
+ *
+ * @param prev Node after which the block goes (-1 = at the head).
+ * @return 0 on success, -1 if every node is in use.
+ */
+static int commit_block(struct shm_header *hdr, int32_t prev, uint32_t off, uint32_t req) {
+    struct shm_node *n = nodes(hdr);
+    int32_t idx = -1;
+    for (uint32_t i = 0; i < hdr->max_blocks; ++i) {
+        if (n[i].size == 0) { idx = (int32_t)i; break; }
+    }
+    if (idx < 0) return -1;
+
+    n[idx].offset = off;
+    n[idx].size   = req;
+    if (prev == -1) {
+        n[idx].next = hdr->head;
+        hdr->head = idx;
+    } else {
+        n[idx].next = n[prev].next;
+        n[prev].next = idx;
+    }
+    return 0;
+}
+
+/**
+ * @brief Places a block in the lowest gap that fits.
+ *
+ * @return Offset of the block, or 0 if no gap (or node) is available.
+ */
+static uint32_t place_block(struct shm_header *hdr, uint32_t req) {
+    struct shm_node *n = nodes(hdr);
+    uint32_t gap_start = hdr->data_start;
+    int32_t prev = -1;
+    for (int32_t cur = hdr->head; ; prev = cur, cur = n[cur].next) {
+        uint32_t gap_end = (cur == -1) ? hdr->size : n[cur].offset;
+        if (gap_end - gap_start >= req) {
+            return commit_block(hdr, prev, gap_start, req) == 0 ? gap_start : 0;
+        }
+        if (cur == -1) return 0;
+        gap_start = n[cur].offset + n[cur].size;
+    }
+}
+
+/* ---------------------------------------------------------------------------- */
+/*                                  Public API                                  */
+/* ---------------------------------------------------------------------------- */
+
+int shm_arena_create(shm_arena_t *arena, const char *name, uint32_t size,
+                     uint32_t max_blocks) {
+    if (max_blocks == 0 || max_blocks > (uint32_t)INT32_MAX) return -1;
+    uint64_t start = data_offset(max_blocks);
+    if (start + ALLOCATOR_CACHE_LINE > size) return -1;
+
+    int fd = shm_open(name, O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (fd < 0) return -1;
+    void *base = MAP_FAILED;
+    if (ftruncate(fd, (off_t)size) == 0) {
+        base = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    close(fd);
+    if (base == MAP_FAILED) {
+        shm_unlink(name);
+        return -1;
+    }
+
+    /* The object is zero-filled by ftruncate(); set up everything but the
+     * magic, then publish it so that openers see a complete header. */
+    struct shm_header *hdr = (struct shm_header*)base;
+    hdr->version    = SHM_VERSION;
+    hdr->size       = size & ~(ALLOCATOR_CACHE_LINE - 1u);
+    hdr->max_blocks = max_blocks;
+    hdr->data_start = (uint32_t)start;
+    hdr->head       = -1;
+    atomic_init(&hdr->lock, 0u);
+    atomic_init(&hdr->root, 0u);
+    memset(&hdr->stats, 0, sizeof hdr->stats);
+    atomic_store_explicit(&hdr->magic, SHM_MAGIC, memory_order_release);
+
+    arena->hdr  = hdr;
+    arena->base = (uint8_t*)base;
+    arena->size = size;
+    return 0;
+}
+
+int shm_arena_open(shm_arena_t *arena, const char *name) {
+    int fd = shm_open(name, O_RDWR, 0);
+    if (fd < 0) return -1;
+    struct stat st;
+    void *base = MAP_FAILED;
+    if (fstat(fd, &st) == 0 && (uint64_t)st.st_size >= sizeof(struct shm_header) &&
+        (uint64_t)st.st_size <= UINT32_MAX) {
+        base = mmap(NULL, (size_t)st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    close(fd);
+    if (base == MAP_FAILED) return -1;
+
+    struct shm_header *hdr = (struct shm_header*)base;
+    if (atomic_load_explicit(&hdr->magic, memory_order_acquire) != SHM_MAGIC ||
+        hdr->version != SHM_VERSION || hdr->size > (uint64_t)st.st_size ||
+        hdr->max_blocks == 0 || hdr->max_blocks > (uint32_t)INT32_MAX ||
+        hdr->data_start != data_offset(hdr->max_blocks) ||
+        (uint64_t)hdr->data_start + ALLOCATOR_CACHE_LINE > hdr->size) {
+        munmap(base, (size_t)st.st_size);
+        return -1;
+    }
+
+    arena->hdr  = hdr;
+    arena->base = (uint8_t*)base;
+    arena->size = (size_t)st.st_size;
+    return 0;
+}
+
+void shm_arena_close(shm_arena_t *arena) {
+    if (arena->base != NULL) munmap(arena->base, arena->size);
+    arena->hdr  = NULL;
+    arena->base = NULL;
+    arena->size = 0;
+}
+
+int shm_arena_unlink(const char *name) {
+    return shm_unlink(name);
+}
+
+shm_handle_t shm_alloc(shm_arena_t *arena, uint32_t size) {
+    struct shm_header *hdr = arena->hdr;
+    if (size == 0 || size > hdr->size) return 0;
+    uint32_t req = SHM_ALIGN_UP(size, ALLOCATOR_CACHE_LINE);
+
+    arena_lock(hdr);
+    uint32_t off = place_block(hdr, req);
+    if (off != 0) {
+        hdr->stats.bytes_in_use += req;
+        ++hdr->stats.blocks;
+        ++hdr->stats.allocs;
+    } else {
+        ++hdr->stats.failures;
+    }
+    arena_unlock(hdr);
+    return off != 0 ? off + 1u : 0;
+}
+
+void shm_free(shm_arena_t *arena, shm_handle_t handle) {
+    if (handle == 0) return;
+    struct shm_header *hdr = arena->hdr;
+    struct shm_node *n = nodes(hdr);
+    uint32_t off = handle - 1u;
+
+    arena_lock(hdr);
+    for (int32_t prev = -1, cur = hdr->head; cur != -1; prev = cur, cur = n[cur].next) {
+        if (n[cur].offset > off) break;             /* list is sorted */
+        if (n[cur].offset != off) continue;
+        if (prev == -1) hdr->head = n[cur].next;
+        else n[prev].next = n[cur].next;
+        hdr->stats.bytes_in_use -= n[cur].size;
+        --hdr->stats.blocks;
+        ++hdr->stats.frees;
+        n[cur].size   = 0;
+        n[cur].offset = 0;
+        n[cur].next   = -1;
+        break;
+    }
+    arena_unlock(hdr);
+}
+
+void shm_set_root(shm_arena_t *arena, shm_handle_t root) {
+    atomic_store_explicit(&arena->hdr->root, root, memory_order_release);
+}
+
+shm_handle_t shm_get_root(const shm_arena_t *arena) {
+    return atomic_load_explicit(&arena->hdr->root, memory_order_acquire);
+}
+
+void shm_arena_get_stats(shm_arena_t *arena, shm_arena_stats_t *stats) {
+    arena_lock(arena->hdr);
+    *stats = arena->hdr->stats;
+    arena_unlock(arena->hdr);
+}
@@ -0,0 +1,31 @@
+/**
+ * @file allocator_snapshot_file.c
+ * @brief Snapshot images stored in files (hosted builds).
+ */
+
+#include <stdio.h>
+#include "allocator_snapshot.h"
+
+static int file_write(void *ctx, const void *data, size_t len) {
+    return fwrite(data, 1, len, (FILE*)ctx) == len ? 0 : -1;
+}
+
+static int file_read(void *ctx, void *data, size_t len) {
+    return fread(data, 1, len, (FILE*)ctx) == len ? 0 : -1;
+}
+
+int allocator_snapshot_save_file(const char *path) {
+    FILE *f = fopen(path, "wb");
+    if (!f) return -1;
+    int rc = allocator_snapshot_write(file_write, f);
+    if (fclose(f) != 0) rc = -1;
+    return rc;
+}
+
+int allocator_snapshot_load_file(const char *path) {
+    FILE *f = fopen(path, "rb");
+    if (!f) return -1;
+    int rc = allocator_snapshot_read(file_read, f);
+    fclose(f);
+    return rc;
+}
@@ -0,0 +1,145 @@
+/**
+ * @file allocator_tcache.c
+ * @brief Per-thread caches and their remote-free queues.
+ *
+ * Remote frees are pushed onto a Treiber stack per owner. The owner only ever
+ * takes the whole stack with one exchange, so the push side needs no ABA
+ * protection.
+ */
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include "allocator_tcache.h"
+
+/* ---------------------------------------------------------------------------- */
+/*                                 Internal State                               */
+/* ---------------------------------------------------------------------------- */
+
+/**
+ * @brief Registry entry of one owner tag, on its own cache line.
+ *
+ * The queue outlives the cache that used it: a thread that read the owner tag
+ * just before tcache_destroy() cleared it may still push a block, which is
+ * handed to the shared lists when the slot is reused.
+ */
+typedef struct {
+    _Atomic(allocator_free_block_t *) remote;
+    atomic_bool in_use;
+    uint8_t _pad[64 - sizeof(void*) - sizeof(atomic_bool)];
+} tcache_slot_t;
+
+/** Registry, indexed by owner tag - 1. */
+static tcache_slot_t slots[ALLOCATOR_TCACHE_MAX];
+
+/* ---------------------------------------------------------------------------- */
+/*                              Public API Implementation                       */
+/* ---------------------------------------------------------------------------- */
+
+int tcache_init(allocator_tcache_t *tc) {
+    if (!tc) return -1;
+    for (uint32_t cls = 0; cls < ALLOCATOR_NUM_CLASSES; ++cls) tc->free[cls] = NULL;
+    tc->owner = 0;
+    tc->remote_sent = 0;
+    tc->remote_received = 0;
+    tc->collects = 0;
+
+    for (uint32_t i = 0; i < ALLOCATOR_TCACHE_MAX; ++i) {
+        bool expected = false;
+        if (atomic_compare_exchange_strong(&slots[i].in_use, &expected, true)) {
+            tc->owner = i + 1u;
+            /* Leftovers of the previous user go to the shared lists */
+            (void)tcache_collect(tc);
+            tc->remote_received = 0;
+            tc->collects = 0;
+            return 0;
+        }
+    }
+    return -1;
+}
+
+void tcache_destroy(allocator_tcache_t *tc) {
+    if (!tc || tc->owner == 0) return;
+
+    /* Hand the slabs over first; frees from now on bypass the remote queue.
+     * A slab may have been trimmed and re-carved for another owner, hence
+     * the compare-exchange. */
+    for (uint32_t i = 0; i < ALLOCATOR_SLAB_COUNT; ++i) {
+        uint8_t expected = (uint8_t)tc->owner;
+        atomic_compare_exchange_strong_explicit(&allocator_slab_owner[i], &expected, 0,
+                                                memory_order_relaxed, memory_order_relaxed);
+    }
+    (void)tcache_collect(tc);
+
+    for (uint32_t cls = 0; cls < ALLOCATOR_NUM_CLASSES; ++cls) {
+        allocator_free_block_t *b = tc->free[cls];
+        while (b) {
+            allocator_free_block_t *next = b->next;
+            deallocate_fast((int*)(void*)b);
+            b = next;
+        }
+        tc->free[cls] = NULL;
+    }
+
+    atomic_store_explicit(&slots[tc->owner - 1u].in_use, false, memory_order_release);
+    tc->owner = 0;
+}
+
+uint32_t tcache_collect(allocator_tcache_t *tc) {
+    allocator_free_block_t *b =
+        atomic_exchange_explicit(&slots[tc->owner - 1u].remote, NULL, memory_order_acquire);
+    if (b == NULL) return 0;
+
+    uint32_t n = 0;
+    while (b) {
+        allocator_free_block_t *next = b->next;
+        uint32_t frame = (uint32_t)(((uint8_t*)b - allocator_pool_base) >> ALLOCATOR_SLAB_SHIFT);
+        if (atomic_load_explicit(&allocator_slab_owner[frame], memory_order_relaxed) == tc->owner) {
+            uint32_t cls = allocator_slab_class[frame] - 1u;
+            b->next = tc->free[cls];
+            tc->free[cls] = b;
+        } else {
+            deallocate_fast((int*)(void*)b);
+        }
+        b = next;
+        ++n;
+    }
+    tc->remote_received += n;
+    ++tc->collects;
+    return n;
+}
+
+int *tcache_refill(allocator_tcache_t *tc, uint32_t cls) {
+    allocator_free_block_t *b;
+
+    /* Batch-collect blocks other threads freed back to us */
+    if (tcache_collect(tc) != 0 && (b = tc->free[cls]) != NULL) {
+        tc->free[cls] = b->next;
+        return (int*)(void*)b;
+    }
+
+    allocator_free_block_t *last;
+    b = allocator_slab_carve(cls, tc->owner, &last);
+    if (b == NULL) {
+        /* No room for a slab of our own; use the shared lists */
+        return allocator_class_refill(cls);
+    }
+    tc->free[cls] = b->next;
+    return (int*)(void*)b;
+}
+
+void tcache_free_foreign(allocator_tcache_t *tc, int *ptr, uint32_t owner) {
+    if (owner == 0 || owner > ALLOCATOR_TCACHE_MAX) {
+        deallocate_fast(ptr);
+        return;
+    }
+
+    allocator_free_block_t *b = (allocator_free_block_t*)(void*)ptr;
+    _Atomic(allocator_free_block_t *) *head = &slots[owner - 1u].remote;
+    allocator_free_block_t *old = atomic_load_explicit(head, memory_order_relaxed);
+    do {
+        b->next = old;
+    } while (!atomic_compare_exchange_weak_explicit(head, &old, b,
+                                                    memory_order_release,
+                                                    memory_order_relaxed));
+    ++tc->remote_sent;
+}
@@ -0,0 +1,147 @@
+/**
+ * @file bench_allocator.c
+ * @brief Micro-benchmarks for the allocate()/deallocate() API.
+ *
+ * Each workload reports the average cost of one allocator call in timer
+ * ticks (see bench_timer.h). The pseudo-random workloads use a fixed seed so
+ * that every build executes exactly the same sequence of requests.
+ *
+ * Usage: bench_allocator [scale]   (scale multiplies the iteration counts)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include "allocator.h"
+#include "bench_timer.h"
+
+/** Number of simultaneously live blocks in the mixed workloads. */
+#define LIVE_SLOTS  64
+
+/** Sink that keeps the compiler from discarding writes to allocated memory. */
+static volatile uint32_t bench_sink;
+
+/** xorshift32 state; reseeded at the start of every workload. */
+static uint32_t rng_state;
+
+static uint32_t rng_next(void) {
+    uint32_t x = rng_state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return rng_state = x;
+}
+
+/** Returns a request size in [lo, hi]. */
+static int rng_size(int lo, int hi) {
+    return lo + (int)(rng_next() % (uint32_t)(hi - lo + 1));
+}
+
+/** Prints one result line: name, allocator calls and ticks per call. */
+static void report(const char *name, uint32_t ops, uint64_t ticks) {
+    printf("%-16s %10lu ops %10.1f %s/op\n", name, (unsigned long)ops,
+           ops ? (double)ticks / (double)ops : 0.0, BENCH_TICK_UNIT);
+}
+
+/** Allocates and immediately frees one 64-byte block. */
+static void bench_fixed(uint32_t iters) {
+    uint64_t t0 = bench_now();
+    for (uint32_t i = 0; i < iters; ++i) {
+        int *p = allocate(64);
+        if (p) {
+            p[0] = (int)i;
+            bench_sink += (uint32_t)p[0];
+        }
+        deallocate(p);
+    }
+    report("fixed_64", iters * 2u, bench_now() - t0);
+}
+
+/** Same as bench_fixed() through the inline size-class fast path. */
+static void bench_fast_fixed(uint32_t iters) {
+    uint64_t t0 = bench_now();
+    for (uint32_t i = 0; i < iters; ++i) {
+        int *p = allocate_fast(64);
+        if (p) {
+            p[0] = (int)i;
+            bench_sink += (uint32_t)p[0];
+        }
+        deallocate_fast(p);
+    }
+    report("fast_fixed_64", iters * 2u, bench_now() - t0);
+}
+
+/** Fills LIVE_SLOTS blocks of random size, then frees them in reverse order. */
+static void bench_lifo(uint32_t rounds) {
+    int *slots[LIVE_SLOTS];
+    rng_state = 0x12345678u;
+    uint64_t t0 = bench_now();
+    for (uint32_t r = 0; r < rounds; ++r) {
+        for (int i = 0; i < LIVE_SLOTS; ++i) slots[i] = allocate(rng_size(8, 512));
+        for (int i = LIVE_SLOTS - 1; i >= 0; --i) deallocate(slots[i]);
+    }
+    report("lifo_mixed", rounds * LIVE_SLOTS * 2u, bench_now() - t0);
+}
+
+/** Replaces a random live block with a new random-size block on every step. */
+static void bench_random(uint32_t iters) {
+    int *slots[LIVE_SLOTS] = { 0 };
+    uint32_t failed = 0;
+    rng_state = 0x9E3779B9u;
+    uint64_t t0 = bench_now();
+    for (uint32_t i = 0; i < iters; ++i) {
+        uint32_t s = rng_next() % LIVE_SLOTS;
+        deallocate(slots[s]);
+        slots[s] = allocate(rng_size(8, 1024));
+        if (!slots[s]) ++failed;
+    }
+    uint64_t t1 = bench_now();
+    for (int i = 0; i < LIVE_SLOTS; ++i) deallocate(slots[i]);
+    report("random_mixed", iters * 2u, t1 - t0);
+    if (failed) printf("%-16s %10lu failed allocations\n", "", (unsigned long)failed);
+}
+
+/** Same as bench_random() with small sizes through the fast path. */
+static void bench_fast_random(uint32_t iters) {
+    int *slots[LIVE_SLOTS] = { 0 };
+    rng_state = 0x9E3779B9u;
+    uint64_t t0 = bench_now();
+    for (uint32_t i = 0; i < iters; ++i) {
+        uint32_t s = rng_next() % LIVE_SLOTS;
+        deallocate_fast(slots[s]);
+        slots[s] = allocate_fast(rng_size(8, (int)ALLOCATOR_SMALL_MAX));
+    }
+    uint64_t t1 = bench_now();
+    for (int i = 0; i < LIVE_SLOTS; ++i) deallocate_fast(slots[i]);
+    allocator_trim();
+    report("fast_random", iters * 2u, t1 - t0);
+}
+
+/** Allocates 256-byte blocks until the pool is exhausted, then frees them FIFO. */
+static void bench_fill_drain(uint32_t rounds) {
+    static int *blocks[1024];
+    uint32_t ops = 0;
+    uint64_t t0 = bench_now();
+    for (uint32_t r = 0; r < rounds; ++r) {
+        int n = 0;
+        while (n < 1024 && (blocks[n] = allocate(256)) != NULL) ++n;
+        for (int i = 0; i < n; ++i) deallocate(blocks[i]);
+        ops += (uint32_t)n * 2u + 1u;
+    }
+    report("fill_drain_256", ops, bench_now() - t0);
+}
+
+int main(int argc, char **argv) {
+    uint32_t scale = (argc > 1) ? (uint32_t)strtoul(argv[1], NULL, 10) : 1u;
+    if (scale == 0) scale = 1;
+    bench_timer_init();
+
+    printf("=== Allocator Benchmark (scale %lu) ===\n", (unsigned long)scale);
+    bench_fixed(200000u * scale);
+    bench_fast_fixed(200000u * scale);
+    bench_lifo(2000u * scale);
+    bench_random(200000u * scale);
+    bench_fast_random(200000u * scale);
+    bench_fill_drain(2000u * scale);
+    return 0;
+}
@@ -0,0 +1,117 @@
+/**
+ * @file bench_false_sharing.c
+ * @brief False-sharing benchmark: per-thread counters placed by the allocator.
+ *
+ * Each thread repeatedly increments a counter in its own small block. The
+ * blocks come from:
+ *
+ * - packed:    allocate(), so consecutive blocks share cache lines.
+ * - cacheline: allocate_flags(ALLOCATOR_F_CACHELINE), one line per block.
+ * - tcache:    each thread's own cache, i.e. a slab per thread.
+ *
+ * On a multi-core machine the packed layout bounces lines between cores; on
+ * a single core all three run at the same speed.
+ *
+ * Usage: bench_false_sharing [threads] [iterations per thread]
+ */
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include "allocator.h"
+#include "allocator_lock.h"
+#include "allocator_tcache.h"
+#include "bench_timer.h"
+
+#define MAX_THREADS  16
+#define COUNTER_BYTES 16
+
+static uint32_t iterations = 20000000u;
+
+enum { LAYOUT_PACKED, LAYOUT_CACHELINE, LAYOUT_TCACHE };
+
+typedef struct {
+    int layout;
+    volatile uint32_t *counter;
+    pthread_barrier_t *start;
+} worker_arg_t;
+
+static void *worker(void *p) {
+    worker_arg_t *arg = p;
+    allocator_tcache_t tc;
+    int *block = NULL;
+
+    if (arg->layout == LAYOUT_TCACHE) {
+        tcache_init(&tc);
+        block = tcache_alloc(&tc, COUNTER_BYTES);
+        arg->counter = (volatile uint32_t*)block;
+    }
+    pthread_barrier_wait(arg->start);
+
+    volatile uint32_t *c = arg->counter;
+    *c = 0;
+    for (uint32_t i = 0; i < iterations; ++i) *c += 1u;
+
+    if (arg->layout == LAYOUT_TCACHE) {
+        tcache_free(&tc, block);
+        tcache_destroy(&tc);
+    }
+    return NULL;
+}
+
+static void run(const char *name, int layout, int threads) {
+    pthread_t tid[MAX_THREADS];
+    worker_arg_t args[MAX_THREADS];
+    pthread_barrier_t start;
+    pthread_barrier_init(&start, NULL, (unsigned)threads);
+
+    for (int i = 0; i < threads; ++i) {
+        args[i].layout = layout;
+        args[i].start = &start;
+        args[i].counter = NULL;
+        if (layout == LAYOUT_PACKED) {
+            args[i].counter = (volatile uint32_t*)allocate(COUNTER_BYTES);
+        } else if (layout == LAYOUT_CACHELINE) {
+            args[i].counter = (volatile uint32_t*)allocate_flags(COUNTER_BYTES, ALLOCATOR_F_CACHELINE);
+        }
+    }
+
+    uint64_t t0 = bench_now();
+    for (int i = 0; i < threads; ++i) pthread_create(&tid[i], NULL, worker, &args[i]);
+    for (int i = 0; i < threads; ++i) pthread_join(tid[i], NULL);
+    uint64_t ticks = bench_now() - t0;
+
+    /* Threads sharing a line: how many other counters live in the first one's */
+    uintptr_t line0 = (uintptr_t)args[0].counter / ALLOCATOR_CACHE_LINE;
+    int sharing = 0;
+    for (int i = 1; i < threads; ++i) {
+        if ((uintptr_t)args[i].counter / ALLOCATOR_CACHE_LINE == line0) ++sharing;
+    }
+
+    printf("%-10s %2d threads %8.2f %s/increment  (%d counters share thread 0's line)\n",
+           name, threads, (double)ticks / ((double)iterations * threads), BENCH_TICK_UNIT,
+           sharing);
+
+    if (layout != LAYOUT_TCACHE) {
+        for (int i = 0; i < threads; ++i) deallocate((int*)(uintptr_t)args[i].counter);
+    }
+    pthread_barrier_destroy(&start);
+    allocator_trim();
+}
+
+int main(int argc, char **argv) {
+    int threads = (argc > 1) ? atoi(argv[1]) : 4;
+    if (threads < 1) threads = 1;
+    if (threads > MAX_THREADS) threads = MAX_THREADS;
+    if (argc > 2) iterations = (uint32_t)strtoul(argv[2], NULL, 10);
+
+    bench_timer_init();
+    allocator_set_lock_ops(allocator_lock_ops_pthread());  /* tcache slabs are carved concurrently */
+    printf("=== False Sharing Benchmark (cache line %u bytes) ===\n",
+           (unsigned)ALLOCATOR_CACHE_LINE);
+    run("packed", LAYOUT_PACKED, threads);
+    run("cacheline", LAYOUT_CACHELINE, threads);
+    run("tcache", LAYOUT_TCACHE, threads);
+    return 0;
+}
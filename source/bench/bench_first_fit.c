@@ -0,0 +1,83 @@
+/**
+ * @file bench_first_fit.c
+ * @brief Cost of first fit on a long, fragmented block list.
+ *
+ * SLOTS small blocks (16..256 bytes) stay live; every step frees a random
+ * one and allocates a new block, one in eight of them 256..1280 bytes. The
+ * list stays close to SLOTS blocks long with holes of every size, so the
+ * lowest fit is rarely near the head. In the second workload every step
+ * also allocates and frees a buffer of 2..3.5 KB, which skips every hole and
+ * lands in the space above the last block, or fails.
+ *
+ * Built once per backend (bench_first_fit, bench_first_fit_segtree); both
+ * place every block at the same address, so the failure counts and largest
+ * free extents match and only the time differs.
+ *
+ * Usage: bench_first_fit [steps]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include "allocator.h"
+#include "bench_timer.h"
+
+#define SLOTS      320u
+
+static int *live[SLOTS];
+static uint32_t rng;
+
+static uint32_t next_rand(void) {
+    rng ^= rng << 13;
+    rng ^= rng >> 17;
+    rng ^= rng << 5;
+    return rng;
+}
+
+static uint32_t between(uint32_t lo, uint32_t hi) {
+    return lo + next_rand() % (hi - lo + 1u);
+}
+
+static void run(const char *name, int buffers, uint32_t steps) {
+    rng = 0x9E3779B9u;
+    for (uint32_t i = 0; i < SLOTS; ++i) live[i] = allocate((int)between(16u, 256u));
+
+    uint32_t failed = 0, calls = 0;
+    uint64_t t0 = bench_now();
+    for (uint32_t now = 0; now < steps; ++now) {
+        uint32_t s = next_rand() % SLOTS;
+        deallocate(live[s]);
+        uint32_t size = (next_rand() % 8u == 0) ? between(256u, 1280u) : between(16u, 256u);
+        live[s] = allocate((int)size);
+        failed += (live[s] == NULL);
+        calls += 2u;
+        if (buffers) {
+            /* Below ALLOCATOR_LARGE_MIN, so it still goes to the block list */
+            int *p = allocate((int)between(2048u, 3584u));
+            deallocate(p);
+            failed += (p == NULL);
+            calls += 2u;
+        }
+    }
+    uint64_t ticks = bench_now() - t0;
+    uint32_t largest = allocator_largest_free(ALLOCATOR_HEAP_POOL);
+
+    for (uint32_t i = 0; i < SLOTS; ++i) {
+        deallocate(live[i]);
+        live[i] = NULL;
+    }
+    printf("%-14s %8.1f %s/call   failed %6u   largest free %5u bytes\n", name,
+           (double)ticks / calls, BENCH_TICK_UNIT, (unsigned)failed, (unsigned)largest);
+}
+
+int main(int argc, char **argv) {
+    uint32_t steps = (argc > 1) ? (uint32_t)strtoul(argv[1], NULL, 10) : 200000u;
+    if (steps == 0) steps = 1;
+    bench_timer_init();
+
+    printf("=== First fit, %u live blocks (%s) ===\n", (unsigned)SLOTS,
+           ALLOCATOR_BACKEND_SEGTREE ? "segment tree" : "list walk");
+    run("fragmented", 0, steps);
+    run("with buffers", 1, steps);
+    return 0;
+}
@@ -0,0 +1,190 @@
+/**
+ * @file bench_lifetime.c
+ * @brief Replays an allocation trace with and without lifetime hints.
+ *
+ * The trace mixes three kinds of objects, as in a network stack:
+ * configuration records (32..512 bytes) that are created now and then and
+ * never freed, sessions (128..1024 bytes) that live for a few thousand
+ * steps, and packet buffers (64..1536 bytes) that are freed within a few
+ * dozen. It is generated once and replayed twice: with allocate(), where
+ * every block shares one first-fit list, and with allocate_hint(). Built
+ * with ALLOCATOR_SITE_LIFETIMES=1 (bench_lifetime_sites), it is instead
+ * replayed with allocate() called from one function per kind of object,
+ * without hints, for the allocator to learn the lifetimes of the call sites.
+ *
+ * For each run the report gives the failure rate of each kind and the mean
+ * largest free extent and fragmentation (1 - largest / free), sampled after
+ * every step.
+ *
+ * Usage: bench_lifetime [steps]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include "allocator.h"
+
+#define SLOTS       448u
+#define MAX_STEPS   200000u
+#define LONG_RATE   5u     /**< Configuration records per 10 000 requests. */
+#define MEDIUM_RATE 300u   /**< Sessions per 10 000 requests. */
+
+/** One allocation of the trace, held in @c slot until step @c death. */
+typedef struct {
+    uint32_t birth;
+    uint32_t death;
+    uint16_t size;
+    uint16_t slot;
+    uint8_t  lifetime;
+} event_t;
+
+static event_t trace[MAX_STEPS];
+static uint32_t trace_len;
+static int *live[SLOTS];
+static uint32_t live_death[SLOTS];
+static uint32_t rng = 0x2545F491u;
+
+static uint32_t next_rand(void) {
+    rng ^= rng << 13;
+    rng ^= rng >> 17;
+    rng ^= rng << 5;
+    return rng;
+}
+
+static uint32_t between(uint32_t lo, uint32_t hi) {
+    return lo + next_rand() % (hi - lo + 1u);
+}
+
+#if ALLOCATOR_SITE_LIFETIMES
+/* One call site of allocate() per kind of object, as in unannotated code.
+ * The counters keep the calls from being tail calls or merged. */
+static volatile uint32_t packets, sessions, configs;
+
+ALLOCATOR_SLOW_PATH static int *new_packet(int size) {
+    int *p = allocate(size);
+    ++packets;
+    return p;
+}
+
+ALLOCATOR_SLOW_PATH static int *new_session(int size) {
+    int *p = allocate(size);
+    ++sessions;
+    return p;
+}
+
+ALLOCATOR_SLOW_PATH static int *new_config(int size) {
+    int *p = allocate(size);
+    ++configs;
+    return p;
+}
+
+static int *allocate_by_site(int size, uint32_t lifetime) {
+    if (lifetime == ALLOCATOR_LIFE_SHORT) return new_packet(size);
+    if (lifetime == ALLOCATOR_LIFE_MEDIUM) return new_session(size);
+    return new_config(size);
+}
+#endif
+
+enum { PLAIN, HINTED, SITES };
+
+/**
+ * @brief Records one allocation per step, keeping at most SLOTS objects
+ *        alive at a time.
+ */
+static void make_trace(uint32_t steps) {
+    static uint32_t deaths[SLOTS];
+    for (uint32_t now = 0; now < steps; ++now) {
+        uint32_t slot = SLOTS;
+        for (uint32_t i = 0; i < SLOTS; ++i) {
+            if (deaths[i] <= now) {
+                slot = i;
+                break;
+            }
+        }
+        if (slot == SLOTS) continue;
+
+        event_t *e = &trace[trace_len++];
+        e->birth = now;
+        e->slot = (uint16_t)slot;
+        uint32_t kind = next_rand() % 10000u;
+        if (kind < LONG_RATE) {
+            e->lifetime = ALLOCATOR_LIFE_LONG;
+            e->size = (uint16_t)between(32u, 512u);
+            e->death = UINT32_MAX;
+        } else if (kind < LONG_RATE + MEDIUM_RATE) {
+            e->lifetime = ALLOCATOR_LIFE_MEDIUM;
+            e->size = (uint16_t)between(128u, 1024u);
+            e->death = now + between(500u, 3000u);
+        } else {
+            e->lifetime = ALLOCATOR_LIFE_SHORT;
+            e->size = (uint16_t)between(64u, 1536u);
+            e->death = now + between(1u, 60u);
+        }
+        deaths[slot] = e->death;
+    }
+}
+
+static void replay(const char *name, int mode, uint32_t steps) {
+    uint32_t requests[ALLOCATOR_LIFE_CLASSES] = { 0 };
+    uint32_t failed[ALLOCATOR_LIFE_CLASSES] = { 0 };
+    double largest_sum = 0, frag_sum = 0;
+    uint32_t next = 0;
+
+    for (uint32_t now = 0; now < steps; ++now) {
+        for (uint32_t i = 0; i < SLOTS; ++i) {
+            if (live[i] != NULL && live_death[i] <= now) {
+                deallocate(live[i]);
+                live[i] = NULL;
+            }
+        }
+        for (; next < trace_len && trace[next].birth == now; ++next) {
+            const event_t *e = &trace[next];
+            int *p;
+            if (mode == HINTED) {
+                p = allocate_hint(e->size, e->lifetime);
+#if ALLOCATOR_SITE_LIFETIMES
+            } else if (mode == SITES) {
+                p = allocate_by_site(e->size, e->lifetime);
+#endif
+            } else {
+                p = allocate(e->size);
+            }
+            live[e->slot] = p;
+            live_death[e->slot] = e->death;
+            ++requests[e->lifetime];
+            failed[e->lifetime] += (live[e->slot] == NULL);
+        }
+
+        uint32_t largest = allocator_largest_free(ALLOCATOR_HEAP_POOL);
+        uint32_t free_bytes = allocator_free_bytes(ALLOCATOR_HEAP_POOL);
+        largest_sum += largest;
+        if (free_bytes != 0) frag_sum += 1.0 - (double)largest / free_bytes;
+    }
+    for (uint32_t i = 0; i < SLOTS; ++i) {
+        deallocate(live[i]);
+        live[i] = NULL;
+    }
+
+    printf("%-10s largest free %6.0f bytes  fragmentation %4.1f%%  failed:", name,
+           largest_sum / steps, 100.0 * frag_sum / steps);
+    static const char *const kinds[] = { "short", "medium", "long" };
+    for (uint32_t k = 0; k < ALLOCATOR_LIFE_CLASSES; ++k) {
+        printf("  %s %.2f%%", kinds[k], requests[k] ? 100.0 * failed[k] / requests[k] : 0.0);
+    }
+    printf("\n");
+}
+
+int main(int argc, char **argv) {
+    uint32_t steps = (argc > 1) ? (uint32_t)strtoul(argv[1], NULL, 10) : 200000u;
+    if (steps == 0) steps = 1;
+    if (steps > MAX_STEPS) steps = MAX_STEPS;
+
+    make_trace(steps);
+#if ALLOCATOR_SITE_LIFETIMES
+    replay("call sites", SITES, steps);
+#else
+    replay("first fit", PLAIN, steps);
+    replay("hinted", HINTED, steps);
+#endif
+    return 0;
+}
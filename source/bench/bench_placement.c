@@ -0,0 +1,107 @@
+/**
+ * @file bench_placement.c
+ * @brief Fragmentation under a randomized workload: first fit versus
+ *        bidirectional placement.
+ *
+ * Small blocks (16..256 bytes) arrive in bursts: during the first half of
+ * every period they live until the period's midpoint, so they pile up and
+ * then drain; otherwise they are short-lived. Larger blocks (512..3072 bytes,
+ * below ALLOCATOR_LARGE_MIN so that both share the block list) arrive at a
+ * steady rate and live long. Under first fit a large block that arrives
+ * during a burst lands above the piled-up small ones and is left in the middle
+ * of the pool when they drain.
+ *
+ * The same request sequence runs with first fit for every block and with
+ * the larger blocks placed from the high end (allocator_set_placement()).
+ * After every step the largest free extent is sampled; the report gives its
+ * mean and minimum and the requests that failed.
+ *
+ * Usage: bench_placement [steps]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include "allocator.h"
+
+#define SLOTS       512u
+#define SPLIT       512u   /**< Smallest "large" block. */
+#define LARGE_PCT   3u     /**< Share of large requests, in percent. */
+#define PERIOD      400u   /**< Steps per burst of small blocks. */
+
+typedef struct {
+    int     *ptr;
+    uint32_t death;
+} live_t;
+
+static live_t live[SLOTS];
+static uint32_t rng;
+
+static uint32_t next_rand(void) {
+    rng ^= rng << 13;
+    rng ^= rng >> 17;
+    rng ^= rng << 5;
+    return rng;
+}
+
+static uint32_t between(uint32_t lo, uint32_t hi) {
+    return lo + next_rand() % (hi - lo + 1u);
+}
+
+static void run(const char *name, uint32_t split, uint32_t steps) {
+    allocator_set_placement(ALLOCATOR_HEAP_POOL, split);
+    rng = 0x9E3779B9u;
+
+    uint64_t sum = 0;
+    uint32_t min = UINT32_MAX, failed = 0;
+    for (uint32_t now = 0; now < steps; ++now) {
+        for (uint32_t i = 0; i < SLOTS; ++i) {
+            if (live[i].ptr != NULL && live[i].death <= now) {
+                deallocate(live[i].ptr);
+                live[i].ptr = NULL;
+            }
+        }
+
+        uint32_t phase = now % PERIOD;
+        int large = (next_rand() % 100u) < LARGE_PCT;
+        uint32_t size, life;
+        if (large) {
+            size = between(SPLIT, 3072u);
+            life = between(200u, 800u);
+        } else {
+            size = between(16u, 256u);
+            life = between(1u, 20u);
+            if (phase < PERIOD / 2u) life += PERIOD / 2u - phase;
+        }
+
+        for (uint32_t i = 0; i < SLOTS; ++i) {
+            if (live[i].ptr != NULL) continue;
+            live[i].ptr = allocate((int)size);
+            live[i].death = now + life;
+            failed += (live[i].ptr == NULL);
+            break;
+        }
+
+        uint32_t largest = allocator_largest_free(ALLOCATOR_HEAP_POOL);
+        sum += largest;
+        if (largest < min) min = largest;
+    }
+
+    for (uint32_t i = 0; i < SLOTS; ++i) {
+        deallocate(live[i].ptr);
+        live[i].ptr = NULL;
+    }
+
+    printf("%-14s largest free: mean %7.0f  min %6u bytes   failed %u of %u\n",
+           name, (double)sum / steps, (unsigned)min, (unsigned)failed, (unsigned)steps);
+}
+
+int main(int argc, char **argv) {
+    uint32_t steps = (argc > 1) ? (uint32_t)strtoul(argv[1], NULL, 10) : 200000u;
+    if (steps == 0) steps = 1;
+
+    run("first fit", 0, steps);
+    run("bidirectional", SPLIT, steps);
+    allocator_set_placement(ALLOCATOR_HEAP_POOL, 0);
+    return 0;
+}
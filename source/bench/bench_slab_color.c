@@ -0,0 +1,68 @@
+/**
+ * @file bench_slab_color.c
+ * @brief Conflict-miss microbenchmark for slab coloring.
+ *
+ * Fills the pool with slabs of one size class and repeatedly reads the first
+ * block of every slab. Without coloring those blocks sit at the same offset in
+ * slab-aligned memory, i.e. one slab size apart, and map onto a handful of
+ * cache sets; with coloring their offsets rotate through the slab's spare
+ * room and spread over more sets.
+ *
+ * Built twice: bench_slab_color_off (ALLOCATOR_SLAB_COLOR_STEP=0) and
+ * bench_slab_color_on. Usage: bench_slab_color [passes]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include "allocator.h"
+#include "bench_timer.h"
+
+#define BLOCK      256
+#define MAX_SLABS  ALLOCATOR_SLAB_COUNT
+
+static volatile uint32_t bench_sink;
+
+int main(int argc, char **argv) {
+    uint32_t passes = (argc > 1) ? (uint32_t)strtoul(argv[1], NULL, 10) : 200000u;
+    static int *all[MAX_SLABS * (ALLOCATOR_SLAB_BYTES / BLOCK)];
+    static volatile uint32_t *hot[MAX_SLABS];
+    uint32_t n = 0, slabs = 0;
+
+    bench_timer_init();
+
+    /* One hot object per slab: the first block handed out from it */
+    while ((all[n] = allocate_fast(BLOCK)) != NULL) {
+        if (n == 0 || ((uintptr_t)all[n] ^ (uintptr_t)all[n - 1]) >= ALLOCATOR_SLAB_BYTES) {
+            hot[slabs++] = (volatile uint32_t*)all[n];
+        }
+        ++n;
+    }
+
+    /* Distinct cache-line offsets within a 4 KB window */
+    uint32_t offsets = 0;
+    uint8_t seen[4096 / ALLOCATOR_CACHE_LINE] = { 0 };
+    for (uint32_t i = 0; i < slabs; ++i) {
+        uint32_t line = (uint32_t)(((uintptr_t)hot[i] & 4095u) / ALLOCATOR_CACHE_LINE);
+        if (!seen[line]) {
+            seen[line] = 1;
+            ++offsets;
+        }
+    }
+
+    uint64_t t0 = bench_now();
+    uint32_t sum = 0;
+    for (uint32_t p = 0; p < passes; ++p) {
+        for (uint32_t i = 0; i < slabs; ++i) sum += *hot[i];
+    }
+    uint64_t ticks = bench_now() - t0;
+    bench_sink = sum;
+
+    printf("coloring %-3s  step %3u  %4u slabs  %2u line offsets/4KB  %6.2f %s/access\n",
+           ALLOCATOR_SLAB_COLOR_STEP ? "on" : "off", (unsigned)ALLOCATOR_SLAB_COLOR_STEP,
+           (unsigned)slabs, (unsigned)offsets,
+           (double)ticks / ((double)passes * slabs), BENCH_TICK_UNIT);
+
+    for (uint32_t i = 0; i < n; ++i) deallocate_fast(all[i]);
+    return 0;
+}
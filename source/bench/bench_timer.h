@@ -0,0 +1,61 @@
+#ifndef BENCH_TIMER_H
+#define BENCH_TIMER_H
+
+/**
+ * @file bench_timer.h
+ * @brief Timestamp source used by the allocator benchmarks.
+ *
+ * bench_now() returns a monotonically increasing tick count; BENCH_TICK_UNIT
+ * names the unit so that results from different targets are not confused.
+ * Hosted builds measure wall-clock nanoseconds, bare-metal builds read the
+ * port's cycle counter (DWT/SysTick on Cortex-M, mcycle on RISC-V).
+ */
+
+#include <stdint.h>
+
+#if defined(ALLOCATOR_PORT_BAREMETAL)
+
+#include "port.h"
+
+/** Unit of the values returned by bench_now(). */
+#define BENCH_TICK_UNIT "cycles"
+
+/** @brief Prepares the timestamp source; call once before bench_now(). */
+static inline void bench_timer_init(void) {
+    port_cycles_init();
+}
+
+/**
+ * @brief Reads the current timestamp.
+ *
+ * @return Cycle count since bench_timer_init().
+ */
+static inline uint64_t bench_now(void) {
+    return port_cycles();
+}
+
+#else /* hosted */
+
+#include <time.h>
+
+/** Unit of the values returned by bench_now(). */
+#define BENCH_TICK_UNIT "ns"
+
+/** @brief Prepares the timestamp source; call once before bench_now(). */
+static inline void bench_timer_init(void) {
+}
+
+/**
+ * @brief Reads the current timestamp.
+ *
+ * @return Monotonic time in nanoseconds.
+ */
+static inline uint64_t bench_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+#endif /* ALLOCATOR_PORT_BAREMETAL */
+
+#endif /* BENCH_TIMER_H */
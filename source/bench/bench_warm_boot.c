@@ -0,0 +1,71 @@
+/**
+ * @file bench_warm_boot.c
+ * @brief Startup cost: rebuilding a heap versus restoring it.
+ *
+ * - cold:     the allocation storm, i.e. allocating every object again.
+ * - image:    allocator_snapshot_restore() from a RAM copy (metadata + pool).
+ * - retained: allocator_warm_boot() over a pool left in place (metadata only).
+ *
+ * Usage: bench_warm_boot [rounds]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include "allocator.h"
+#include "allocator_snapshot.h"
+#include "bench_timer.h"
+
+#define SMALL_OBJECTS  1200
+#define LARGE_OBJECTS  24
+
+static uint8_t image[ALLOCATOR_TOTAL_MEMORY + 4096u];
+static int *objects[SMALL_OBJECTS + LARGE_OBJECTS];
+
+static uint32_t failed;
+
+static void storm(void) {
+    uint32_t n = 0;
+    for (uint32_t i = 0; i < LARGE_OBJECTS; ++i) objects[n++] = allocate(600 + (int)(i % 5u) * 100);
+    for (uint32_t i = 0; i < SMALL_OBJECTS; ++i) objects[n++] = allocate_fast(16 + (int)(i % 6u) * 8);
+    for (uint32_t i = 0; i < n; ++i) failed += (objects[i] == NULL);
+}
+
+static void release(void) {
+    for (uint32_t i = 0; i < SMALL_OBJECTS + LARGE_OBJECTS; ++i) deallocate_fast(objects[i]);
+    allocator_trim();
+}
+
+int main(int argc, char **argv) {
+    uint32_t rounds = (argc > 1) ? (uint32_t)strtoul(argv[1], NULL, 10) : 200u;
+    uint64_t cold = 0, restore = 0, warm = 0;
+
+    bench_timer_init();
+    for (uint32_t r = 0; r < rounds; ++r) {
+        uint64_t t0 = bench_now();
+        storm();
+        cold += bench_now() - t0;
+
+        allocator_snapshot_save(image, sizeof image);
+        release();
+
+        t0 = bench_now();
+        if (allocator_snapshot_restore(image, sizeof image) != 0) ++failed;
+        restore += bench_now() - t0;
+
+        /* Any change after allocator_retain() drops the record, so retain
+         * the restored heap right before the "reset" */
+        allocator_retain();
+        t0 = bench_now();
+        if (allocator_warm_boot() != 1) ++failed;
+        warm += bench_now() - t0;
+        release();
+    }
+
+    printf("=== Warm Boot Benchmark (%u objects) ===\n", SMALL_OBJECTS + LARGE_OBJECTS);
+    if (failed) printf("warning: %u allocations or restores failed\n", (unsigned)failed);
+    printf("cold      %12.1f %s\n", (double)cold / rounds, BENCH_TICK_UNIT);
+    printf("image     %12.1f %s\n", (double)restore / rounds, BENCH_TICK_UNIT);
+    printf("retained  %12.1f %s\n", (double)warm / rounds, BENCH_TICK_UNIT);
+    return 0;
+}
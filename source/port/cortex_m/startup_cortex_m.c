@@ -0,0 +1,177 @@
+/**
+ * @file startup_cortex_m.c
+ * @brief Vector table, reset handler, system calls and cycle counter for
+ *        Cortex-M targets (QEMU MPS2 boards or real hardware).
+ *
+ * Console output and program exit use Arm semihosting, so QEMU must be started
+ * with `-semihosting-config enable=on,target=native`.
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+#include "port.h"
+
+/* ---------------------------------------------------------------------------- */
+/*                              Linker Script Symbols                           */
+/* ---------------------------------------------------------------------------- */
+
+extern uint32_t _sidata;    /**< Load address of .data in flash. */
+extern uint32_t _sdata;     /**< Start of .data in RAM. */
+extern uint32_t _edata;     /**< End of .data in RAM. */
+extern uint32_t _sbss;      /**< Start of .bss. */
+extern uint32_t _ebss;      /**< End of .bss. */
+extern uint32_t _estack;    /**< Initial stack pointer (top of RAM). */
+
+extern int main(int argc, char **argv);
+extern void __libc_init_array(void);
+
+/* ---------------------------------------------------------------------------- */
+/*                                 System Registers                             */
+/* ---------------------------------------------------------------------------- */
+
+#define SCB_CPACR    (*(volatile uint32_t*)0xE000ED88u)
+#define CORE_DEMCR   (*(volatile uint32_t*)0xE000EDFCu)
+#define DWT_CTRL     (*(volatile uint32_t*)0xE0001000u)
+#define DWT_CYCCNT   (*(volatile uint32_t*)0xE0001004u)
+#define SYST_CSR     (*(volatile uint32_t*)0xE000E010u)
+#define SYST_RVR     (*(volatile uint32_t*)0xE000E014u)
+#define SYST_CVR     (*(volatile uint32_t*)0xE000E018u)
+
+#define SYST_RELOAD  0x00FFFFFFu    /**< Full 24-bit SysTick range. */
+
+/* ---------------------------------------------------------------------------- */
+/*                                    Semihosting                               */
+/* ---------------------------------------------------------------------------- */
+
+#define SH_SYS_WRITE          0x05
+#define SH_SYS_EXIT_EXTENDED  0x20
+#define SH_ADP_STOPPED_EXIT   0x20026
+
+/**
+ * @brief Issues a semihosting request to the debugger or emulator.
+ */
+static int semihost(int op, void *arg) {
+    register int r0 __asm__("r0") = op;
+    register void *r1 __asm__("r1") = arg;
+    __asm__ volatile ("bkpt 0xab" : "+r"(r0) : "r"(r1) : "memory");
+    return r0;
+}
+
+int _write(int fd, const char *buf, int len) {
+    uint32_t args[3] = { (uint32_t)fd, (uint32_t)(uintptr_t)buf, (uint32_t)len };
+    int left = semihost(SH_SYS_WRITE, args);    /* returns bytes NOT written */
+    return len - left;
+}
+
+void _exit(int status) {
+    uint32_t args[2] = { SH_ADP_STOPPED_EXIT, (uint32_t)status };
+    for (;;) semihost(SH_SYS_EXIT_EXTENDED, args);
+}
+
+int _isatty(int fd) {
+    (void)fd;
+    return 1;
+}
+
+int _fstat(int fd, struct stat *st) {
+    (void)fd;
+    st->st_mode = S_IFCHR;
+    return 0;
+}
+
+/* ---------------------------------------------------------------------------- */
+/*                                   Cycle Counter                              */
+/* ---------------------------------------------------------------------------- */
+
+/** Non-zero when DWT->CYCCNT is implemented (it is not emulated by QEMU). */
+static uint8_t use_dwt;
+
+/** Upper bits of the 64-bit count (DWT wraps or SysTick reloads). */
+static volatile uint32_t cycles_hi;
+
+/** Last DWT value seen, used to detect 32-bit wrap-around. */
+static uint32_t dwt_last;
+
+void SysTick_Handler(void) {
+    ++cycles_hi;
+}
+
+void port_cycles_init(void) {
+    CORE_DEMCR |= (1u << 24);       /* TRCENA */
+    DWT_CYCCNT = 0;
+    DWT_CTRL |= 1u;                 /* CYCCNTENA */
+    for (volatile int i = 0; i < 16; ++i) { }
+    use_dwt = (DWT_CYCCNT != 0);
+
+    if (!use_dwt) {
+        SYST_RVR = SYST_RELOAD;
+        SYST_CVR = 0;
+        SYST_CSR = 0x7u;            /* ENABLE | TICKINT | CLKSOURCE=core */
+    }
+}
+
+uint64_t port_cycles(void) {
+    if (use_dwt) {
+        uint32_t now = DWT_CYCCNT;
+        if (now < dwt_last) ++cycles_hi;
+        dwt_last = now;
+        return ((uint64_t)cycles_hi << 32) | now;
+    }
+
+    /* SysTick counts down; re-read if a reload happened in between. */
+    uint32_t hi, cvr;
+    do {
+        hi  = cycles_hi;
+        cvr = SYST_CVR;
+    } while (hi != cycles_hi);
+    return (uint64_t)hi * (SYST_RELOAD + 1u) + (SYST_RELOAD - cvr);
+}
+
+/* ---------------------------------------------------------------------------- */
+/*                               Reset and Vectors                              */
+/* ---------------------------------------------------------------------------- */
+
+void Reset_Handler(void) {
+    uint32_t *src = &_sidata;
+    for (uint32_t *dst = &_sdata; dst < &_edata; ) *dst++ = *src++;
+    for (uint32_t *dst = &_sbss; dst < &_ebss; ) *dst++ = 0;
+
+#if defined(__ARM_FP)
+    SCB_CPACR |= (0xFu << 20);      /* full access to CP10/CP11 */
+    __asm__ volatile ("dsb\n\tisb" ::: "memory");
+#endif
+
+    __libc_init_array();
+    exit(main(0, NULL));
+}
+
+void Default_Handler(void) {
+    _exit(127);
+}
+
+void NMI_Handler(void)        __attribute__((weak, alias("Default_Handler")));
+void HardFault_Handler(void)  __attribute__((weak, alias("Default_Handler")));
+void MemManage_Handler(void)  __attribute__((weak, alias("Default_Handler")));
+void BusFault_Handler(void)   __attribute__((weak, alias("Default_Handler")));
+void UsageFault_Handler(void) __attribute__((weak, alias("Default_Handler")));
+void SVC_Handler(void)        __attribute__((weak, alias("Default_Handler")));
+void PendSV_Handler(void)     __attribute__((weak, alias("Default_Handler")));
+
+/** Core exception vectors; the board's external interrupts are not used. */
+__attribute__((section(".isr_vector"), used))
+static void (*const vector_table[16])(void) = {
+    (void (*)(void))(uintptr_t)&_estack,
+    Reset_Handler,
+    NMI_Handler,
+    HardFault_Handler,
+    MemManage_Handler,
+    BusFault_Handler,
+    UsageFault_Handler,
+    0, 0, 0, 0,
+    SVC_Handler,
+    0,
+    0,
+    PendSV_Handler,
+    SysTick_Handler,
+};
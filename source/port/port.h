@@ -0,0 +1,30 @@
+#ifndef PORT_H
+#define PORT_H
+
+/**
+ * @file port.h
+ * @brief Minimal board support used by the bare-metal builds of the demo,
+ *        tests and benchmarks.
+ *
+ * Each port (cortex_m, riscv32) provides the reset/startup code, a linker
+ * script, newlib system calls for console output and exit, and a cycle
+ * counter. The allocator library itself does not depend on the port.
+ */
+
+#include <stdint.h>
+
+/**
+ * @brief Starts the free-running cycle counter.
+ *
+ * Must be called once before port_cycles().
+ */
+void port_cycles_init(void);
+
+/**
+ * @brief Reads the cycle counter.
+ *
+ * @return Number of counter ticks since port_cycles_init().
+ */
+uint64_t port_cycles(void);
+
+#endif /* PORT_H */
@@ -0,0 +1,73 @@
+/**
+ * @file port_riscv32.c
+ * @brief System calls and cycle counter for RV32 bare-metal targets
+ *        (QEMU "virt" machine).
+ *
+ * Console output goes to the NS16550 UART; exit status is reported through
+ * the SiFive test device so that QEMU terminates with the program's status.
+ */
+
+#include <stdint.h>
+#include <sys/stat.h>
+#include "port.h"
+
+/* ---------------------------------------------------------------------------- */
+/*                                 Board Devices                                */
+/* ---------------------------------------------------------------------------- */
+
+#define UART0_BASE   0x10000000u
+#define UART_THR     (*(volatile uint8_t*)(UART0_BASE + 0u))
+#define UART_LSR     (*(volatile uint8_t*)(UART0_BASE + 5u))
+#define UART_LSR_THRE 0x20u
+
+#define TEST_DEVICE  (*(volatile uint32_t*)0x00100000u)
+#define TEST_PASS    0x5555u
+#define TEST_FAIL    0x3333u
+
+/* ---------------------------------------------------------------------------- */
+/*                                  System Calls                                */
+/* ---------------------------------------------------------------------------- */
+
+int _write(int fd, const char *buf, int len) {
+    (void)fd;
+    for (int i = 0; i < len; ++i) {
+        while ((UART_LSR & UART_LSR_THRE) == 0) { }
+        UART_THR = (uint8_t)buf[i];
+    }
+    return len;
+}
+
+void _exit(int status) {
+    TEST_DEVICE = (status == 0) ? TEST_PASS
+                                : (((uint32_t)status << 16) | TEST_FAIL);
+    for (;;) __asm__ volatile ("wfi");
+}
+
+int _isatty(int fd) {
+    (void)fd;
+    return 1;
+}
+
+int _fstat(int fd, struct stat *st) {
+    (void)fd;
+    st->st_mode = S_IFCHR;
+    return 0;
+}
+
+/* ---------------------------------------------------------------------------- */
+/*                                  Cycle Counter                               */
+/* ---------------------------------------------------------------------------- */
+
+void port_cycles_init(void) {
+    /* mcycle runs from reset in M-mode; nothing to enable. */
+}
+
+uint64_t port_cycles(void) {
+    uint32_t hi, lo, hi2;
+    do {
+        __asm__ volatile ("csrr %0, mcycleh" : "=r"(hi));
+        __asm__ volatile ("csrr %0, mcycle"  : "=r"(lo));
+        __asm__ volatile ("csrr %0, mcycleh" : "=r"(hi2));
+    } while (hi != hi2);
+    return ((uint64_t)hi << 32) | lo;
+}
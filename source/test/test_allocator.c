@@ -0,0 +1,435 @@
+/**
+ * @file test_allocator.c
+ * @brief Unit tests for the core allocate()/deallocate() API.
+ *
+ * Every test leaves the pool empty so that the next one starts from the same
+ * state as a freshly booted system.
+ */
+
+#include <stdint.h>
+#include <string.h>
+#include "allocator.h"
+#include "allocator_config.h"
+#include "test_common.h"
+
+/** Returns non-zero if the byte ranges [a, a+an) and [b, b+bn) overlap. */
+static int overlaps(const void *a, int an, const void *b, int bn) {
+    const uint8_t *pa = (const uint8_t*)a;
+    const uint8_t *pb = (const uint8_t*)b;
+    return pa < pb + bn && pb < pa + an;
+}
+
+static void test_invalid_sizes(void) {
+    TEST_CHECK(allocate(0) == NULL);
+    TEST_CHECK(allocate(-1) == NULL);
+    TEST_CHECK(allocate((int)ALLOCATOR_TOTAL_MEMORY + 1) == NULL);
+}
+
+static void test_distinct_blocks(void) {
+    int *a = allocate(128);
+    int *b = allocate(1024);
+    int *c = allocate(4096);
+    TEST_CHECK(a && b && c);
+    TEST_CHECK(!overlaps(a, 128, b, 1024));
+    TEST_CHECK(!overlaps(b, 1024, c, 4096));
+    TEST_CHECK(!overlaps(a, 128, c, 4096));
+
+    memset(a, 0xAA, 128);
+    memset(b, 0xBB, 1024);
+    memset(c, 0xCC, 4096);
+    TEST_CHECK(((uint8_t*)a)[127] == 0xAA);
+    TEST_CHECK(((uint8_t*)b)[0] == 0xBB && ((uint8_t*)b)[1023] == 0xBB);
+    TEST_CHECK(((uint8_t*)c)[0] == 0xCC);
+
+    deallocate(a);
+    deallocate(b);
+    deallocate(c);
+}
+
+static void test_alignment(void) {
+    int *a = allocate(3);
+    int *b = allocate(5);
+    int *c = allocate(1);
+    TEST_CHECK(a && b && c);
+    TEST_CHECK(((uintptr_t)a % ALLOCATOR_ALIGNMENT) == 0);
+    TEST_CHECK(((uintptr_t)b % ALLOCATOR_ALIGNMENT) == 0);
+    TEST_CHECK(((uintptr_t)c % ALLOCATOR_ALIGNMENT) == 0);
+    deallocate(a);
+    deallocate(b);
+    deallocate(c);
+}
+
+static void test_cacheline_flag(void) {
+    const uintptr_t line = ALLOCATOR_CACHE_LINE;
+    int *a = allocate(4);
+    int *b = allocate_flags(16, ALLOCATOR_F_CACHELINE);
+    int *c = allocate(4);
+    TEST_CHECK(a && b && c);
+    TEST_CHECK(((uintptr_t)b % line) == 0);
+    /* Neighbours stay out of b's line on both sides */
+    TEST_CHECK((uintptr_t)a / line != (uintptr_t)b / line);
+    TEST_CHECK((uintptr_t)c / line != (uintptr_t)b / line);
+
+    /* Without the flag, allocate_flags() is allocate() */
+    int *d = allocate_flags(4, 0);
+    TEST_CHECK(d != NULL && (uintptr_t)d < (uintptr_t)b);
+
+    TEST_CHECK(allocate_flags(0, ALLOCATOR_F_CACHELINE) == NULL);
+    TEST_CHECK(allocate_flags((int)ALLOCATOR_TOTAL_MEMORY, ALLOCATOR_F_CACHELINE) == NULL);
+
+    deallocate(a);
+    deallocate(b);
+    deallocate(c);
+    deallocate(d);
+}
+
+static void test_scatter_gather(void) {
+    enum { BLOCKS = 16, BLOCK = 1000 };
+    int *blk[BLOCKS];
+    for (int i = 0; i < BLOCKS; ++i) blk[i] = allocate(BLOCK);
+    int *tail = allocate((int)ALLOCATOR_TOTAL_MEMORY / 2);
+    TEST_CHECK(tail != NULL);
+    int *rest = NULL;
+    for (int sz = (int)ALLOCATOR_TOTAL_MEMORY / 2; sz > 0 && !rest; sz -= 8) rest = allocate(sz);
+    TEST_CHECK(rest != NULL);
+
+    /* Every other block freed: 8 gaps of BLOCK bytes, none larger */
+    for (int i = 0; i < BLOCKS; i += 2) deallocate(blk[i]);
+    TEST_CHECK(allocate(3 * BLOCK) == NULL);
+
+    allocator_iovec_t iov[8];
+    uint32_t n = allocate_sg(3 * BLOCK + 5, 8, iov);
+    TEST_CHECK(n == 4);
+    size_t sum = 0;
+    for (uint32_t i = 0; i < n; ++i) {
+        sum += iov[i].iov_len;
+        TEST_CHECK(iov[i].iov_base == (void*)blk[2 * i]);
+        TEST_CHECK(((uintptr_t)iov[i].iov_base % ALLOCATOR_ALIGNMENT) == 0);
+        memset(iov[i].iov_base, 0x5A, iov[i].iov_len);
+    }
+    TEST_CHECK(sum == 3 * BLOCK + 5);
+    TEST_CHECK(iov[3].iov_len == 5);
+
+    /* Too few segments allowed: nothing is taken */
+    allocator_iovec_t few[2];
+    TEST_CHECK(allocate_sg(3 * BLOCK, 2, few) == 0);
+    TEST_CHECK(allocate_sg(0, 8, iov + 4) == 0);
+    /* The next request starts in what is left of the last gap used */
+    uint32_t n2 = allocate_sg(2 * BLOCK, 4, iov + 4);
+    TEST_CHECK(n2 == 3);
+    TEST_CHECK((uint8_t*)iov[4].iov_base == (uint8_t*)blk[6] + 8);
+    deallocate_sg(iov + 4, n2);
+
+    /* Frees go through deallocate(): the gaps are whole again */
+    deallocate_sg(iov, n);
+    int *whole = allocate(BLOCK);
+    TEST_CHECK(whole == blk[0]);
+    deallocate(whole);
+
+    for (int i = 1; i < BLOCKS; i += 2) deallocate(blk[i]);
+    deallocate(tail);
+    deallocate(rest);
+}
+
+static void test_dma(void) {
+    const uintptr_t line = ALLOCATOR_CACHE_LINE;
+
+    /* Buffers never straddle a 1 KB boundary */
+    int *buf[8];
+    for (int i = 0; i < 8; ++i) {
+        buf[i] = allocate_dma(700, 0, 1024);
+        TEST_CHECK(buf[i] != NULL);
+        TEST_CHECK(((uintptr_t)buf[i] % line) == 0);
+        TEST_CHECK(((uintptr_t)buf[i] % 1024u) + 700u <= 1024u);
+        TEST_CHECK(allocator_region_attrs(buf[i]) & ALLOCATOR_REGION_DMA);
+    }
+
+    /* Buffers that fit before the boundary are packed, not boundary-aligned */
+    int *a = allocate_dma(60, 0, 4096);
+    int *b = allocate_dma(64, 0, 4096);
+    TEST_CHECK(a && b);
+    TEST_CHECK(((uintptr_t)a % 4096u) != 0 || ((uintptr_t)b % 4096u) != 0);
+
+    /* Large alignments are honoured in address space */
+    int *c = allocate_dma(256, 4096, 0);
+    TEST_CHECK(c != NULL && ((uintptr_t)c % 4096u) == 0);
+
+    TEST_CHECK(allocate_dma(2000, 0, 1024) == NULL);
+    TEST_CHECK(allocate_dma(64, 48, 0) == NULL);
+    TEST_CHECK(allocate_dma(64, 0, 1000) == NULL);
+    TEST_CHECK(allocate_dma(0, 0, 0) == NULL);
+
+    /* Alignments far beyond the pool fail instead of wrapping around (on
+     * 32-bit targets with RAM at 0x80000000) */
+    int *huge = allocate_dma(64, 0x80000000u, 0);
+    TEST_CHECK(huge == NULL || ((uintptr_t)huge % 0x80000000u) == 0);
+    deallocate(huge);
+
+#if ALLOCATOR_DMA_MEMORY > 0u
+    /* A designated DMA pool: ordinary blocks come from elsewhere */
+    int *plain = allocate(16);
+    TEST_CHECK(allocator_region_attrs(plain) == ALLOCATOR_POOL_ATTRS);
+    TEST_CHECK(allocator_region_attrs(buf[0]) == ALLOCATOR_DMA_ATTRS);
+    deallocate(plain);
+#endif
+    TEST_CHECK(allocator_region_attrs(&line) == 0);
+
+    for (int i = 0; i < 8; ++i) deallocate(buf[i]);
+    deallocate(a);
+    deallocate(b);
+    deallocate(c);
+
+    /* Freed DMA space is reused */
+    int *again = allocate_dma(700, 0, 1024);
+    TEST_CHECK(again == buf[0]);
+    deallocate(again);
+}
+
+static void test_first_fit_reuse(void) {
+    int *a = allocate(128);
+    int *b = allocate(1024);
+    int *c = allocate(128);
+    TEST_CHECK(a && b && c);
+
+    /* The hole left by b is the lowest gap that fits, so it must be reused. */
+    deallocate(b);
+    int *d = allocate(512);
+    TEST_CHECK(d == b);
+
+    /* A request larger than the hole goes past c. */
+    int *e = allocate(2048);
+    TEST_CHECK(e != NULL && (uint8_t*)e > (uint8_t*)c);
+
+    deallocate(a);
+    deallocate(c);
+    deallocate(d);
+    deallocate(e);
+}
+
+static void test_wilderness(void) {
+    /* Growing allocations are appended back to back */
+    uint8_t *a = (uint8_t*)allocate(64);
+    uint8_t *b = (uint8_t*)allocate(64);
+    uint8_t *c = (uint8_t*)allocate(128);
+    uint8_t *d = (uint8_t*)allocate(256);
+    TEST_CHECK(a && b == a + 64 && c == b + 64 && d == c + 128);
+
+    /* Freeing the last block returns its space to the wilderness */
+    deallocate((int*)(void*)d);
+    uint8_t *e = (uint8_t*)allocate(512);
+    TEST_CHECK(e == c + 128);
+
+    /* A hole still takes the blocks that fit, first fit */
+    deallocate((int*)(void*)b);
+    uint8_t *f = (uint8_t*)allocate(96);
+    TEST_CHECK(f == e + 512);
+    uint8_t *g = (uint8_t*)allocate(32);
+    TEST_CHECK(g == b);
+
+    /* A block placed from the high end leaves a hole below it */
+    allocator_set_placement(ALLOCATOR_HEAP_POOL, 1024);
+    uint8_t *h = (uint8_t*)allocate(2048);
+    allocator_set_placement(ALLOCATOR_HEAP_POOL, 0);
+    TEST_CHECK(h != NULL && h > f + 96 + 2048);
+    uint8_t *i = (uint8_t*)allocate(1024);
+    TEST_CHECK(i == f + 96);
+
+    deallocate((int*)(void*)a);
+    deallocate((int*)(void*)c);
+    deallocate((int*)(void*)e);
+    deallocate((int*)(void*)f);
+    deallocate((int*)(void*)g);
+    deallocate((int*)(void*)h);
+    deallocate((int*)(void*)i);
+    int *all = allocate((int)ALLOCATOR_TOTAL_MEMORY);
+    TEST_CHECK(all != NULL);
+    deallocate(all);
+}
+
+static void test_full_pool(void) {
+    int *all = allocate((int)ALLOCATOR_TOTAL_MEMORY);
+    TEST_CHECK(all != NULL);
+    TEST_CHECK(allocate(16) == NULL);
+    TEST_CHECK(allocate((int)ALLOCATOR_TOTAL_MEMORY) == NULL);
+    deallocate(all);
+
+    /* Not possible while any regular block is live. */
+    int *a = allocate(16);
+    TEST_CHECK(a != NULL);
+    TEST_CHECK(allocate((int)ALLOCATOR_TOTAL_MEMORY) == NULL);
+    deallocate(a);
+
+    all = allocate((int)ALLOCATOR_TOTAL_MEMORY);
+    TEST_CHECK(all != NULL);
+    deallocate(all);
+}
+
+static void test_large_runs(void) {
+    uint8_t *end = allocator_pool_base + ALLOCATOR_TOTAL_MEMORY;
+    const int page = (int)ALLOCATOR_SLAB_BYTES;
+
+    /* Large blocks are page runs stacked down from the top of the pool */
+    int *a = allocate(8 * page);
+    int *b = allocate(5 * page - 100);
+    int *small = allocate(64);
+    TEST_CHECK((uint8_t*)a == end - 8 * page);
+    TEST_CHECK((uint8_t*)b == (uint8_t*)a - 5 * page);
+    TEST_CHECK(small != NULL && (uint8_t*)small < (uint8_t*)b);
+
+    /* A freed run is reused from its top end */
+    deallocate(a);
+    int *c = allocate(6 * page);
+    TEST_CHECK((uint8_t*)c == end - 6 * page);
+
+    /* Runs take no metadata slots */
+    int *blocks[ALLOCATOR_MAX_NODES - 1];
+    for (int i = 0; i < ALLOCATOR_MAX_NODES - 1; ++i) {
+        blocks[i] = allocate(8);
+        TEST_CHECK(blocks[i] != NULL);
+    }
+    TEST_CHECK(allocate(8) == NULL);
+    int *d = allocate((int)ALLOCATOR_LARGE_MIN);
+    TEST_CHECK(d != NULL && (uint8_t*)d < (uint8_t*)b);
+    for (int i = 0; i < ALLOCATOR_MAX_NODES - 1; ++i) deallocate(blocks[i]);
+
+    deallocate(small);
+    deallocate(b);
+    deallocate(c);
+    deallocate(d);
+
+    /* With everything freed, the whole pool is one run again */
+    int *all = allocate((int)ALLOCATOR_TOTAL_MEMORY);
+    TEST_CHECK((uint8_t*)all == allocator_pool_base);
+    TEST_CHECK(allocate(8) == NULL && allocate((int)ALLOCATOR_LARGE_MIN) == NULL);
+    deallocate(all);
+}
+
+static void test_placement(void) {
+    uint8_t *end = allocator_pool_base + ALLOCATOR_TOTAL_MEMORY;
+    TEST_CHECK(allocator_largest_free(ALLOCATOR_HEAP_POOL) == ALLOCATOR_TOTAL_MEMORY);
+    TEST_CHECK(allocator_set_placement(ALLOCATOR_HEAP_POOL, 512) == 0);
+
+    /* Small blocks from the bottom, blocks of 512 bytes or more from the top */
+    int *a = allocate(64);
+    int *b = allocate(1024);
+    int *c = allocate(2000);
+    TEST_CHECK((uint8_t*)b == end - 1024);
+    TEST_CHECK((uint8_t*)c + 2000 <= (uint8_t*)b &&
+               (uint8_t*)b - ((uint8_t*)c + 2000) < (intptr_t)ALLOCATOR_ALIGNMENT);
+    TEST_CHECK((uint8_t*)a < (uint8_t*)c);
+    TEST_CHECK(allocator_largest_free(ALLOCATOR_HEAP_POOL) ==
+               (uint32_t)((uint8_t*)c - ((uint8_t*)a + 64)));
+
+    /* Back to first fit: the next block follows the small one */
+    TEST_CHECK(allocator_set_placement(ALLOCATOR_HEAP_POOL, 0) == 0);
+    int *d = allocate(1024);
+    TEST_CHECK((uint8_t*)d == (uint8_t*)a + 64);
+
+    deallocate(a);
+    deallocate(b);
+    deallocate(c);
+    deallocate(d);
+
+    TEST_CHECK(allocator_set_placement(7, 512) == -1);
+#if ALLOCATOR_DMA_MEMORY > 0u
+    TEST_CHECK(allocator_largest_free(ALLOCATOR_HEAP_DMA) == ALLOCATOR_DMA_MEMORY);
+    TEST_CHECK(allocator_set_placement(ALLOCATOR_HEAP_DMA, 256) == 0);
+    int *top = allocate_dma(256, 0, 0);
+    TEST_CHECK(allocator_largest_free(ALLOCATOR_HEAP_DMA) == ALLOCATOR_DMA_MEMORY - 256u);
+    int *low = allocate_dma(64, 0, 0);
+    TEST_CHECK(low != NULL && (uint8_t*)low < (uint8_t*)top);
+    deallocate(low);
+    deallocate(top);
+    allocator_set_placement(ALLOCATOR_HEAP_DMA, 0);
+#else
+    TEST_CHECK(allocator_set_placement(ALLOCATOR_HEAP_DMA, 256) == -1);
+    TEST_CHECK(allocator_largest_free(ALLOCATOR_HEAP_DMA) == 0);
+#endif
+}
+
+static void test_lifetime_hints(void) {
+    uint8_t *end = allocator_pool_base + ALLOCATOR_TOTAL_MEMORY;
+    allocator_life_stats_t st;
+    allocator_reset_life_stats();
+
+    /* Long-lived blocks pack at the bottom, the others at the top */
+    int *l = allocate_hint(64, ALLOCATOR_LIFE_LONG);
+    int *s = allocate_hint(64, ALLOCATOR_LIFE_SHORT);
+    int *m = allocate_hint(128, ALLOCATOR_LIFE_MEDIUM);
+    int *l2 = allocate_hint(64, ALLOCATOR_LIFE_LONG);
+    TEST_CHECK(l != NULL && s != NULL && m != NULL && l2 != NULL);
+    TEST_CHECK((uint8_t*)s == end - 64);
+    TEST_CHECK((uint8_t*)m == end - 64 - 128);
+    TEST_CHECK((uint8_t*)l2 == (uint8_t*)l + 64);
+
+    /* Freeing the short-lived block leaves the free space in one piece */
+    uint32_t before = allocator_free_bytes(ALLOCATOR_HEAP_POOL);
+    TEST_CHECK(allocator_largest_free(ALLOCATOR_HEAP_POOL) == before);
+    deallocate(s);
+    TEST_CHECK(allocator_free_bytes(ALLOCATOR_HEAP_POOL) == before + 64);
+    TEST_CHECK(allocator_largest_free(ALLOCATOR_HEAP_POOL) == before);
+
+    TEST_CHECK(allocate_hint(64, ALLOCATOR_LIFE_CLASSES) == NULL);
+    TEST_CHECK(allocate_hint((int)ALLOCATOR_TOTAL_MEMORY + 1, ALLOCATOR_LIFE_LONG) == NULL);
+    allocator_get_life_stats(&st);
+    TEST_CHECK(st.requests[ALLOCATOR_LIFE_LONG] == 3 && st.failed[ALLOCATOR_LIFE_LONG] == 1);
+    TEST_CHECK(st.requests[ALLOCATOR_LIFE_SHORT] == 1 && st.failed[ALLOCATOR_LIFE_SHORT] == 0);
+
+    deallocate(l);
+    deallocate(m);
+    deallocate(l2);
+    allocator_reset_life_stats();
+    allocator_get_life_stats(&st);
+    TEST_CHECK(st.requests[ALLOCATOR_LIFE_LONG] == 0);
+}
+
+static void test_exhaustion(void) {
+    /* Metadata slots run out before pool bytes for tiny blocks. */
+    int *blocks[ALLOCATOR_MAX_NODES];
+    for (int i = 0; i < ALLOCATOR_MAX_NODES; ++i) {
+        blocks[i] = allocate(8);
+        TEST_CHECK(blocks[i] != NULL);
+    }
+    TEST_CHECK(allocate(8) == NULL);
+    for (int i = 0; i < ALLOCATOR_MAX_NODES; ++i) {
+        deallocate(blocks[i]);
+    }
+
+    /* Pool bytes run out for a request larger than the pool. */
+    TEST_CHECK(allocate((int)ALLOCATOR_TOTAL_MEMORY + 1) == NULL);
+}
+
+static void test_invalid_frees(void) {
+    int local = 0;
+    int *a = allocate(64);
+    TEST_CHECK(a != NULL);
+
+    deallocate(NULL);
+    deallocate(&local);            /* outside the pool */
+    deallocate(a + 1);             /* not a block start */
+
+    deallocate(a);
+    deallocate(a);                 /* double free is ignored */
+
+    int *b = allocate(64);
+    TEST_CHECK(b == a);
+    deallocate(b);
+}
+
+int main(void) {
+    TEST_RUN(test_invalid_sizes);
+    TEST_RUN(test_distinct_blocks);
+    TEST_RUN(test_alignment);
+    TEST_RUN(test_cacheline_flag);
+    TEST_RUN(test_scatter_gather);
+    TEST_RUN(test_dma);
+    TEST_RUN(test_first_fit_reuse);
+    TEST_RUN(test_wilderness);
+    TEST_RUN(test_full_pool);
+    TEST_RUN(test_large_runs);
+    TEST_RUN(test_placement);
+    TEST_RUN(test_lifetime_hints);
+    TEST_RUN(test_exhaustion);
+    TEST_RUN(test_invalid_frees);
+    return TEST_EXIT();
+}
@@ -0,0 +1,168 @@
+/**
+ * @file test_cache.c
+ * @brief Tests of object caches.
+ */
+
+#include <stdint.h>
+#include <string.h>
+#include "allocator.h"
+#include "allocator_cache.h"
+#include "test_common.h"
+
+/** Object with state that is expensive to set up. */
+typedef struct {
+    uint32_t magic;
+    uint32_t uses;
+    uint8_t  table[40];
+} conn_t;
+
+static uint32_t ctor_calls, dtor_calls;
+
+static void conn_ctor(void *obj) {
+    conn_t *c = (conn_t*)obj;
+    c->magic = 0xC0FFEEu;
+    c->uses = 0;
+    for (uint32_t i = 0; i < sizeof c->table; ++i) c->table[i] = (uint8_t)i;
+    ++ctor_calls;
+}
+
+static void conn_dtor(void *obj) {
+    conn_t *c = (conn_t*)obj;
+    TEST_CHECK(c->magic == 0xC0FFEEu);
+    c->magic = 0;
+    ++dtor_calls;
+}
+
+static void test_constructed_state_kept(void) {
+    ctor_calls = dtor_calls = 0;
+    cache_t *c = cache_create(sizeof(conn_t), 0, conn_ctor, conn_dtor);
+    TEST_CHECK(c != NULL);
+
+    conn_t *a = (conn_t*)cache_alloc(c);
+    TEST_CHECK(a != NULL && a->magic == 0xC0FFEEu && a->table[39] == 39);
+    uint32_t per_slab = ctor_calls;
+    TEST_CHECK(per_slab >= 4);
+
+    /* The object comes back as it was left, without a constructor call */
+    a->uses = 7;
+    cache_free(c, a);
+    conn_t *b = (conn_t*)cache_alloc(c);
+    TEST_CHECK(b == a && b->uses == 7);
+    TEST_CHECK(ctor_calls == per_slab);
+
+    cache_stats_t st;
+    cache_get_stats(c, &st);
+    TEST_CHECK(st.slabs == 1 && st.objects == per_slab && st.in_use == 1);
+    TEST_CHECK(st.constructed == per_slab && st.allocs == 2);
+
+    cache_free(c, b);
+    TEST_CHECK(cache_destroy(c) == 0);
+    TEST_CHECK(dtor_calls == per_slab);
+    TEST_CHECK(pool_is_free());
+}
+
+static void test_grow_and_reap(void) {
+    ctor_calls = dtor_calls = 0;
+    cache_t *c = cache_create(sizeof(conn_t), 0, conn_ctor, conn_dtor);
+    enum { N = 100 };
+    conn_t *objs[N];
+    for (uint32_t i = 0; i < N; ++i) {
+        objs[i] = (conn_t*)cache_alloc(c);
+        TEST_CHECK(objs[i] != NULL);
+        objs[i]->uses = i;
+    }
+    for (uint32_t i = 0; i < N; ++i) {
+        for (uint32_t j = i + 1; j < N; ++j) TEST_CHECK(objs[i] != objs[j]);
+        TEST_CHECK(objs[i]->uses == i);
+    }
+
+    cache_stats_t st;
+    cache_get_stats(c, &st);
+    TEST_CHECK(st.slabs > 1 && st.in_use == N && st.objects >= N);
+    TEST_CHECK(ctor_calls == st.objects);
+
+    /* Busy slabs stay, and a cache with objects in use cannot go */
+    TEST_CHECK(cache_reap(c) == 0);
+    TEST_CHECK(cache_destroy(c) == -1);
+
+    /* Foreign and NULL pointers are ignored */
+    int *other = allocate(32);
+    cache_free(c, other);
+    cache_free(c, NULL);
+    cache_free(c, (uint8_t*)objs[0] + 1);
+    deallocate(other);
+    cache_get_stats(c, &st);
+    TEST_CHECK(st.in_use == N);
+
+    /* A second free of an object in a partial slab is ignored too */
+    cache_free(c, objs[N - 1]);
+    cache_free(c, objs[N - 1]);
+    cache_get_stats(c, &st);
+    TEST_CHECK(st.in_use == N - 1);
+    TEST_CHECK(cache_reap(c) == 0);
+    TEST_CHECK(cache_alloc(c) == objs[N - 1]);
+    void *next = cache_alloc(c);
+    TEST_CHECK(next != NULL && next != objs[N - 1]);
+    cache_free(c, next);
+    cache_get_stats(c, &st);
+    TEST_CHECK(st.in_use == N);
+
+    for (uint32_t i = 0; i < N; ++i) cache_free(c, objs[i]);
+    uint32_t slabs = st.slabs;
+    TEST_CHECK(cache_reap(c) == slabs);
+    TEST_CHECK(dtor_calls == ctor_calls);
+    cache_get_stats(c, &st);
+    TEST_CHECK(st.slabs == 0 && st.objects == 0 && st.in_use == 0);
+
+    /* The cache still works after a reap */
+    void *again = cache_alloc(c);
+    TEST_CHECK(again != NULL && ((conn_t*)again)->magic == 0xC0FFEEu);
+    cache_free(c, again);
+    TEST_CHECK(cache_destroy(c) == 0);
+    TEST_CHECK(pool_is_free());
+}
+
+static void test_alignment(void) {
+    static const uint32_t aligns[] = { 0, 8, 32, 64, 256 };
+    for (uint32_t k = 0; k < sizeof aligns / sizeof aligns[0]; ++k) {
+        uint32_t align = aligns[k] ? aligns[k] : ALLOCATOR_ALIGNMENT;
+        cache_t *c = cache_create(24, aligns[k], NULL, NULL);
+        TEST_CHECK(c != NULL);
+        void *p[20];
+        for (uint32_t i = 0; i < 20; ++i) {
+            p[i] = cache_alloc(c);
+            TEST_CHECK(p[i] != NULL && ((uintptr_t)p[i] & (align - 1u)) == 0);
+            memset(p[i], 0x5A, 24);
+        }
+        for (uint32_t i = 0; i < 20; ++i) cache_free(c, p[i]);
+        TEST_CHECK(cache_destroy(c) == 0);
+    }
+    TEST_CHECK(pool_is_free());
+}
+
+static void test_invalid(void) {
+    TEST_CHECK(cache_create(0, 0, NULL, NULL) == NULL);
+    TEST_CHECK(cache_create(16, 24, NULL, NULL) == NULL);
+    TEST_CHECK(cache_create(ALLOCATOR_TOTAL_MEMORY, 0, NULL, NULL) == NULL);
+    TEST_CHECK(cache_destroy(NULL) == 0);
+
+    /* Large objects still get a few per slab */
+    cache_t *c = cache_create(3000, 0, NULL, NULL);
+    TEST_CHECK(c != NULL);
+    void *a = cache_alloc(c);
+    TEST_CHECK(a != NULL);
+    cache_stats_t st;
+    cache_get_stats(c, &st);
+    TEST_CHECK(st.objects == 4);
+    cache_free(c, a);
+    TEST_CHECK(cache_destroy(c) == 0);
+    TEST_CHECK(pool_is_free());
+}
+
+int main(void) {
+    TEST_RUN(test_constructed_state_kept);
+    TEST_RUN(test_grow_and_reap);
+    TEST_RUN(test_alignment);
+    TEST_RUN(test_invalid);
+    return TEST_EXIT();
+}
@@ -0,0 +1,147 @@
+/**
+ * @file test_classes.c
+ * @brief Tests of size-class tuning.
+ *
+ * Built twice: with ALLOCATOR_ADAPTIVE_CLASSES=1 to record a workload and
+ * re-tune at run time, and with the layout exported from that run
+ * (test_classes_table.h) as a compile-time table.
+ */
+
+#include <stdint.h>
+#include <string.h>
+#include "allocator.h"
+#include "allocator_classes.h"
+#include "test_common.h"
+
+/** Distance between two consecutive blocks of a class, in bytes. */
+static intptr_t block_stride(int size) {
+    int *a = allocate_fast(size);
+    int *b = allocate_fast(size);
+    intptr_t d = (uint8_t*)b - (uint8_t*)a;
+    deallocate(a);
+    deallocate(b);
+    return d;
+}
+
+#if ALLOCATOR_ADAPTIVE_CLASSES
+
+/** Request sizes of the workload, most of them far from the default classes. */
+static const int sizes[] = { 24, 100, 200, 300, 300, 500, 500, 500 };
+#define NSIZES ((int)(sizeof sizes / sizeof sizes[0]))
+
+static void run_workload(int rounds) {
+    for (int r = 0; r < rounds; ++r) {
+        for (int i = 0; i < NSIZES; ++i) deallocate(allocate_fast(sizes[i]));
+    }
+}
+
+static void test_histogram(void) {
+    allocator_size_histogram_reset();
+    run_workload(10);
+    int *big = allocate(4096);
+    deallocate(big);
+
+    const uint32_t *h = allocator_size_histogram();
+    TEST_CHECK(h[(24 - 1) / ALLOCATOR_CLASS_GRANULE] == 10);
+    TEST_CHECK(h[(300 - 1) / ALLOCATOR_CLASS_GRANULE] == 20);
+    TEST_CHECK(h[(500 - 1) / ALLOCATOR_CLASS_GRANULE] == 30);
+    TEST_CHECK(h[ALLOCATOR_CLASS_BUCKETS] == 1);
+}
+
+static void test_retune_reduces_waste(void) {
+    allocator_size_histogram_reset();
+    run_workload(10);
+    const uint32_t *h = allocator_size_histogram();
+
+    allocator_class_layout_t before, tuned;
+    allocator_classes_current(h, &before);
+    TEST_CHECK(before.size[0] == ALLOCATOR_CLASS_GRANULE);
+    TEST_CHECK(before.size[ALLOCATOR_NUM_CLASSES - 1u] == ALLOCATOR_SMALL_MAX);
+    TEST_CHECK(before.waste > 0);
+
+    /* Classes cannot change under a live block */
+    int *live = allocate_fast(300);
+    TEST_CHECK(allocator_classes_retune(8, &tuned) == -1);
+    deallocate(live);
+
+    TEST_CHECK(allocator_classes_retune(8, &tuned) == 0);
+    /* Fewer distinct sizes than classes: nothing is lost beyond the granule */
+    TEST_CHECK(tuned.waste == 0 && before.waste > tuned.waste);
+    TEST_CHECK(tuned.size[ALLOCATOR_NUM_CLASSES - 1u] == ALLOCATOR_SMALL_MAX);
+    uint32_t slabs = 0;
+    for (uint32_t c = 0; c < ALLOCATOR_NUM_CLASSES; ++c) slabs += tuned.slabs[c];
+    TEST_CHECK(slabs == 8);
+    TEST_CHECK(tuned.slabs[allocator_size_class(500)] > tuned.slabs[allocator_size_class(24)]);
+
+    /* The fast path now hands out blocks of the tuned sizes */
+    TEST_CHECK(block_stride(300) == 304);
+    TEST_CHECK(block_stride(100) == 112);
+    TEST_CHECK(allocator_class_size(allocator_size_class(500)) == 512);
+
+    allocator_class_layout_t now;
+    allocator_classes_current(h, &now);
+    TEST_CHECK(now.waste == 0 && memcmp(now.size, tuned.size, sizeof now.size) == 0);
+
+    TEST_CHECK(allocator_classes_prefill(tuned.slabs) == 0);
+    TEST_CHECK(allocator_class_free[allocator_size_class(500)] != NULL);
+    allocator_trim();
+
+    char text[1024];
+    size_t n = allocator_classes_export(&tuned, text, sizeof text);
+    TEST_CHECK(n < sizeof text && strlen(text) == n);
+    TEST_CHECK(strstr(text, "#define ALLOCATOR_CLASS_TABLE {") != NULL);
+    TEST_CHECK(strstr(text, " 304,") != NULL);
+    TEST_CHECK(strstr(text, "#define ALLOCATOR_CLASS_PREFILL {") != NULL);
+
+    /* Truncated output is still terminated, and the full length is reported */
+    char small[16];
+    TEST_CHECK(allocator_classes_export(&tuned, small, sizeof small) == n);
+    TEST_CHECK(strlen(small) == sizeof small - 1u);
+}
+
+static void test_apply_rejects_bad_layout(void) {
+    allocator_class_layout_t l;
+    allocator_classes_current(NULL, &l);
+    l.size[3] = l.size[2];
+    TEST_CHECK(allocator_classes_apply(&l) == -1);
+    allocator_classes_current(NULL, &l);
+    l.size[ALLOCATOR_NUM_CLASSES - 1u] -= ALLOCATOR_CLASS_GRANULE;
+    TEST_CHECK(allocator_classes_apply(&l) == -1);
+}
+
+#else /* compile-time table */
+
+static void test_table(void) {
+    static const uint16_t table[] = ALLOCATOR_CLASS_TABLE;
+    static const uint16_t prefill[] = ALLOCATOR_CLASS_PREFILL;
+    for (uint32_t c = 0; c < ALLOCATOR_NUM_CLASSES; ++c) {
+        TEST_CHECK(allocator_class_size(c) == table[c]);
+    }
+    TEST_CHECK(allocator_classes_prefill(prefill) == 0);
+    TEST_CHECK(block_stride(300) == 304);
+    TEST_CHECK(block_stride(200) == 208);
+
+    allocator_class_layout_t l;
+    allocator_classes_current(NULL, &l);
+    for (uint32_t b = 0; b < ALLOCATOR_CLASS_BUCKETS; ++b) {
+        TEST_CHECK(l.index[b] == allocator_size_class((b + 1u) * ALLOCATOR_CLASS_GRANULE));
+    }
+
+    allocator_trim();
+    int *whole = allocate((int)ALLOCATOR_TOTAL_MEMORY);
+    TEST_CHECK(whole != NULL);
+    deallocate(whole);
+}
+
+#endif
+
+int main(void) {
+#if ALLOCATOR_ADAPTIVE_CLASSES
+    TEST_RUN(test_histogram);
+    TEST_RUN(test_retune_reduces_waste);
+    TEST_RUN(test_apply_rejects_bad_layout);
+#else
+    TEST_RUN(test_table);
+#endif
+    return TEST_EXIT();
+}
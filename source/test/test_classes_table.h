@@ -0,0 +1,13 @@
+/**
+ * @file test_classes_table.h
+ * @brief Layout exported by allocator_classes_export() for the workload of
+ *        test_classes.c; used by the test_classes_table build.
+ */
+
+/* Size classes from allocator_classes_tune(); waste 0 bytes */
+#define ALLOCATOR_CLASS_GRANULE 16u
+#define ALLOCATOR_NUM_CLASSES 16u
+#define ALLOCATOR_SMALL_MAX 512u
+#define ALLOCATOR_CLASS_TABLE { 16, 32, 48, 64, 80, 96, 112, 128, 144, 160, 176, 192, 208, 224, 304, 512 }
+#define ALLOCATOR_CLASS_INDEX { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 14, 14, 14, 14, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15 }
+#define ALLOCATOR_CLASS_PREFILL { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 0, 2, 5 }
@@ -0,0 +1,67 @@
+#ifndef TEST_COMMON_H
+#define TEST_COMMON_H
+
+/**
+ * @file test_common.h
+ * @brief Minimal assertion helpers shared by the allocator test executables.
+ *
+ * Each test executable registers its cases with TEST_RUN() and returns the
+ * number of failed checks from main(), which CTest reports as a failure.
+ */
+
+#include <stdio.h>
+#include "allocator.h"
+
+/** Number of failed checks in the current executable. */
+static int test_failures = 0;
+
+/**
+ * @def TEST_CHECK
+ * @brief Records a failure (with location) if @p cond is false.
+ */
+#define TEST_CHECK(cond)                                                    \
+    do {                                                                    \
+        if (!(cond)) {                                                      \
+            printf("  FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond);        \
+            ++test_failures;                                                \
+        }                                                                   \
+    } while (0)
+
+/**
+ * @def TEST_RUN
+ * @brief Runs a test case function and prints its name.
+ */
+#define TEST_RUN(fn)                                                        \
+    do {                                                                    \
+        printf("[ RUN  ] %s\n", #fn);                                       \
+        fn();                                                               \
+    } while (0)
+
+/**
+ * @def TEST_EXIT
+ * @brief Prints a summary and yields the process exit code.
+ */
+#define TEST_EXIT()                                                         \
+    (printf("%s (%d failed checks)\n", test_failures ? "FAILED" : "PASSED", \
+            test_failures), test_failures ? 1 : 0)
+
+/**
+ * @def TEST_POOL_DRAIN
+ * @brief Statement pool_is_free() runs first, e.g. to give back the blocks a
+ *        caching layer still holds. Define before including this header.
+ */
+#ifndef TEST_POOL_DRAIN
+#define TEST_POOL_DRAIN() ((void)0)
+#endif
+
+/** Everything was returned if the whole pool can be taken in one block. */
+static inline int pool_is_free(void) {
+    TEST_POOL_DRAIN();
+    allocator_trim();
+    int *all = allocate((int)ALLOCATOR_TOTAL_MEMORY);
+    if (!all) return 0;
+    deallocate(all);
+    return 1;
+}
+
+#endif /* TEST_COMMON_H */
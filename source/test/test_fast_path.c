@@ -0,0 +1,201 @@
+/**
+ * @file test_fast_path.c
+ * @brief Tests for the inline size-class fast path (allocate_fast() and
+ *        deallocate_fast()) and its interaction with the general allocator.
+ */
+
+#include <stdint.h>
+#include <string.h>
+#include "allocator.h"
+#include "test_common.h"
+
+static void test_size_classes(void) {
+    int *a = allocate_fast(1);
+    int *b = allocate_fast(16);
+    int *c = allocate_fast(17);
+    int *d = allocate_fast((int)ALLOCATOR_SMALL_MAX);
+    TEST_CHECK(a && b && c && d);
+
+    /* 1 and 16 bytes share the first class: consecutive blocks in one slab */
+    TEST_CHECK((uint8_t*)b - (uint8_t*)a == (intptr_t)ALLOCATOR_CLASS_GRANULE);
+    /* 17 bytes comes from a different slab */
+    uintptr_t slab_a = (uintptr_t)a & ~(uintptr_t)(ALLOCATOR_SLAB_BYTES - 1u);
+    uintptr_t slab_c = (uintptr_t)c & ~(uintptr_t)(ALLOCATOR_SLAB_BYTES - 1u);
+    TEST_CHECK(slab_a != slab_c);
+    TEST_CHECK(((uintptr_t)d % ALLOCATOR_CLASS_GRANULE) == 0);
+
+    deallocate_fast(a);
+    deallocate_fast(b);
+    deallocate_fast(c);
+    deallocate_fast(d);
+    allocator_trim();
+}
+
+static void test_invalid_sizes(void) {
+    TEST_CHECK(allocate_fast(0) == NULL);
+    TEST_CHECK(allocate_fast(-5) == NULL);
+}
+
+static void test_lifo_reuse(void) {
+    int *a = allocate_fast(48);
+    int *b = allocate_fast(48);
+    TEST_CHECK(a && b && a != b);
+    memset(a, 0x11, 48);
+    memset(b, 0x22, 48);
+
+    deallocate_fast(b);
+    int *c = allocate_fast(40);       /* same class (33..48 bytes) */
+    TEST_CHECK(c == b);
+    TEST_CHECK(((uint8_t*)a)[47] == 0x11);
+
+    deallocate_fast(a);
+    deallocate_fast(c);
+    allocator_trim();
+}
+
+static void test_mixed_release_paths(void) {
+    /* Small blocks can be freed with deallocate(), large ones with deallocate_fast() */
+    int *small = allocate_fast(24);
+    int *large = allocate_fast(1000);
+    TEST_CHECK(small && large);
+
+    deallocate(small);
+    TEST_CHECK(allocate_fast(24) == small);
+    deallocate_fast(small);
+
+    deallocate_fast(large);
+    int *again = allocate(1000);
+    TEST_CHECK(again == large);
+    deallocate(again);
+
+    deallocate_fast(NULL);
+    allocator_trim();
+}
+
+static void test_bad_frees(void) {
+    /* A second free, by either path, must not put the block on the list twice */
+    int *a = allocate_fast(48);
+    TEST_CHECK(a != NULL);
+    deallocate_fast(a);
+    deallocate_fast(a);
+    deallocate(a);
+    int *b = allocate_fast(48);
+    int *c = allocate_fast(48);
+    TEST_CHECK(b == a && c != a);
+
+    /* Interior pointers are ignored by deallocate_fast() too */
+    int *inner = (int*)(void*)((uint8_t*)b + ALLOCATOR_CLASS_GRANULE);
+    deallocate_fast(inner);
+    int *d = allocate_fast(48);
+    TEST_CHECK(d != inner);
+    deallocate_fast(d);
+
+    /* The slack after the last block of a slab is not a block */
+    enum { SIZE = 13 * ALLOCATOR_CLASS_GRANULE };
+    int *p = allocate_fast(SIZE);
+    TEST_CHECK(p != NULL);
+    uintptr_t in_slab = (uintptr_t)p & (ALLOCATOR_SLAB_BYTES - 1u);
+    uint32_t per_slab = (ALLOCATOR_SLAB_BYTES - ALLOCATOR_SLAB_COLOR_RESERVE) / SIZE;
+    uint8_t *tail = (uint8_t*)p + per_slab * SIZE;
+    if (in_slab + per_slab * SIZE < ALLOCATOR_SLAB_BYTES) {
+        deallocate_fast((int*)(void*)tail);
+        deallocate((int*)(void*)tail);
+        int *q = allocate_fast(SIZE);
+        TEST_CHECK(q != (int*)(void*)tail);
+        deallocate_fast(q);
+    }
+
+    deallocate_fast(p);
+    deallocate_fast(b);
+    deallocate_fast(c);
+    allocator_trim();
+    int *all = allocate((int)ALLOCATOR_TOTAL_MEMORY);
+    TEST_CHECK(all != NULL);
+    deallocate(all);
+}
+
+static void test_trim_restores_pool(void) {
+    int *blocks[64];
+    for (int i = 0; i < 64; ++i) {
+        blocks[i] = allocate_fast(8 + (i % 8) * 32);
+        TEST_CHECK(blocks[i] != NULL);
+    }
+    /* Interior pointers of a slab are not block starts for odd offsets */
+    deallocate((int*)(void*)((uint8_t*)blocks[0] + 4));
+    for (int i = 0; i < 64; ++i) deallocate_fast(blocks[i]);
+
+    /* The entire pool is only available once every slab has been released */
+    int *all = allocate((int)ALLOCATOR_TOTAL_MEMORY);
+    TEST_CHECK(all != NULL);
+    TEST_CHECK(allocate_fast(16) == NULL);
+    deallocate(all);
+}
+
+static void test_exhaustion_trims(void) {
+    /* Fill the pool with slabs of one class ... */
+    static int *blocks[8192];
+    int n = 0;
+    while (n < 8192 && (blocks[n] = allocate_fast(128)) != NULL) ++n;
+    TEST_CHECK(n > 0 && n < 8192);
+    TEST_CHECK(allocate(4096) == NULL);
+
+    /* ... then free everything: allocate() must reclaim the empty slabs */
+    for (int i = 0; i < n; ++i) deallocate_fast(blocks[i]);
+    int *big = allocate(64 * 1024);
+    TEST_CHECK(big != NULL);
+    deallocate(big);
+}
+
+static void test_slab_coloring(void) {
+#if ALLOCATOR_SLAB_COLOR_STEP > 0
+    /* 208-byte blocks fill 832 bytes of a slab, leaving room for 4 colors */
+    enum { SIZE = 13 * ALLOCATOR_CLASS_GRANULE, SLABS = 6 };
+    const uint32_t per_slab = (ALLOCATOR_SLAB_BYTES - ALLOCATOR_SLAB_COLOR_RESERVE) / SIZE;
+    const uint32_t slack = ALLOCATOR_SLAB_BYTES - per_slab * SIZE;
+    int *blocks[SLABS * 8];
+    uint32_t n = 0, slabs = 0;
+    uint32_t expected = 0, colors_seen = 0;
+
+    allocator_trim();
+    while (slabs < SLABS && n < SLABS * 8u) {
+        int *p = allocate_fast(SIZE);
+        TEST_CHECK(p != NULL);
+        if (!p) break;
+        uintptr_t in_slab = (uintptr_t)p & (ALLOCATOR_SLAB_BYTES - 1u);
+        if (n == 0 || ((uintptr_t)p ^ (uintptr_t)blocks[n - 1]) >= ALLOCATOR_SLAB_BYTES) {
+            /* First block of a new slab starts at the next color */
+            if (n != 0) TEST_CHECK(in_slab == expected);
+            TEST_CHECK(in_slab <= slack && in_slab % ALLOCATOR_SLAB_COLOR_STEP == 0);
+            colors_seen |= 1u << (in_slab / ALLOCATOR_SLAB_COLOR_STEP);
+            expected = (uint32_t)in_slab + ALLOCATOR_SLAB_COLOR_STEP;
+            if (expected > slack) expected = 0;
+            ++slabs;
+        }
+        blocks[n++] = p;
+    }
+
+    TEST_CHECK(colors_seen == (1u << (slack / ALLOCATOR_SLAB_COLOR_STEP + 1u)) - 1u);
+
+    /* Block starts are validated against the slab's color */
+    uint8_t *slab1 = (uint8_t*)((uintptr_t)blocks[per_slab] & ~(uintptr_t)(ALLOCATOR_SLAB_BYTES - 1u));
+    if (slack >= ALLOCATOR_SLAB_COLOR_STEP) deallocate((int*)(void*)slab1);
+    for (uint32_t i = 0; i < n; ++i) deallocate_fast(blocks[i]);
+    allocator_trim();
+
+    int *all = allocate((int)ALLOCATOR_TOTAL_MEMORY);
+    TEST_CHECK(all != NULL);
+    deallocate(all);
+#endif
+}
+
+int main(void) {
+    TEST_RUN(test_size_classes);
+    TEST_RUN(test_invalid_sizes);
+    TEST_RUN(test_lifo_reuse);
+    TEST_RUN(test_mixed_release_paths);
+    TEST_RUN(test_bad_frees);
+    TEST_RUN(test_trim_restores_pool);
+    TEST_RUN(test_exhaustion_trims);
+    TEST_RUN(test_slab_coloring);
+    return TEST_EXIT();
+}
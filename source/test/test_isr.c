@@ -0,0 +1,103 @@
+/**
+ * @file test_isr.c
+ * @brief Tests for the interrupt-safe buffer pools (allocator_isr.h).
+ *
+ * Hosted builds have no interrupts, so the handler side is exercised by
+ * calling isr_alloc()/isr_free() directly.
+ */
+
+#include <stdint.h>
+#include <string.h>
+#include "allocator.h"
+#include "allocator_isr.h"
+#include "test_common.h"
+
+static void test_init_and_exhaust(void) {
+    isr_pool_t pool;
+    TEST_CHECK(isr_pool_init(&pool, 64, 8, 3) == 0);
+    TEST_CHECK(pool.count == 8);
+    TEST_CHECK(!isr_pool_needs_refill(&pool));
+
+    int *bufs[8];
+    for (int i = 0; i < 8; ++i) {
+        bufs[i] = isr_alloc(&pool);
+        TEST_CHECK(bufs[i] != NULL);
+        memset(bufs[i], i, 64);
+    }
+    TEST_CHECK(isr_pool_needs_refill(&pool));
+    TEST_CHECK(isr_alloc(&pool) == NULL);
+    TEST_CHECK(pool.misses == 1);
+
+    for (int i = 0; i < 8; ++i) isr_free(&pool, bufs[i]);
+    TEST_CHECK(pool.count == 8);
+    isr_pool_drain(&pool);
+    TEST_CHECK(pool.count == 0);
+    allocator_trim();
+}
+
+static void test_low_water_and_refill(void) {
+    isr_pool_t pool;
+    TEST_CHECK(isr_pool_init(&pool, 200, 6, 2) == 0);
+
+    int *a = isr_alloc(&pool);
+    int *b = isr_alloc(&pool);
+    int *c = isr_alloc(&pool);
+    TEST_CHECK(!isr_pool_needs_refill(&pool));   /* 3 left, low water 2 */
+    int *d = isr_alloc(&pool);
+    int *e = isr_alloc(&pool);
+    TEST_CHECK(isr_pool_needs_refill(&pool));    /* 1 left */
+
+    /* Thread context tops the pool up; consumed buffers go back to the allocator */
+    TEST_CHECK(isr_pool_refill(&pool) == 5);
+    TEST_CHECK(pool.count == 6);
+    TEST_CHECK(!isr_pool_needs_refill(&pool));
+    deallocate(a);
+    deallocate(b);
+    deallocate_fast(c);
+
+    /* Returning more than the target is trimmed at the next refill */
+    isr_free(&pool, d);
+    isr_free(&pool, e);
+    TEST_CHECK(pool.count == 8);
+    TEST_CHECK(isr_pool_refill(&pool) == 0);
+    TEST_CHECK(pool.count == 6);
+
+    isr_pool_drain(&pool);
+    allocator_trim();
+}
+
+static void test_large_blocks(void) {
+    /* Buffers above the size-class limit come from allocate() */
+    isr_pool_t pool;
+    TEST_CHECK(isr_pool_init(&pool, 1500, 4, 1) == 0);
+    int *a = isr_alloc(&pool);
+    TEST_CHECK(a != NULL && ((uintptr_t)a % sizeof(void*)) == 0);
+    memset(a, 0x5A, 1500);
+    isr_free(&pool, a);
+    isr_pool_drain(&pool);
+
+    /* Everything went back: the whole pool is available again */
+    int *all = allocate((int)ALLOCATOR_TOTAL_MEMORY);
+    TEST_CHECK(all != NULL);
+    deallocate(all);
+}
+
+static void test_stock_failure(void) {
+    isr_pool_t pool;
+    TEST_CHECK(isr_pool_init(NULL, 64, 4, 1) == -1);
+    TEST_CHECK(isr_pool_init(&pool, 0, 4, 1) == -1);
+
+    /* Asking for more than the pool holds keeps what could be allocated */
+    TEST_CHECK(isr_pool_init(&pool, 40000, 4, 1) == -1);
+    TEST_CHECK(pool.count == 2);
+    TEST_CHECK(isr_pool_needs_refill(&pool));
+    isr_pool_drain(&pool);
+}
+
+int main(void) {
+    TEST_RUN(test_init_and_exhaust);
+    TEST_RUN(test_low_water_and_refill);
+    TEST_RUN(test_large_blocks);
+    TEST_RUN(test_stock_failure);
+    return TEST_EXIT();
+}
@@ -0,0 +1,231 @@
+/**
+ * @file test_lock_pthread.c
+ * @brief Concurrency test of the lock hooks on the host pthread port.
+ *
+ * Several threads allocate and free through both the size-class fast path
+ * (or per-thread magazine caches) and the general allocator while checking that no block is handed out
+ * twice: every thread fills its blocks with its own pattern and verifies the
+ * pattern is intact before freeing. A producer/consumer case passes blocks
+ * between two thread caches, so every free goes through a remote-free queue.
+ * Built with ALLOCATOR_ENABLE_LOCKS=1.
+ */
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <string.h>
+#include "allocator.h"
+#include "allocator_lock.h"
+#include "allocator_magazine.h"
+#include "allocator_tcache.h"
+#include "test_common.h"
+
+#define THREADS     4
+#define ITERATIONS  20000
+#define SLOTS       24
+
+/** Per-thread result: number of corrupted blocks seen. */
+static int corrupted[THREADS];
+
+/** Workers go through per-thread magazine caches instead of the fast path. */
+static int use_magazines;
+
+static uint32_t rng(uint32_t *state) {
+    uint32_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return *state = x;
+}
+
+static int check_and_free(mag_cache_t *cc, int *p, int size, uint8_t pattern) {
+    int bad = 0;
+    const uint8_t *b = (const uint8_t*)p;
+    for (int i = 0; i < size; ++i) {
+        if (b[i] != pattern) {
+            bad = 1;
+            break;
+        }
+    }
+    if (use_magazines) mag_free(cc, p);
+    else deallocate_fast(p);
+    return bad;
+}
+
+static void *worker(void *arg) {
+    int id = (int)(intptr_t)arg;
+    uint8_t pattern = (uint8_t)(0x10 + id);
+    uint32_t state = 0xC0FFEEu + (uint32_t)id * 7919u;
+    int *slots[SLOTS] = { 0 };
+    int sizes[SLOTS] = { 0 };
+    mag_cache_t cc;
+    mag_cache_init(&cc);
+
+    for (int i = 0; i < ITERATIONS; ++i) {
+        uint32_t s = rng(&state) % SLOTS;
+        if (slots[s]) corrupted[id] += check_and_free(&cc, slots[s], sizes[s], pattern);
+
+        /* Mostly small blocks, sometimes a large one from the block list */
+        int size = (rng(&state) % 8 == 0) ? 300 + (int)(rng(&state) % 700)
+                                          : 1 + (int)(rng(&state) % ALLOCATOR_SMALL_MAX);
+        int *p = use_magazines ? mag_alloc(&cc, size) : allocate_fast(size);
+        slots[s] = p;
+        sizes[s] = size;
+        if (p) memset(p, pattern, (size_t)size);
+    }
+    for (int s = 0; s < SLOTS; ++s) {
+        if (slots[s]) corrupted[id] += check_and_free(&cc, slots[s], sizes[s], pattern);
+    }
+    mag_cache_flush(&cc);
+    return NULL;
+}
+
+static void run_threads(const allocator_lock_ops_t *ops) {
+    pthread_t threads[THREADS];
+    allocator_set_lock_ops(ops);
+    memset(corrupted, 0, sizeof corrupted);
+    for (int i = 0; i < THREADS; ++i) {
+        TEST_CHECK(pthread_create(&threads[i], NULL, worker, (void*)(intptr_t)i) == 0);
+    }
+    for (int i = 0; i < THREADS; ++i) pthread_join(threads[i], NULL);
+    for (int i = 0; i < THREADS; ++i) TEST_CHECK(corrupted[i] == 0);
+
+    /* Every block went back: trimming must leave the pool completely free */
+    mag_depot_reap();
+    allocator_trim();
+    int *all = allocate((int)ALLOCATOR_TOTAL_MEMORY);
+    TEST_CHECK(all != NULL);
+    deallocate(all);
+    allocator_set_lock_ops(NULL);
+}
+
+static void test_pthread_per_class(void) {
+    run_threads(allocator_lock_ops_pthread());
+}
+
+static void test_pthread_global(void) {
+    run_threads(allocator_lock_ops_pthread_global());
+}
+
+static void test_spin(void) {
+    run_threads(allocator_lock_ops_spin());
+}
+
+static void test_magazines(void) {
+    use_magazines = 1;
+    run_threads(allocator_lock_ops_pthread());
+    use_magazines = 0;
+}
+
+static void test_irq_single_thread(void) {
+    /* Interrupt masking is a no-op on the host; only the nesting is checked */
+    allocator_set_lock_ops(allocator_lock_ops_irq());
+    int *a = allocate_fast(32);
+    int *b = allocate(2000);
+    TEST_CHECK(a && b);
+    deallocate_fast(a);
+    deallocate(b);
+    allocator_trim();
+    allocator_set_lock_ops(NULL);
+}
+
+/* ---------------------------------------------------------------------------- */
+/*                         Producer/consumer, thread caches                     */
+/* ---------------------------------------------------------------------------- */
+
+#define RING_SIZE   128u
+#define MESSAGES    50000u
+
+/** Single-producer/single-consumer ring of block pointers. */
+static int *ring[RING_SIZE];
+static atomic_uint ring_head, ring_tail;
+
+static int consumer_errors;
+static uint32_t consumer_remote_sent;
+
+static void ring_push(int *p) {
+    unsigned head = atomic_load_explicit(&ring_head, memory_order_relaxed);
+    while (head - atomic_load_explicit(&ring_tail, memory_order_acquire) == RING_SIZE) sched_yield();
+    ring[head % RING_SIZE] = p;
+    atomic_store_explicit(&ring_head, head + 1u, memory_order_release);
+}
+
+static int *ring_pop(void) {
+    unsigned tail = atomic_load_explicit(&ring_tail, memory_order_relaxed);
+    while (atomic_load_explicit(&ring_head, memory_order_acquire) == tail) sched_yield();
+    int *p = ring[tail % RING_SIZE];
+    atomic_store_explicit(&ring_tail, tail + 1u, memory_order_release);
+    return p;
+}
+
+static void *producer(void *arg) {
+    allocator_tcache_t *tc = arg;
+    for (uint32_t i = 0; i < MESSAGES; ++i) {
+        int size = 16 + (int)(i % 7u) * 32;
+        int *p = tcache_alloc(tc, size);
+        if (!p) {
+            i--;
+            sched_yield();
+            continue;
+        }
+        p[0] = (int)i;
+        memset(&p[1], (int)(i & 0xFFu), (size_t)size - sizeof(int));
+        ring_push(p);
+    }
+    ring_push(NULL);
+    return NULL;
+}
+
+static void *consumer(void *arg) {
+    allocator_tcache_t tc;
+    (void)arg;
+    if (tcache_init(&tc) != 0) {
+        consumer_errors = 1;
+        return NULL;
+    }
+    for (uint32_t expected = 0; ; ++expected) {
+        int *p = ring_pop();
+        if (!p) break;
+        if (p[0] != (int)expected || ((uint8_t*)&p[1])[0] != (uint8_t)(expected & 0xFFu)) {
+            ++consumer_errors;
+        }
+        tcache_free(&tc, p);
+    }
+    consumer_remote_sent = tc.remote_sent;
+    tcache_destroy(&tc);
+    return NULL;
+}
+
+static void test_tcache_producer_consumer(void) {
+    allocator_tcache_t tc;
+    pthread_t prod, cons;
+    allocator_set_lock_ops(allocator_lock_ops_pthread());
+    TEST_CHECK(tcache_init(&tc) == 0);
+
+    TEST_CHECK(pthread_create(&cons, NULL, consumer, NULL) == 0);
+    TEST_CHECK(pthread_create(&prod, NULL, producer, &tc) == 0);
+    pthread_join(prod, NULL);
+    pthread_join(cons, NULL);
+
+    TEST_CHECK(consumer_errors == 0);
+    TEST_CHECK(consumer_remote_sent == MESSAGES);
+    TEST_CHECK(tc.remote_received > 0);
+
+    tcache_destroy(&tc);
+    allocator_trim();
+    int *all = allocate((int)ALLOCATOR_TOTAL_MEMORY);
+    TEST_CHECK(all != NULL);
+    deallocate(all);
+    allocator_set_lock_ops(NULL);
+}
+
+int main(void) {
+    TEST_RUN(test_pthread_per_class);
+    TEST_RUN(test_pthread_global);
+    TEST_RUN(test_spin);
+    TEST_RUN(test_magazines);
+    TEST_RUN(test_irq_single_thread);
+    TEST_RUN(test_tcache_producer_consumer);
+    return TEST_EXIT();
+}
@@ -0,0 +1,145 @@
+/**
+ * @file test_magazine.c
+ * @brief Tests of the magazine caches and the depot.
+ *
+ * Two caches used from one thread stand in for two cores. Built with
+ * ALLOCATOR_ENABLE_LOCKS=1 so that a stub lock implementation can simulate
+ * depot contention.
+ */
+
+#include <stdint.h>
+#include "allocator.h"
+#include "allocator_lock.h"
+#include "allocator_magazine.h"
+
+/* Magazines in the depot hold blocks; give them back before checking */
+#define TEST_POOL_DRAIN() mag_depot_reap()
+#include "test_common.h"
+
+#define BLOCK  48
+#define CLS    allocator_size_class(BLOCK)
+
+static void test_magazine_round_trip(void) {
+    mag_cache_t cc;
+    mag_cache_init(&cc);
+
+    int *p = mag_alloc(&cc, BLOCK);
+    TEST_CHECK(p != NULL);
+    TEST_CHECK(cc.slab_allocs == 1);
+    mag_free(&cc, p);
+    TEST_CHECK(cc.loaded[CLS] != NULL && cc.loaded[CLS]->rounds == 1);
+    TEST_CHECK(mag_alloc(&cc, BLOCK) == p);
+    TEST_CHECK(cc.slab_allocs == 1);
+    mag_free(&cc, p);
+
+    int *big = mag_alloc(&cc, 1000);
+    TEST_CHECK(big != NULL);
+    mag_free(&cc, big);
+    mag_free(&cc, NULL);
+
+    mag_cache_flush(&cc);
+    TEST_CHECK(pool_is_free());
+}
+
+static void test_depot_balances_caches(void) {
+    enum { N = 4 * ALLOCATOR_MAGAZINE_SIZE };
+    mag_cache_t producer, consumer;
+    int *blocks[N];
+    mag_cache_init(&producer);
+    mag_cache_init(&consumer);
+
+    mag_depot_stats_t before;
+    mag_depot_get_stats(CLS, &before);
+
+    /* One core frees everything another core allocated... */
+    for (uint32_t i = 0; i < N; ++i) blocks[i] = mag_alloc(&producer, BLOCK);
+    for (uint32_t i = 0; i < N; ++i) mag_free(&consumer, blocks[i]);
+
+    mag_depot_stats_t mid;
+    mag_depot_get_stats(CLS, &mid);
+    TEST_CHECK(mid.full >= 2u);
+
+    /* ...and gets its blocks back as full magazines, not from the slabs */
+    uint32_t slab_before = producer.slab_allocs;
+    for (uint32_t i = 0; i < 2u * ALLOCATOR_MAGAZINE_SIZE; ++i) {
+        blocks[i] = mag_alloc(&producer, BLOCK);
+        TEST_CHECK(blocks[i] != NULL);
+    }
+    TEST_CHECK(producer.slab_allocs == slab_before);
+    TEST_CHECK(producer.depot_exchanges == 2);
+
+    mag_depot_stats_t after;
+    mag_depot_get_stats(CLS, &after);
+    TEST_CHECK(after.full_gets - before.full_gets == 2u);
+    TEST_CHECK(after.full == mid.full - 2u);
+    TEST_CHECK(producer.previous[CLS] != NULL && producer.previous[CLS]->rounds == 0);
+
+    for (uint32_t i = 0; i < 2u * ALLOCATOR_MAGAZINE_SIZE; ++i) mag_free(&producer, blocks[i]);
+    mag_cache_flush(&producer);
+    mag_cache_flush(&consumer);
+    TEST_CHECK(pool_is_free());
+}
+
+static void test_set_size(void) {
+    mag_cache_t cc;
+    mag_cache_init(&cc);
+
+    mag_depot_set_size(CLS, 3);
+    int *a[4];
+    for (uint32_t i = 0; i < 4u; ++i) a[i] = mag_alloc(&cc, BLOCK);
+    for (uint32_t i = 0; i < 4u; ++i) mag_free(&cc, a[i]);
+    /* First magazine took three, the fourth free needed a second magazine */
+    TEST_CHECK(cc.previous[CLS] != NULL && cc.previous[CLS]->rounds == 3);
+    TEST_CHECK(cc.loaded[CLS]->capacity == 3 && cc.loaded[CLS]->rounds == 1);
+
+    mag_depot_stats_t st;
+    mag_depot_set_size(CLS, 0);
+    mag_depot_get_stats(CLS, &st);
+    TEST_CHECK(st.magazine_size == 1u);
+    mag_depot_set_size(CLS, 100000u);
+    mag_depot_get_stats(CLS, &st);
+    TEST_CHECK(st.magazine_size == ALLOCATOR_MAGAZINE_MAX);
+    mag_depot_set_size(CLS, ALLOCATOR_MAGAZINE_SIZE);
+
+    mag_cache_flush(&cc);
+    TEST_CHECK(pool_is_free());
+}
+
+/* Lock stub whose trylock always fails: every depot access is "contended" */
+static void stub_lock(void *ctx, uint32_t id) { (void)ctx; (void)id; }
+static int stub_trylock(void *ctx, uint32_t id) { (void)ctx; (void)id; return 0; }
+static const allocator_lock_ops_t contended_ops = { stub_lock, stub_lock, NULL, stub_trylock };
+
+static void test_contention_grows_magazines(void) {
+    mag_cache_t cc;
+    mag_cache_init(&cc);
+    allocator_set_lock_ops(&contended_ops);
+
+    mag_depot_stats_t before, after;
+    mag_depot_get_stats(CLS, &before);
+    for (uint32_t i = 0; i < ALLOCATOR_MAGAZINE_GROW_AFTER; ++i) {
+        mag_depot_reap();                  /* no-op on the stats we check */
+        int *p = mag_alloc(&cc, BLOCK);    /* empty cache: visits the depot */
+        mag_free(&cc, p);
+        mag_cache_flush(&cc);              /* visits the depot again */
+    }
+    mag_depot_get_stats(CLS, &after);
+    TEST_CHECK(after.contended > before.contended);
+    TEST_CHECK(after.accesses - before.accesses == after.contended - before.contended);
+#if ALLOCATOR_MAGAZINE_GROW_AFTER > 0
+    TEST_CHECK(after.resizes >= 1u);
+    TEST_CHECK(after.magazine_size > before.magazine_size);
+#endif
+
+    allocator_set_lock_ops(NULL);
+    mag_depot_set_size(CLS, ALLOCATOR_MAGAZINE_SIZE);
+    TEST_CHECK(pool_is_free());
+}
+
+int main(void) {
+    TEST_RUN(test_magazine_round_trip);
+    TEST_RUN(test_depot_balances_caches);
+    TEST_RUN(test_set_size);
+    TEST_RUN(test_contention_grows_magazines);
+    return TEST_EXIT();
+}
@@ -0,0 +1,116 @@
+/**
+ * @file test_mbuf.c
+ * @brief Tests of reference-counted message buffers.
+ */
+
+#include <stdint.h>
+#include <string.h>
+#include "allocator.h"
+#include "allocator_mbuf.h"
+#include "test_common.h"
+
+static void test_alloc_release(void) {
+    mbuf_t *b = mbuf_alloc(16, 100);
+    TEST_CHECK(b != NULL);
+    TEST_CHECK(mbuf_len(b) == 100);
+    TEST_CHECK(!mbuf_is_shared(b));
+    memset(mbuf_data(b), 0xAB, mbuf_len(b));
+
+    /* Large buffers take the general path */
+    mbuf_t *big = mbuf_alloc(0, 4000);
+    TEST_CHECK(big != NULL);
+    mbuf_release(big);
+
+    TEST_CHECK(mbuf_alloc(0, 0xFFFFFFFFu) == NULL);
+    mbuf_release(NULL);
+    mbuf_release(b);
+    TEST_CHECK(pool_is_free());
+}
+
+static void test_clone_shares_storage(void) {
+    mbuf_t *b = mbuf_alloc(0, 64);
+    for (uint32_t i = 0; i < 64; ++i) mbuf_data(b)[i] = (uint8_t)i;
+
+    mbuf_t *r = mbuf_ref(b);
+    TEST_CHECK(r == b && mbuf_is_shared(b));
+
+    mbuf_t *c = mbuf_clone(b);
+    TEST_CHECK(c != NULL && c != b);
+    TEST_CHECK(mbuf_data(c) == mbuf_data(b) && mbuf_len(c) == 64);
+
+    /* The storage survives the owner's references while the clone lives */
+    mbuf_release(r);
+    mbuf_release(b);
+    TEST_CHECK(!mbuf_is_shared(c));
+    TEST_CHECK(mbuf_data(c)[63] == 63);
+    TEST_CHECK(!pool_is_free());
+
+    mbuf_release(c);
+    TEST_CHECK(pool_is_free());
+}
+
+static void test_slice(void) {
+    mbuf_t *b = mbuf_alloc(0, 64);
+    for (uint32_t i = 0; i < 64; ++i) mbuf_data(b)[i] = (uint8_t)i;
+
+    mbuf_t *s = mbuf_slice(b, 10, 20);
+    TEST_CHECK(s != NULL && mbuf_len(s) == 20 && mbuf_data(s)[0] == 10);
+    TEST_CHECK(mbuf_slice(b, 60, 5) == NULL);
+    TEST_CHECK(mbuf_slice(b, 65, 0) == NULL);
+
+    /* Slices of slices are relative to their window */
+    mbuf_t *ss = mbuf_slice(s, 5, 15);
+    TEST_CHECK(ss != NULL && mbuf_data(ss)[0] == 15 && mbuf_data(ss)[14] == 29);
+    TEST_CHECK(ss->owner == b);
+
+    /* A slice cannot push back over the payload in front of it */
+    mbuf_t *tail = mbuf_slice(b, 40, 8);
+    TEST_CHECK(tail != NULL && mbuf_push(tail, 40) == NULL && mbuf_push(tail, 1) == NULL);
+    TEST_CHECK(mbuf_pull(tail, 4) != NULL && mbuf_push(tail, 4) == mbuf_data(b) + 40);
+    TEST_CHECK(mbuf_len(tail) == 8);
+    mbuf_release(tail);
+
+    mbuf_release(b);
+    mbuf_release(s);
+    TEST_CHECK(mbuf_data(ss)[0] == 15);
+    mbuf_release(ss);
+    TEST_CHECK(pool_is_free());
+}
+
+/** A frame passed down and up a stack of layers without copying. */
+static void test_layers(void) {
+    static const char payload[] = "application data";
+    const uint32_t hdr = 8;
+
+    /* Transmit: each layer prepends its header into the headroom */
+    mbuf_t *b = mbuf_alloc(2u * hdr, (uint32_t)sizeof payload);
+    memcpy(mbuf_data(b), payload, sizeof payload);
+    uint8_t *p = mbuf_push(b, hdr);
+    TEST_CHECK(p != NULL);
+    memset(p, 'T', hdr);
+    p = mbuf_push(b, hdr);
+    TEST_CHECK(p != NULL);
+    memset(p, 'N', hdr);
+    TEST_CHECK(mbuf_push(b, 1) == NULL);
+    TEST_CHECK(mbuf_len(b) == 2u * hdr + sizeof payload);
+
+    /* Receive: a retransmit queue keeps the frame, the stack strips headers */
+    mbuf_t *rx = mbuf_clone(b);
+    TEST_CHECK(mbuf_pull(rx, hdr)[0] == 'T');
+    TEST_CHECK(memcmp(mbuf_pull(rx, hdr), payload, sizeof payload) == 0);
+    mbuf_trim(rx, 11);
+    TEST_CHECK(mbuf_len(rx) == 11 && mbuf_pull(rx, 12) == NULL);
+    TEST_CHECK(mbuf_data(b)[0] == 'N' && mbuf_len(b) == 2u * hdr + sizeof payload);
+
+    mbuf_release(rx);
+    mbuf_release(b);
+    TEST_CHECK(pool_is_free());
+}
+
+int main(void) {
+    TEST_RUN(test_alloc_release);
+    TEST_RUN(test_clone_shares_storage);
+    TEST_RUN(test_slice);
+    TEST_RUN(test_layers);
+    return TEST_EXIT();
+}
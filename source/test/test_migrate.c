@@ -0,0 +1,117 @@
+/**
+ * @file test_migrate.c
+ * @brief Tests of hot/cold migration of relocatable blocks.
+ *
+ * Built with a fast tier that holds four of the test blocks.
+ */
+
+#include <stdint.h>
+#include <string.h>
+#include "allocator.h"
+#include "allocator_migrate.h"
+#include "test_common.h"
+
+#define BLOCK   512
+#define BLOCKS  8
+
+static mig_handle_t h[BLOCKS];
+
+static void fill(void) {
+    for (int i = 0; i < BLOCKS; ++i) {
+        h[i] = mig_alloc(BLOCK, ALLOCATOR_TIER_HOT);
+        TEST_CHECK(h[i] != 0);
+        memset(mig_ptr(h[i]), 'a' + i, BLOCK);
+    }
+}
+
+static int contents_ok(void) {
+    for (int i = 0; i < BLOCKS; ++i) {
+        const uint8_t *p = (const uint8_t*)mig_ptr(h[i]);
+        if (p[0] != 'a' + i || p[BLOCK - 1] != 'a' + i) return 0;
+    }
+    return 1;
+}
+
+static void release(void) {
+    for (int i = 0; i < BLOCKS; ++i) mig_free(h[i]);
+}
+
+static void touch(int i, int n) {
+    for (int k = 0; k < n; ++k) (void)mig_get(h[i]);
+}
+
+static void test_working_set_moves_to_fast(void) {
+    fill();
+    /* Allocation order put blocks 0..3 in the fast tier */
+    for (int i = 0; i < BLOCKS; ++i) TEST_CHECK(mig_is_fast(h[i]) == (i < 4));
+
+    /* The workload actually uses blocks 4..7 */
+    for (int i = 4; i < BLOCKS; ++i) touch(i, 10 + i);
+    void *before = mig_ptr(h[7]);
+    uint32_t moved = mig_rebalance(32);
+    TEST_CHECK(moved == 8);
+    for (int i = 0; i < BLOCKS; ++i) TEST_CHECK(mig_is_fast(h[i]) == (i >= 4));
+    TEST_CHECK(mig_ptr(h[7]) != before);
+    TEST_CHECK(contents_ok());
+
+    mig_stats_t st;
+    mig_get_stats(&st);
+    TEST_CHECK(st.promotions == 4 && st.demotions == 4);
+    TEST_CHECK(st.bytes_moved == 8u * BLOCK);
+
+    /* Stable working set: nothing moves */
+    for (int i = 4; i < BLOCKS; ++i) touch(i, 10);
+    TEST_CHECK(mig_rebalance(32) == 0);
+    release();
+}
+
+static void test_pinned_and_budget(void) {
+    fill();
+    for (int i = 4; i < BLOCKS; ++i) touch(i, 20);
+
+    /* A pinned fast block stays even though it is cold */
+    mig_pin(h[0]);
+    void *pinned = mig_ptr(h[0]);
+    TEST_CHECK(mig_rebalance(2) <= 2);
+    TEST_CHECK(mig_rebalance(32) > 0);
+    TEST_CHECK(mig_ptr(h[0]) == pinned && mig_is_fast(h[0]));
+    mig_unpin(h[0]);
+
+    int fast = 0;
+    for (int i = 0; i < BLOCKS; ++i) fast += mig_is_fast(h[i]);
+    TEST_CHECK(fast == 4);
+    TEST_CHECK(contents_ok());
+
+    /* Heat decays: once block 0 is the one in use, it moves in */
+    for (int pass = 0; pass < 8; ++pass) {
+        touch(0, 50);
+        mig_rebalance(32);
+    }
+    TEST_CHECK(mig_is_fast(h[0]));
+    TEST_CHECK(contents_ok());
+    release();
+}
+
+static void test_handle_limits(void) {
+    TEST_CHECK(mig_alloc(0, ALLOCATOR_TIER_COLD) == 0);
+    mig_handle_t all[ALLOCATOR_MIGRATE_MAX_HANDLES];
+    for (uint32_t i = 0; i < ALLOCATOR_MIGRATE_MAX_HANDLES; ++i) {
+        all[i] = mig_alloc(16, ALLOCATOR_TIER_COLD);
+        TEST_CHECK(all[i] != 0);
+    }
+    TEST_CHECK(mig_alloc(16, ALLOCATOR_TIER_COLD) == 0);
+    for (uint32_t i = 0; i < ALLOCATOR_MIGRATE_MAX_HANDLES; ++i) mig_free(all[i]);
+    mig_free(0);
+
+    allocator_trim();
+    int *whole = allocate((int)ALLOCATOR_TOTAL_MEMORY);
+    TEST_CHECK(whole != NULL);
+    deallocate(whole);
+}
+
+int main(void) {
+    TEST_RUN(test_working_set_moves_to_fast);
+    TEST_RUN(test_pinned_and_budget);
+    TEST_RUN(test_handle_limits);
+    return TEST_EXIT();
+}
@@ -0,0 +1,249 @@
+/**
+ * @file test_shm.c
+ * @brief Tests of allocation arenas in POSIX shared memory.
+ *
+ * The last case forks: a producer process allocates message buffers and
+ * passes their handles through a ring stored in the arena, and the consumer
+ * reads and frees them in place.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <fcntl.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "allocator_config.h"
+#include "allocator_shm.h"
+#include "test_common.h"
+
+#define ARENA_SIZE   (64u * 1024u)
+#define ARENA_NODES  128u
+
+/** Arena name, unique per test process. */
+static char arena_name[64];
+
+static int create_arena(shm_arena_t *a) {
+    shm_arena_unlink(arena_name);
+    return shm_arena_create(a, arena_name, ARENA_SIZE, ARENA_NODES);
+}
+
+static void destroy_arena(shm_arena_t *a) {
+    shm_arena_close(a);
+    shm_arena_unlink(arena_name);
+}
+
+static void test_alloc_free(void) {
+    shm_arena_t a;
+    TEST_CHECK(create_arena(&a) == 0);
+
+    shm_handle_t h1 = shm_alloc(&a, 100);
+    shm_handle_t h2 = shm_alloc(&a, 1);
+    TEST_CHECK(h1 != 0 && h2 != 0 && h1 != h2);
+    TEST_CHECK(((uintptr_t)shm_ptr(&a, h1) & (ALLOCATOR_CACHE_LINE - 1u)) == 0);
+    TEST_CHECK(((uintptr_t)shm_ptr(&a, h2) & (ALLOCATOR_CACHE_LINE - 1u)) == 0);
+    TEST_CHECK(shm_handle(&a, shm_ptr(&a, h1)) == h1);
+    TEST_CHECK(shm_ptr(&a, 0) == NULL && shm_handle(&a, NULL) == 0);
+    TEST_CHECK(shm_alloc(&a, 0) == 0);
+
+    shm_arena_stats_t st;
+    shm_arena_get_stats(&a, &st);
+    TEST_CHECK(st.blocks == 2 && st.allocs == 2);
+    TEST_CHECK(st.bytes_in_use == 128u + ALLOCATOR_CACHE_LINE);
+
+    /* The freed gap is reused first fit; unknown handles are ignored */
+    shm_free(&a, h1);
+    shm_free(&a, h1);
+    shm_free(&a, h2 + 8u);
+    TEST_CHECK(shm_alloc(&a, 64) == h1);
+
+    shm_arena_get_stats(&a, &st);
+    TEST_CHECK(st.blocks == 2 && st.frees == 1);
+    destroy_arena(&a);
+}
+
+static void test_exhaustion(void) {
+    shm_arena_t a;
+    TEST_CHECK(create_arena(&a) == 0);
+
+    /* Node limit: more blocks than nodes fail even with space left */
+    shm_handle_t h[ARENA_NODES];
+    for (uint32_t i = 0; i < ARENA_NODES; ++i) h[i] = shm_alloc(&a, 1);
+    TEST_CHECK(h[ARENA_NODES - 1u] != 0);
+    TEST_CHECK(shm_alloc(&a, 1) == 0);
+    for (uint32_t i = 0; i < ARENA_NODES; ++i) shm_free(&a, h[i]);
+
+    /* Space limit */
+    TEST_CHECK(shm_alloc(&a, ARENA_SIZE) == 0);
+    shm_handle_t big = shm_alloc(&a, ARENA_SIZE / 2u);
+    TEST_CHECK(big != 0);
+    TEST_CHECK(shm_alloc(&a, ARENA_SIZE / 2u) == 0);
+    shm_free(&a, big);
+
+    shm_arena_stats_t st;
+    shm_arena_get_stats(&a, &st);
+    TEST_CHECK(st.blocks == 0 && st.bytes_in_use == 0 && st.failures == 3);
+    destroy_arena(&a);
+}
+
+static void test_second_mapping(void) {
+    shm_arena_t a, b;
+    TEST_CHECK(create_arena(&a) == 0);
+    TEST_CHECK(shm_arena_create(&b, arena_name, ARENA_SIZE, ARENA_NODES) == -1);
+    TEST_CHECK(shm_arena_open(&b, arena_name) == 0);
+    TEST_CHECK(a.base != b.base);
+
+    /* A handle names the same bytes in both mappings */
+    shm_handle_t h = shm_alloc(&a, 32);
+    strcpy((char*)shm_ptr(&a, h), "zero-copy");
+    shm_set_root(&a, h);
+    TEST_CHECK(shm_get_root(&b) == h);
+    TEST_CHECK(strcmp((const char*)shm_ptr(&b, shm_get_root(&b)), "zero-copy") == 0);
+
+    /* Metadata is shared too: freeing through b makes the space reusable in a */
+    shm_free(&b, h);
+    TEST_CHECK(shm_alloc(&a, 32) == h);
+
+    shm_arena_close(&b);
+    destroy_arena(&a);
+}
+
+static void test_open_rejects(void) {
+    shm_arena_t a;
+    shm_arena_unlink(arena_name);
+    TEST_CHECK(shm_arena_open(&a, arena_name) == -1);
+    TEST_CHECK(shm_arena_create(&a, arena_name, 256u, ARENA_NODES) == -1);
+
+    /* An object that was never initialized as an arena */
+    int fd = shm_open(arena_name, O_CREAT | O_EXCL | O_RDWR, 0600);
+    TEST_CHECK(fd >= 0);
+    TEST_CHECK(ftruncate(fd, 4096) == 0);
+    close(fd);
+    TEST_CHECK(shm_arena_open(&a, arena_name) == -1);
+    shm_arena_unlink(arena_name);
+
+    /* A header whose node table runs past the data area (words 3 and 4 are
+     * max_blocks and data_start; 12-byte nodes, so the shift stays aligned) */
+    TEST_CHECK(create_arena(&a) == 0);
+    volatile uint32_t *w = (volatile uint32_t*)(void*)a.base;
+    w[3] += ARENA_SIZE / 4u;
+    w[4] += 3u * ARENA_SIZE;
+    shm_arena_t b;
+    TEST_CHECK(shm_arena_open(&b, arena_name) == -1);
+    destroy_arena(&a);
+}
+
+/* ---------------------------------------------------------------------------- */
+/*                              Producer / consumer                             */
+/* ---------------------------------------------------------------------------- */
+
+#define RING_SLOTS  32u
+#define MESSAGES    2000u
+
+/** Single-producer single-consumer ring of handles, stored in the arena. */
+typedef struct {
+    _Atomic uint32_t head;
+    _Atomic uint32_t tail;
+    shm_handle_t slot[RING_SLOTS];
+} ring_t;
+
+/** Message buffer: header followed by a payload of @c len bytes. */
+typedef struct {
+    uint32_t seq;
+    uint32_t len;
+    uint8_t payload[];
+} msg_t;
+
+static uint32_t msg_len(uint32_t seq) {
+    return 8u + (seq * 37u) % 400u;
+}
+
+/** Child: opens the arena by name and sends MESSAGES buffers. */
+static int producer(void) {
+    shm_arena_t a;
+    if (shm_arena_open(&a, arena_name) != 0) return 1;
+    ring_t *ring = (ring_t*)shm_ptr(&a, shm_get_root(&a));
+
+    for (uint32_t seq = 0; seq < MESSAGES; ++seq) {
+        uint32_t len = msg_len(seq);
+        shm_handle_t h;
+        while ((h = shm_alloc(&a, (uint32_t)sizeof(msg_t) + len)) == 0) sched_yield();
+        msg_t *m = (msg_t*)shm_ptr(&a, h);
+        m->seq = seq;
+        m->len = len;
+        memset(m->payload, (int)(seq & 0xFFu), len);
+
+        uint32_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+        while (head - atomic_load_explicit(&ring->tail, memory_order_acquire) == RING_SLOTS) {
+            sched_yield();
+        }
+        ring->slot[head % RING_SLOTS] = h;
+        atomic_store_explicit(&ring->head, head + 1u, memory_order_release);
+    }
+    shm_arena_close(&a);
+    return 0;
+}
+
+static void test_producer_consumer(void) {
+    shm_arena_t a;
+    TEST_CHECK(create_arena(&a) == 0);
+    shm_handle_t rh = shm_alloc(&a, (uint32_t)sizeof(ring_t));
+    ring_t *ring = (ring_t*)shm_ptr(&a, rh);
+    atomic_init(&ring->head, 0u);
+    atomic_init(&ring->tail, 0u);
+    shm_set_root(&a, rh);
+
+    fflush(stdout);
+    pid_t pid = fork();
+    TEST_CHECK(pid >= 0);
+    if (pid == 0) _exit(producer());
+
+    /* Consumer: read in place, free; also allocate scratch blocks so that
+     * both processes contend for the arena lock. */
+    uint32_t bad = 0;
+    for (uint32_t seq = 0; seq < MESSAGES; ++seq) {
+        uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+        while (atomic_load_explicit(&ring->head, memory_order_acquire) == tail) sched_yield();
+        shm_handle_t h = ring->slot[tail % RING_SLOTS];
+        atomic_store_explicit(&ring->tail, tail + 1u, memory_order_release);
+
+        const msg_t *m = (const msg_t*)shm_ptr(&a, h);
+        if (m->seq != seq || m->len != msg_len(seq) ||
+            m->payload[0] != (uint8_t)(seq & 0xFFu) ||
+            m->payload[m->len - 1u] != (uint8_t)(seq & 0xFFu)) {
+            ++bad;
+        }
+        shm_handle_t scratch = shm_alloc(&a, 100);
+        shm_free(&a, h);
+        shm_free(&a, scratch);
+    }
+    TEST_CHECK(bad == 0);
+
+    int status = 0;
+    TEST_CHECK(waitpid(pid, &status, 0) == pid);
+    TEST_CHECK(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+
+    /* Only the ring is left */
+    shm_arena_stats_t st;
+    shm_arena_get_stats(&a, &st);
+    TEST_CHECK(st.blocks == 1);
+    TEST_CHECK(st.allocs == 2u * MESSAGES + 1u);
+    TEST_CHECK(st.frees == 2u * MESSAGES);
+    destroy_arena(&a);
+}
+
+int main(void) {
+    snprintf(arena_name, sizeof arena_name, "/allocator_test_shm_%ld", (long)getpid());
+
+    TEST_RUN(test_alloc_free);
+    TEST_RUN(test_exhaustion);
+    TEST_RUN(test_second_mapping);
+    TEST_RUN(test_open_rejects);
+    TEST_RUN(test_producer_consumer);
+    return TEST_EXIT();
+}
@@ -0,0 +1,78 @@
+/**
+ * @file test_sites.c
+ * @brief Tests of call-site lifetime learning.
+ *
+ * Built with ALLOCATOR_SITE_LIFETIMES=1. Each helper below is one call site
+ * of allocate(); they are kept out of line so that their return addresses
+ * differ.
+ */
+
+#include <stdint.h>
+#include "allocator.h"
+#include "test_common.h"
+
+#define BLOCK 64
+
+/* Touched after each call so that allocate() is not a tail call, and
+ * different in each helper so that they are not merged. */
+static volatile uint32_t packets, configs;
+
+ALLOCATOR_SLOW_PATH static int *alloc_packet(void) {
+    int *p = allocate(BLOCK);
+    ++packets;
+    return p;
+}
+
+ALLOCATOR_SLOW_PATH static int *alloc_config(void) {
+    int *p = allocate(BLOCK);
+    ++configs;
+    return p;
+}
+
+static void test_short_site_learned(void) {
+    uint8_t *end = allocator_pool_base + ALLOCATOR_TOTAL_MEMORY;
+    allocator_site_stats_t st;
+    int *config[8];
+
+    for (int i = 0; i < 8; ++i) config[i] = alloc_config();
+    for (int i = 0; i < 8; ++i) TEST_CHECK(i == 0 || config[i] == config[i - 1] + BLOCK / 4);
+
+    /* Not learned yet: packets follow the configuration blocks */
+    int *first = alloc_packet();
+    TEST_CHECK(first == config[7] + BLOCK / 4);
+    deallocate(first);
+
+    /* Packets are freed right away; after enough samples they move up */
+    for (int i = 0; i < 64; ++i) deallocate(alloc_packet());
+    allocator_get_site_stats(&st);
+    TEST_CHECK(st.sites == 2 && st.short_sites == 1);
+    TEST_CHECK(st.measured >= ALLOCATOR_SITE_MIN_SAMPLES && st.routed != 0);
+
+    int *packet = alloc_packet();
+    TEST_CHECK((uint8_t*)packet == end - BLOCK);
+    int *more = alloc_config();
+    TEST_CHECK(more == config[7] + BLOCK / 4);
+
+    /* Forgetting the sites restores first fit */
+    allocator_reset_sites();
+    allocator_get_site_stats(&st);
+    TEST_CHECK(st.sites == 0 && st.measured == 0 && st.routed == 0);
+    int *fresh = alloc_packet();
+    TEST_CHECK(fresh == more + BLOCK / 4);
+
+    deallocate(fresh);
+    deallocate(packet);
+    deallocate(more);
+    for (int i = 0; i < 8; ++i) deallocate(config[i]);
+}
+
+static void test_unknown_site(void) {
+    TEST_CHECK(allocator_site_lifetime(NULL) == UINT32_MAX);
+    TEST_CHECK(allocator_site_lifetime((const void*)(uintptr_t)0x1234u) == UINT32_MAX);
+}
+
+int main(void) {
+    TEST_RUN(test_short_site_learned);
+    TEST_RUN(test_unknown_site);
+    return TEST_EXIT();
+}
@@ -0,0 +1,211 @@
+/**
+ * @file test_snapshot.c
+ * @brief Tests of allocator snapshots and warm restart.
+ *
+ * Without arguments the in-process cases run. With "save <file>" or
+ * "load <file>" the executable writes or checks a file image; CTest runs the
+ * two in separate processes, so on hosts with address randomization the pool
+ * is restored at a different address and the free lists are relocated.
+ */
+
+#include <stdint.h>
+#include <string.h>
+#include "allocator.h"
+#include "allocator_snapshot.h"
+#include "test_common.h"
+
+/** Application object linked through relative references. */
+typedef struct {
+    allocator_rel_t next;
+    uint32_t id;
+    uint8_t payload[40];
+} item_t;
+
+#define ITEMS 50
+
+/** Image buffer for the in-memory cases. */
+static uint8_t image[sizeof(uint8_t) * (ALLOCATOR_TOTAL_MEMORY + 4096u)];
+
+/** Builds a list of items (mixing both allocation paths) and sets it as root. */
+static void build_heap(void) {
+    int *scratch[ITEMS];
+    allocator_rel_t head = 0;
+    for (uint32_t i = 0; i < ITEMS; ++i) {
+        /* Interleave short-lived blocks so that free lists and gaps exist */
+        scratch[i] = (i % 2) ? allocate_fast(24) : allocate(300);
+        item_t *it = (i % 3) ? (item_t*)(void*)allocate_fast((int)sizeof(item_t))
+                             : (item_t*)(void*)allocate((int)sizeof(item_t));
+        it->next = head;
+        it->id = i;
+        memset(it->payload, (int)(i & 0xFFu), sizeof it->payload);
+        head = allocator_ptr_to_rel(it);
+    }
+    for (uint32_t i = 0; i < ITEMS; ++i) deallocate_fast(scratch[i]);
+    allocator_set_root(head);
+}
+
+/** Checks the list reachable from the root; frees it if @p release is set. */
+static int check_heap(int release) {
+    int bad = 0;
+    uint32_t count = 0;
+    allocator_rel_t r = allocator_get_root();
+    uint32_t expected = ITEMS;
+    while (r != 0) {
+        item_t *it = (item_t*)allocator_rel_to_ptr(r);
+        --expected;
+        if (it->id != expected || it->payload[0] != (uint8_t)(expected & 0xFFu) ||
+            it->payload[sizeof it->payload - 1u] != (uint8_t)(expected & 0xFFu)) {
+            ++bad;
+        }
+        r = it->next;
+        ++count;
+        if (release) deallocate_fast((int*)(void*)it);
+    }
+    if (release) allocator_set_root(0);
+    return bad == 0 && count == ITEMS;
+}
+
+/** The free lists work: take a handful of small blocks and give them back. */
+static int free_lists_usable(void) {
+    int *p[64];
+    int ok = 1;
+    for (int i = 0; i < 64; ++i) {
+        p[i] = allocate_fast(24);
+        if (!p[i]) ok = 0;
+        else memset(p[i], 0x5A, 24);
+    }
+    for (int i = 0; i < 64; ++i) deallocate_fast(p[i]);
+    return ok;
+}
+
+static void test_buffer_round_trip(void) {
+    TEST_CHECK(sizeof image >= allocator_snapshot_size());
+    build_heap();
+    TEST_CHECK(allocator_snapshot_save(image, sizeof image) == allocator_snapshot_size());
+    TEST_CHECK(allocator_snapshot_save(image, 16) == 0);
+
+    /* Throw the heap away and dirty the pool */
+    TEST_CHECK(check_heap(1));
+    int *junk = allocate(20000);
+    TEST_CHECK(junk != NULL);
+    memset(junk, 0xEE, 20000);
+
+    TEST_CHECK(allocator_snapshot_restore(image, allocator_snapshot_size()) == 0);
+    TEST_CHECK(check_heap(0));
+    TEST_CHECK(free_lists_usable());
+    TEST_CHECK(check_heap(1));
+    TEST_CHECK(pool_is_free());
+}
+
+static void test_rejects_bad_images(void) {
+    int *keep = allocate(128);
+    TEST_CHECK(allocator_snapshot_save(image, sizeof image) != 0);
+    deallocate(keep);
+
+    /* Corrupt metadata: rejected, current state untouched */
+    int *live = allocate(64);
+    image[20] ^= 0xFFu;
+    TEST_CHECK(allocator_snapshot_restore(image, sizeof image) == -1);
+    image[20] ^= 0xFFu;
+    TEST_CHECK(allocator_snapshot_restore(image, 8) == -1);
+    deallocate(live);
+    TEST_CHECK(pool_is_free());
+
+    /* Truncated pool: the allocator is emptied */
+    keep = allocate(128);
+    TEST_CHECK(allocator_snapshot_restore(image, allocator_snapshot_size() - 1u) == -1);
+    TEST_CHECK(pool_is_free());
+    (void)keep;
+}
+
+static void test_warm_boot(void) {
+    build_heap();
+    allocator_retain();
+
+    /* "Reset": adopt the retained metadata, pool contents stay in place */
+    TEST_CHECK(allocator_warm_boot() == 1);
+    TEST_CHECK(check_heap(0));
+    TEST_CHECK(free_lists_usable());
+
+    /* The record is consumed: the next boot is cold */
+    TEST_CHECK(allocator_warm_boot() == 0);
+    TEST_CHECK(allocator_get_root() == 0);
+    TEST_CHECK(pool_is_free());
+}
+
+static void test_change_after_retain(void) {
+    /* A free after the checkpoint drops the record: the heap it describes
+     * no longer exists, so adopting it would hand out live blocks */
+    int *a = allocate(100);
+    int *b = allocate(200);
+    allocator_retain();
+    deallocate(a);
+    TEST_CHECK(allocator_warm_boot() == 0);
+    int *c = allocate(64);
+    TEST_CHECK(c != NULL && c != (int*)(void*)allocator_pool_base);
+    deallocate(c);
+    TEST_CHECK(pool_is_free());
+    (void)b;
+
+    /* So do the fast paths and a new root */
+    int *s = allocate_fast(24);
+    allocator_retain();
+    deallocate_fast(s);
+    TEST_CHECK(allocator_warm_boot() == 0);
+
+    allocator_retain();
+    TEST_CHECK(allocate_fast(24) != NULL);
+    TEST_CHECK(allocator_warm_boot() == 0);
+
+    allocator_retain();
+    allocator_set_root(1);
+    TEST_CHECK(allocator_warm_boot() == 0);
+    TEST_CHECK(allocator_get_root() == 0);
+    TEST_CHECK(pool_is_free());
+}
+
+static void test_rejects_bad_pool(void) {
+    /* The metadata checks out but the block list in the pool is garbage */
+    build_heap();
+    size_t meta = allocator_snapshot_size() - ALLOCATOR_TOTAL_MEMORY;
+    TEST_CHECK(allocator_snapshot_save(image, sizeof image) != 0);
+    TEST_CHECK(check_heap(1));
+    TEST_CHECK(pool_is_free());
+
+    uint8_t saved[64];
+    memcpy(saved, image + meta, sizeof saved);
+    memset(image + meta, 0xA5, sizeof saved);
+    TEST_CHECK(allocator_snapshot_restore(image, allocator_snapshot_size()) == -1);
+    TEST_CHECK(pool_is_free());
+
+    /* Same for a retained record whose pool was overwritten */
+    memcpy(image + meta, saved, sizeof saved);
+    TEST_CHECK(allocator_snapshot_restore(image, allocator_snapshot_size()) == 0);
+    allocator_retain();
+    memset(allocator_pool_base, 0xA5, sizeof saved);
+    TEST_CHECK(allocator_warm_boot() == 0);
+    TEST_CHECK(pool_is_free());
+}
+
+int main(int argc, char **argv) {
+    if (argc == 3 && strcmp(argv[1], "save") == 0) {
+        build_heap();
+        TEST_CHECK(allocator_snapshot_save_file(argv[2]) == 0);
+        return TEST_EXIT();
+    }
+    if (argc == 3 && strcmp(argv[1], "load") == 0) {
+        TEST_CHECK(allocator_snapshot_load_file(argv[2]) == 0);
+        TEST_CHECK(check_heap(0));
+        TEST_CHECK(free_lists_usable());
+        TEST_CHECK(check_heap(1));
+        TEST_CHECK(pool_is_free());
+        return TEST_EXIT();
+    }
+
+    TEST_RUN(test_buffer_round_trip);
+    TEST_RUN(test_rejects_bad_images);
+    TEST_RUN(test_warm_boot);
+    TEST_RUN(test_change_after_retain);
+    TEST_RUN(test_rejects_bad_pool);
+    return TEST_EXIT();
+}
@@ -0,0 +1,159 @@
+/**
+ * @file test_tcache.c
+ * @brief Tests of the per-thread caches and their remote-free queues.
+ *
+ * Cross-thread frees are simulated from one thread by using two caches; the
+ * concurrent case is covered by test_lock_pthread.
+ */
+
+#include <stdint.h>
+#include "allocator.h"
+#include "allocator_tcache.h"
+#include "test_common.h"
+
+#define BLOCK   64
+#define PER_SLAB (ALLOCATOR_SLAB_BYTES / BLOCK)
+
+static uint32_t slab_of(const void *p) {
+    return (uint32_t)(((const uint8_t*)p - allocator_pool_base) >> ALLOCATOR_SLAB_SHIFT);
+}
+
+static void test_local_reuse(void) {
+    allocator_tcache_t tc;
+    TEST_CHECK(tcache_init(&tc) == 0);
+
+    int *p = tcache_alloc(&tc, BLOCK);
+    TEST_CHECK(p != NULL);
+    TEST_CHECK(atomic_load(&allocator_slab_owner[slab_of(p)]) == tc.owner);
+    tcache_free(&tc, p);
+    TEST_CHECK(tcache_alloc(&tc, BLOCK) == p);
+    tcache_free(&tc, p);
+
+    tcache_destroy(&tc);
+    TEST_CHECK(pool_is_free());
+}
+
+static void test_remote_free_is_queued(void) {
+    allocator_tcache_t a, b;
+    TEST_CHECK(tcache_init(&a) == 0);
+    TEST_CHECK(tcache_init(&b) == 0);
+    TEST_CHECK(a.owner != b.owner);
+
+    int *p = tcache_alloc(&a, BLOCK);
+    tcache_free(&b, p);
+    TEST_CHECK(b.remote_sent == 1);
+    TEST_CHECK(b.free[allocator_size_class(BLOCK)] == NULL);
+
+    TEST_CHECK(tcache_collect(&a) == 1);
+    TEST_CHECK(a.remote_received == 1);
+    TEST_CHECK(tcache_collect(&a) == 0);
+    TEST_CHECK(tcache_alloc(&a, BLOCK) == p);
+    tcache_free(&a, p);
+
+    tcache_destroy(&b);
+    tcache_destroy(&a);
+    TEST_CHECK(pool_is_free());
+}
+
+static void test_refill_collects_before_carving(void) {
+    allocator_tcache_t a, b;
+    int *blocks[PER_SLAB];
+    TEST_CHECK(tcache_init(&a) == 0);
+    TEST_CHECK(tcache_init(&b) == 0);
+
+    /* Empty one slab, then free all of it from the other cache */
+    for (uint32_t i = 0; i < PER_SLAB; ++i) blocks[i] = tcache_alloc(&a, BLOCK);
+    uint32_t slab = slab_of(blocks[0]);
+    for (uint32_t i = 0; i < PER_SLAB; ++i) {
+        TEST_CHECK(slab_of(blocks[i]) == slab);
+        tcache_free(&b, blocks[i]);
+    }
+
+    /* The miss takes the whole queue in one batch instead of a new slab */
+    int *p = tcache_alloc(&a, BLOCK);
+    TEST_CHECK(slab_of(p) == slab);
+    TEST_CHECK(a.collects == 1);
+    TEST_CHECK(a.remote_received == PER_SLAB);
+    tcache_free(&a, p);
+
+    tcache_destroy(&b);
+    tcache_destroy(&a);
+    TEST_CHECK(pool_is_free());
+}
+
+static void test_mixed_sources(void) {
+    allocator_tcache_t tc;
+    TEST_CHECK(tcache_init(&tc) == 0);
+
+    int *big    = tcache_alloc(&tc, 2000);          /* above the size classes */
+    int *shared = allocate_fast(BLOCK);             /* shared slab */
+    int *own    = tcache_alloc(&tc, BLOCK);
+    TEST_CHECK(big && shared && own);
+    TEST_CHECK(atomic_load(&allocator_slab_owner[slab_of(shared)]) == 0);
+
+    tcache_free(&tc, big);
+    tcache_free(&tc, shared);
+    deallocate(own);                                 /* goes to the shared list */
+    tcache_free(&tc, NULL);
+
+    tcache_destroy(&tc);
+    TEST_CHECK(pool_is_free());
+}
+
+static void test_caches_do_not_share_lines(void) {
+    allocator_tcache_t a, b;
+    TEST_CHECK(tcache_init(&a) == 0);
+    TEST_CHECK(tcache_init(&b) == 0);
+
+    /* Small objects of different threads come from different slabs */
+    int *pa = tcache_alloc(&a, 16);
+    int *pb = tcache_alloc(&b, 16);
+    TEST_CHECK(pa && pb);
+    TEST_CHECK(slab_of(pa) != slab_of(pb));
+    TEST_CHECK((uintptr_t)pa / ALLOCATOR_CACHE_LINE != (uintptr_t)pb / ALLOCATOR_CACHE_LINE);
+    tcache_free(&a, pa);
+    tcache_free(&b, pb);
+
+    tcache_destroy(&b);
+    tcache_destroy(&a);
+    TEST_CHECK(pool_is_free());
+}
+
+static void test_registry_limit(void) {
+    allocator_tcache_t tcs[ALLOCATOR_TCACHE_MAX + 1u];
+    for (uint32_t i = 0; i < ALLOCATOR_TCACHE_MAX; ++i) TEST_CHECK(tcache_init(&tcs[i]) == 0);
+    TEST_CHECK(tcache_init(&tcs[ALLOCATOR_TCACHE_MAX]) == -1);
+
+    tcache_destroy(&tcs[0]);
+    TEST_CHECK(tcache_init(&tcs[ALLOCATOR_TCACHE_MAX]) == 0);
+    tcache_destroy(&tcs[ALLOCATOR_TCACHE_MAX]);
+    for (uint32_t i = 1; i < ALLOCATOR_TCACHE_MAX; ++i) tcache_destroy(&tcs[i]);
+}
+
+static void test_destroy_keeps_live_blocks(void) {
+    allocator_tcache_t a, b;
+    TEST_CHECK(tcache_init(&a) == 0);
+    TEST_CHECK(tcache_init(&b) == 0);
+
+    int *p = tcache_alloc(&a, BLOCK);
+    tcache_destroy(&a);
+    TEST_CHECK(atomic_load(&allocator_slab_owner[slab_of(p)]) == 0);
+
+    /* The orphaned block is freed to the shared lists, not a dead queue */
+    tcache_free(&b, p);
+    TEST_CHECK(b.remote_sent == 0);
+
+    tcache_destroy(&b);
+    TEST_CHECK(pool_is_free());
+}
+
+int main(void) {
+    TEST_RUN(test_local_reuse);
+    TEST_RUN(test_remote_free_is_queued);
+    TEST_RUN(test_refill_collects_before_carving);
+    TEST_RUN(test_mixed_sources);
+    TEST_RUN(test_caches_do_not_share_lines);
+    TEST_RUN(test_registry_limit);
+    TEST_RUN(test_destroy_keeps_live_blocks);
+    return TEST_EXIT();
+}
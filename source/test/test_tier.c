@@ -0,0 +1,97 @@
+/**
+ * @file test_tier.c
+ * @brief Tests of hot/cold placement across the fast tier and the main pool.
+ *
+ * Built with a small fast tier (ALLOCATOR_FAST_MEMORY) so that spilling is
+ * easy to provoke.
+ */
+
+#include <stdint.h>
+#include "allocator.h"
+#include "test_common.h"
+
+#define HOT_SIZE 256
+
+static int in_fast(const void *p) {
+    return (allocator_region_attrs(p) & ALLOCATOR_REGION_FAST) != 0;
+}
+
+static void test_hot_spills_when_full(void) {
+    enum { N = ALLOCATOR_FAST_MEMORY / HOT_SIZE + 4 };
+    int *p[N];
+    allocator_reset_tier_stats();
+
+    for (int i = 0; i < N; ++i) {
+        p[i] = allocate_tier(HOT_SIZE, ALLOCATOR_TIER_HOT);
+        TEST_CHECK(p[i] != NULL);
+    }
+    /* The fast tier fills first, the rest spills to the main pool */
+    for (int i = 0; i < N - 4; ++i) TEST_CHECK(in_fast(p[i]));
+    for (int i = N - 4; i < N; ++i) TEST_CHECK(!in_fast(p[i]));
+
+    allocator_tier_stats_t st;
+    allocator_get_tier_stats(&st);
+    TEST_CHECK(st.hot_requests == N);
+    TEST_CHECK(st.hot_fast == N - 4 && st.hot_spilled == 4);
+    TEST_CHECK(st.fast_used == ALLOCATOR_FAST_MEMORY);
+
+    /* Freeing a fast block makes room for the next hot one */
+    deallocate(p[3]);
+    int *again = allocate_tier(HOT_SIZE, ALLOCATOR_TIER_HOT);
+    TEST_CHECK(again == p[3]);
+    p[3] = again;
+
+    for (int i = 0; i < N; ++i) deallocate(p[i]);
+    allocator_get_tier_stats(&st);
+    TEST_CHECK(st.fast_used == 0);
+}
+
+static void test_cold_uses_pool(void) {
+    allocator_reset_tier_stats();
+    int *c = allocate_tier(HOT_SIZE, ALLOCATOR_TIER_COLD);
+    TEST_CHECK(c != NULL && !in_fast(c));
+    TEST_CHECK(allocator_region_attrs(c) == ALLOCATOR_POOL_ATTRS);
+
+    /* Too large for the fast tier: served by the pool */
+    int *big = allocate_tier((int)ALLOCATOR_FAST_MEMORY * 2, ALLOCATOR_TIER_HOT);
+    TEST_CHECK(big != NULL && !in_fast(big));
+
+    /* With the pool exhausted, cold blocks fall back to the fast tier */
+    deallocate(c);
+    deallocate(big);
+    allocator_trim();
+    int *all = allocate((int)ALLOCATOR_TOTAL_MEMORY);
+    TEST_CHECK(all != NULL);
+    int *cold = allocate_tier(64, ALLOCATOR_TIER_COLD);
+    TEST_CHECK(cold != NULL && in_fast(cold));
+
+    allocator_tier_stats_t st;
+    allocator_get_tier_stats(&st);
+    TEST_CHECK(st.cold_requests == 2 && st.cold_fast == 1);
+    TEST_CHECK(st.hot_requests == 1 && st.hot_spilled == 1);
+
+    deallocate(cold);
+    deallocate(all);
+    TEST_CHECK(allocate_tier(0, ALLOCATOR_TIER_HOT) == NULL);
+}
+
+static void test_fast_flag(void) {
+    allocator_reset_tier_stats();
+    int *p = allocate_flags(100, ALLOCATOR_F_FAST | ALLOCATOR_F_CACHELINE);
+    TEST_CHECK(p != NULL && in_fast(p));
+    TEST_CHECK(((uintptr_t)p % ALLOCATOR_CACHE_LINE) == 0);
+
+    /* Never spills, and is not counted as a tier placement */
+    TEST_CHECK(allocate_flags((int)ALLOCATOR_FAST_MEMORY, ALLOCATOR_F_FAST) == NULL);
+    allocator_tier_stats_t st;
+    allocator_get_tier_stats(&st);
+    TEST_CHECK(st.hot_requests == 0 && st.fast_used == 128u);
+    deallocate(p);
+}
+
+int main(void) {
+    TEST_RUN(test_hot_spills_when_full);
+    TEST_RUN(test_cold_uses_pool);
+    TEST_RUN(test_fast_flag);
+    return TEST_EXIT();
+}